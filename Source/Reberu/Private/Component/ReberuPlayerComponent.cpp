@@ -0,0 +1,100 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Component/ReberuPlayerComponent.h"
+
+#include "Reberu.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+
+UReberuPlayerComponent::UReberuPlayerComponent(){
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UReberuPlayerComponent::BeginPlay(){
+	Super::BeginPlay();
+
+	// Generators that got their snapshot id before this player controller was ready are waiting for us
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if(!PlayerController || !PlayerController->IsLocalController()) return;
+
+	for (TActorIterator<ALevelGeneratorActor> It(GetWorld()); It; ++It){
+		It->RetryLayoutSnapshotRequest();
+	}
+}
+
+void UReberuPlayerComponent::ServerRequestLayoutSnapshot_Implementation(ALevelGeneratorActor* LevelGenerator){
+	if(!LevelGenerator) return;
+
+	// Drop whatever was left of an older snapshot of this generator
+	PendingChunks.RemoveAll([LevelGenerator](const FPendingLayoutChunk& PendingChunk){
+		return PendingChunk.LevelGenerator == LevelGenerator;
+	});
+
+	TArray<FReberuLayoutChunk> Chunks;
+	LevelGenerator->BuildLayoutSnapshot(GetSnapshotOrigin(), Chunks);
+
+	REBERU_LOG_ARGS(Log, "%s requested a layout snapshot of %s (%d chunks)", *GetNameSafe(GetOwner()), *LevelGenerator->GetName(), Chunks.Num())
+
+	for (FReberuLayoutChunk& Chunk : Chunks){
+		PendingChunks.Add({LevelGenerator, MoveTemp(Chunk)});
+	}
+	SetComponentTickEnabled(PendingChunks.Num() > 0);
+}
+
+void UReberuPlayerComponent::ClientReceiveLayoutChunk_Implementation(ALevelGeneratorActor* LevelGenerator, UReberuData* ReberuData, const FReberuLayoutChunk& Chunk){
+	if(!LevelGenerator) return;
+
+	LevelGenerator->ApplyLayoutChunk(ReberuData, Chunk);
+}
+
+void UReberuPlayerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction){
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// Spread the chunks over several ticks so the nearest rooms don't wait behind the whole layout
+	const int32 NumToSend = FMath::Min(ChunksPerTick, PendingChunks.Num());
+	for (int32 ChunkIdx = 0; ChunkIdx < NumToSend; ChunkIdx++){
+		const FPendingLayoutChunk& PendingChunk = PendingChunks[ChunkIdx];
+		if(ALevelGeneratorActor* LevelGenerator = PendingChunk.LevelGenerator.Get()){
+			ClientReceiveLayoutChunk(LevelGenerator, LevelGenerator->ActiveReberuData, PendingChunk.Chunk);
+		}
+	}
+	PendingChunks.RemoveAt(0, NumToSend);
+
+	if(PendingChunks.Num() == 0){
+		SetComponentTickEnabled(false);
+	}
+}
+
+FVector UReberuPlayerComponent::GetSnapshotOrigin() const{
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if(!PlayerController) return GetOwner() ? GetOwner()->GetActorLocation() : FVector::ZeroVector;
+
+	if(const APawn* Pawn = PlayerController->GetPawn()){
+		return Pawn->GetActorLocation();
+	}
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	return ViewLocation;
+}
+
+UReberuPlayerComponent* UReberuPlayerComponent::FindLocalPlayerComponent(const UObject* WorldContext){
+	const UWorld* World = WorldContext ? WorldContext->GetWorld() : nullptr;
+	if(!World) return nullptr;
+
+	for(FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It){
+		const APlayerController* PlayerController = It->Get();
+		if(PlayerController && PlayerController->IsLocalController()){
+			if(UReberuPlayerComponent* PlayerComponent = PlayerController->FindComponentByClass<UReberuPlayerComponent>()){
+				return PlayerComponent;
+			}
+		}
+	}
+	return nullptr;
+}
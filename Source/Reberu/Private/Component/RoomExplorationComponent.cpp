@@ -0,0 +1,75 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Component/RoomExplorationComponent.h"
+
+#include "LevelGeneratorActor.h"
+#include "Reberu.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+
+URoomExplorationComponent::URoomExplorationComponent(){
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void URoomExplorationComponent::BeginPlay(){
+	Super::BeginPlay();
+
+	SetComponentTickInterval(UpdateInterval);
+
+	if(!GetLevelGenerator()){
+		REBERU_LOG(Warning, "RoomExplorationComponent should be attached to a LevelGeneratorActor, disabling it.")
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	// Clients get the rooms through replication
+	if(!GetOwner()->HasAuthority()){
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	if(bStartOnBeginPlay){
+		StartExploration(GetOwner()->GetActorTransform());
+	}
+}
+
+ALevelGeneratorActor* URoomExplorationComponent::GetLevelGenerator() const{
+	return Cast<ALevelGeneratorActor>(GetOwner());
+}
+
+void URoomExplorationComponent::StartExploration(const FTransform StartTransform){
+	ALevelGeneratorActor* LevelGenerator = GetLevelGenerator();
+	if(!LevelGenerator || !LevelGenerator->HasAuthority()) return;
+
+	if(!ReberuData){
+		REBERU_LOG(Warning, "RoomExplorationComponent has no ReberuData to generate with.")
+		return;
+	}
+
+	LevelGenerator->ClearGeneration();
+	LevelGenerator->StartIncrementalGeneration(ReberuData, Seed > 0 ? Seed : FMath::RandRange(1, MAX_int32), StartTransform);
+}
+
+void URoomExplorationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction){
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ALevelGeneratorActor* LevelGenerator = GetLevelGenerator();
+	UWorld* World = GetWorld();
+	if(!LevelGenerator || !World || !LevelGenerator->IsGeneratingIncrementally()) return;
+
+	// The server goes over every player
+	TArray<FVector, TInlineAllocator<8>> PlayerLocations;
+	for(FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It){
+		const APlayerController* PlayerController = It->Get();
+		if(const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr){
+			PlayerLocations.Add(Pawn->GetActorLocation());
+		}
+	}
+
+	// Still called without players so the starting room gets placed once the rooms are loaded
+	LevelGenerator->ExpandIncrementalGeneration(PlayerLocations, FrontierDistance, MaxRoomsPerUpdate);
+	LevelGenerator->EvictIncrementalRooms(PlayerLocations, EvictionDistance);
+}
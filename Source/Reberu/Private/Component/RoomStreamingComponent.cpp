@@ -0,0 +1,205 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Component/RoomStreamingComponent.h"
+
+#include "LevelGeneratorActor.h"
+#include "Reberu.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+
+URoomStreamingComponent::URoomStreamingComponent(){
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+}
+
+void URoomStreamingComponent::BeginPlay(){
+	Super::BeginPlay();
+
+	SetComponentTickInterval(UpdateInterval);
+
+	if(!GetLevelGenerator()){
+		REBERU_LOG(Warning, "RoomStreamingComponent should be attached to a LevelGeneratorActor, disabling it.")
+		SetComponentTickEnabled(false);
+	}
+}
+
+ALevelGeneratorActor* URoomStreamingComponent::GetLevelGenerator() const{
+	return Cast<ALevelGeneratorActor>(GetOwner());
+}
+
+void URoomStreamingComponent::SetStreamingEnabled(const bool bEnabled){
+	if(bStreamingEnabled == bEnabled) return;
+
+	bStreamingEnabled = bEnabled;
+	bNeedsStreamingUpdate = true;
+	ForceUpdate();
+}
+
+void URoomStreamingComponent::ForceUpdate(){
+	ALevelGeneratorActor* LevelGenerator = GetLevelGenerator();
+	if(!LevelGenerator) return;
+
+	UpdateRoomGraph(LevelGenerator);
+	if(UpdateOccupiedRooms() || bNeedsStreamingUpdate){
+		UpdateStreamedRooms(LevelGenerator);
+	}
+}
+
+bool URoomStreamingComponent::IsRoomStreamedIn(const int32 RoomIdx) const{
+	return RoomBoundsTransforms.IsValidIndex(RoomIdx) && !StreamedOutRooms.Contains(RoomIdx);
+}
+
+void URoomStreamingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction){
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ForceUpdate();
+}
+
+void URoomStreamingComponent::UpdateRoomGraph(const ALevelGeneratorActor* LevelGenerator){
+	// A regenerated layout can have as many rooms as the previous one, so only the version tells whether the rooms changed
+	if(LevelGenerator->GetRoomLevelsVersion() == KnownRoomLevelsVersion) return;
+	KnownRoomLevelsVersion = LevelGenerator->GetRoomLevelsVersion();
+	const TArray<FRoomLevel>& RoomLevels = LevelGenerator->SpawnedRoomLevels.Items;
+
+	// Rooms can have been replaced by new level instances (which start streamed in) under the same index, so the streaming state
+	// is rebuilt from scratch. Rooms that should stay out are streamed out again by the next update.
+	OccupiedRooms.Reset();
+	StreamedOutRooms.Reset();
+
+	// Replicated rooms can arrive in any order, so the bounds are rebuilt by room index whenever rooms are added.
+	int32 NumRooms = 0;
+	for(const FRoomLevel& RoomLevel : RoomLevels){
+		NumRooms = FMath::Max(NumRooms, RoomLevel.RoomIdx + 1);
+	}
+	RoomBoundsTransforms.Init(FTransform::Identity, NumRooms);
+	RoomExtents.Init(FVector::ZeroVector, NumRooms);
+	for(auto It = PlayerRooms.CreateIterator(); It; ++It){
+		if(It.Value() >= NumRooms) It.RemoveCurrent();
+	}
+
+	for(const FRoomLevel& RoomLevel : RoomLevels){
+		const int32 RoomIdx = RoomLevel.RoomIdx;
+		if(!RoomBoundsTransforms.IsValidIndex(RoomIdx)) continue;
+
+		RoomBoundsTransforms[RoomIdx] = LevelGenerator->GetRoomBoundsTransform(RoomIdx);
+		RoomExtents[RoomIdx] = RoomLevel.InRoom ? RoomLevel.InRoom->Room.BoxExtent : FVector::ZeroVector;
+	}
+	bNeedsStreamingUpdate = true;
+}
+
+bool URoomStreamingComponent::IsLocationInRoom(const FVector& Location, const int32 RoomIdx) const{
+	if(!RoomBoundsTransforms.IsValidIndex(RoomIdx)) return false;
+
+	const FVector LocalLocation = RoomBoundsTransforms[RoomIdx].InverseTransformPositionNoScale(Location);
+	return FBox(-RoomExtents[RoomIdx], RoomExtents[RoomIdx]).IsInsideOrOn(LocalLocation);
+}
+
+int32 URoomStreamingComponent::FindRoomAtLocation(const FVector& Location, const int32 HintRoomIdx) const{
+	if(RoomBoundsTransforms.IsValidIndex(HintRoomIdx)){
+		if(IsLocationInRoom(Location, HintRoomIdx)) return HintRoomIdx;
+
+		if(const ALevelGeneratorActor* LevelGenerator = GetLevelGenerator()){
+			for(const FReberuRoomConnection& Connection : LevelGenerator->GetRoomGraph().GetConnections(HintRoomIdx)){
+				if(IsLocationInRoom(Location, Connection.RoomIdx)) return Connection.RoomIdx;
+			}
+		}
+	}
+
+	for(int32 RoomIdx = 0; RoomIdx < RoomBoundsTransforms.Num(); RoomIdx++){
+		if(IsLocationInRoom(Location, RoomIdx)) return RoomIdx;
+	}
+	return INDEX_NONE;
+}
+
+bool URoomStreamingComponent::UpdateOccupiedRooms(){
+	UWorld* World = GetWorld();
+	if(!World) return false;
+
+	TSet<int32> NewOccupiedRooms;
+	TMap<TWeakObjectPtr<AController>, int32> NewPlayerRooms;
+
+	// On the server this goes over every player, on clients only over the local ones.
+	for(FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It){
+		APlayerController* PlayerController = It->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if(!Pawn) continue;
+
+		const int32* PreviousRoom = PlayerRooms.Find(PlayerController);
+		const int32 HintRoomIdx = PreviousRoom ? *PreviousRoom : INDEX_NONE;
+		int32 RoomIdx = FindRoomAtLocation(Pawn->GetActorLocation(), HintRoomIdx);
+
+		// Players standing in a doorway might not be inside any box, so keep their last known room.
+		if(RoomIdx == INDEX_NONE){
+			RoomIdx = HintRoomIdx;
+		}
+		if(RoomIdx == INDEX_NONE) continue;
+
+		NewPlayerRooms.Add(PlayerController, RoomIdx);
+		NewOccupiedRooms.Add(RoomIdx);
+	}
+
+	PlayerRooms = MoveTemp(NewPlayerRooms);
+
+	if(NewOccupiedRooms.Num() == OccupiedRooms.Num() && NewOccupiedRooms.Includes(OccupiedRooms)){
+		return false;
+	}
+	OccupiedRooms = MoveTemp(NewOccupiedRooms);
+	return true;
+}
+
+void URoomStreamingComponent::UpdateStreamedRooms(ALevelGeneratorActor* LevelGenerator){
+	// Without any players in a room we keep the current state so we don't unload everything during respawns or before the players arrive.
+	if(bStreamingEnabled && OccupiedRooms.Num() == 0) return;
+	bNeedsStreamingUpdate = false;
+
+	const FReberuRoomGraph& RoomGraph = LevelGenerator->GetRoomGraph();
+	TArray<int32> HopDistances;
+	HopDistances.Init(INDEX_NONE, RoomBoundsTransforms.Num());
+
+	if(bStreamingEnabled){
+		// Multi source bfs from every occupied room, stopping at the max amount of hops
+		TArray<int32> Queue;
+		for(const int32 RoomIdx : OccupiedRooms){
+			HopDistances[RoomIdx] = 0;
+			Queue.Add(RoomIdx);
+		}
+		for(int32 QueueIdx = 0; QueueIdx < Queue.Num(); QueueIdx++){
+			const int32 RoomIdx = Queue[QueueIdx];
+			if(HopDistances[RoomIdx] >= StreamingHops) continue;
+
+			for(const FReberuRoomConnection& Connection : RoomGraph.GetConnections(RoomIdx)){
+				if(!HopDistances.IsValidIndex(Connection.RoomIdx) || HopDistances[Connection.RoomIdx] != INDEX_NONE) continue;
+				HopDistances[Connection.RoomIdx] = HopDistances[RoomIdx] + 1;
+				Queue.Add(Connection.RoomIdx);
+			}
+		}
+	}
+
+	for(int32 RoomIdx = 0; RoomIdx < RoomBoundsTransforms.Num(); RoomIdx++){
+		const bool bWantsStreamedIn = !bStreamingEnabled || HopDistances[RoomIdx] != INDEX_NONE;
+		const bool bIsStreamedIn = !StreamedOutRooms.Contains(RoomIdx);
+		if(bWantsStreamedIn == bIsStreamedIn) continue;
+
+		if(bWantsStreamedIn){
+			StreamedOutRooms.Remove(RoomIdx);
+		}
+		else{
+			StreamedOutRooms.Add(RoomIdx);
+		}
+		SetRoomStreamedIn(LevelGenerator, RoomIdx, bWantsStreamedIn);
+	}
+}
+
+void URoomStreamingComponent::SetRoomStreamedIn(ALevelGeneratorActor* LevelGenerator, const int32 RoomIdx, const bool bStreamedIn){
+	ULevelStreamingDynamic* RoomLevel = LevelGenerator->GetRoomLevelInstance(RoomIdx);
+	if(!RoomLevel) return;
+
+	REBERU_LOG_ARGS(Verbose, "Streaming %s room %d (%s)", bStreamedIn ? TEXT("in") : TEXT("out"), RoomIdx, *RoomLevel->GetWorldAssetPackageName())
+
+	// We keep the streaming level around (instead of requesting removal) so it can be streamed back in later.
+	RoomLevel->SetShouldBeLoaded(bStreamedIn);
+	RoomLevel->SetShouldBeVisible(bStreamedIn);
+}
@@ -0,0 +1,224 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Data/ReberuCatalog.h"
+
+#include "Reberu.h"
+#include "Data/ReberuData.h"
+#include "Data/ReberuRoomData.h"
+
+void FReberuRoomCatalog::Reset(){
+	Rooms.Reset();
+	RoomExtents.Reset();
+	RoomFirstDoor.Reset();
+	RoomNumDoors.Reset();
+	RoomFlags.Reset();
+	RoomWeights.Reset();
+	RoomAliasTable.Reset();
+	DoorTransforms.Reset();
+	DoorExtents.Reset();
+	DoorTagIdx.Reset();
+	DoorFlags.Reset();
+	DoorWeights.Reset();
+	Tags.Reset();
+	TagCompatibility.Reset();
+	ConstraintMin.Reset();
+	ConstraintMax.Reset();
+	ConstraintRooms.Reset();
+	ZoneRooms.Reset();
+	NumPlaceable = 0;
+	NumZoneKinds = 0;
+	bHasDataRules = false;
+	bCanGainOpenDoors = false;
+	bHasUnloadedRooms = false;
+	bIsBuilt = false;
+}
+
+void FReberuRoomCatalog::Build(const UReberuData* ReberuData){
+	Reset();
+	if(!ReberuData) return;
+
+	// Rooms that aren't loaded end up as empty rooms, see UReberuData::LoadGenerationData
+	Rooms.Reserve(ReberuData->ReberuRooms.Num() + 1);
+	for (const TSoftObjectPtr<UReberuRoomData>& ReberuRoom : ReberuData->ReberuRooms){
+		Rooms.Add(ReberuRoom.Get());
+		bHasUnloadedRooms |= !ReberuRoom.IsNull() && !Rooms.Last();
+	}
+	NumPlaceable = Rooms.Num();
+	bHasDataRules = ReberuData->Rules.Num() > 0;
+	if(!ReberuData->StartingRoom.IsNull() && !ReberuData->ReberuRooms.Contains(ReberuData->StartingRoom)){
+		Rooms.Add(ReberuData->StartingRoom.Get());
+		bHasUnloadedRooms |= !Rooms.Last();
+	}
+
+	int32 NumDoors = 0;
+	for (const UReberuRoomData* Room : Rooms){
+		NumDoors += Room ? Room->Room.ReberuDoors.Num() : 0;
+	}
+
+	RoomExtents.Reserve(Rooms.Num());
+	RoomFirstDoor.Reserve(Rooms.Num());
+	RoomNumDoors.Reserve(Rooms.Num());
+	RoomFlags.Reserve(Rooms.Num());
+	RoomWeights.Reserve(Rooms.Num());
+	DoorTransforms.Reserve(NumDoors);
+	DoorExtents.Reserve(NumDoors);
+	DoorTagIdx.Reserve(NumDoors);
+	DoorFlags.Reserve(NumDoors);
+	DoorWeights.Reserve(NumDoors);
+
+	// The empty tag is always index 0 so untagged doors match each other
+	Tags.Add(FGameplayTag::EmptyTag);
+
+	for (const UReberuRoomData* Room : Rooms){
+		RoomFirstDoor.Add(DoorTransforms.Num());
+		if(!Room){
+			REBERU_LOG_ARGS(Warning, "%s contains an empty room, it will never be placed.", *ReberuData->GetName())
+			RoomExtents.Add(FVector::ZeroVector);
+			RoomNumDoors.Add(0);
+			RoomFlags.Add(EReberuCatalogRoomFlags::None);
+			RoomWeights.Add(0.f);
+			continue;
+		}
+
+		RoomExtents.Add(Room->Room.BoxExtent);
+		RoomNumDoors.Add(IntCastChecked<uint16>(Room->Room.ReberuDoors.Num()));
+		EReberuCatalogRoomFlags Flags = EReberuCatalogRoomFlags::None;
+		if(Room->Room.bAllowSameRoomConnect) Flags |= EReberuCatalogRoomFlags::AllowSameRoomConnect;
+		if(Room->Rules.Num() > 0) Flags |= EReberuCatalogRoomFlags::HasRules;
+		RoomFlags.Add(Flags);
+		RoomWeights.Add(FMath::Max(Room->Weight, 0.f));
+
+		for (const FReberuDoor& Door : Room->Room.ReberuDoors){
+			DoorTransforms.Add(Door.DoorTransform);
+			DoorExtents.Add(Door.BoxExtent);
+			DoorTagIdx.Add(IntCastChecked<uint16>(Door.DoorTag.IsValid() ? Tags.AddUnique(Door.DoorTag) : 0));
+			DoorFlags.Add(Door.bOnlyConnectSameDoor ? EReberuCatalogDoorFlags::OnlyConnectSameDoor : EReberuCatalogDoorFlags::None);
+			DoorWeights.Add(FMath::Max(Door.Weight, 0.f));
+		}
+	}
+
+	BuildTagCompatibility(ReberuData->DoorMatching);
+	BuildConstraints(ReberuData);
+	BuildZones(ReberuData);
+	RoomAliasTable.Build(TConstArrayView<float>(RoomWeights.GetData(), NumPlaceable));
+
+	bIsBuilt = true;
+	REBERU_LOG_ARGS(Verbose, "Built catalog for %s with %d rooms, %d doors and %d door tags", *ReberuData->GetName(), Rooms.Num(), DoorTransforms.Num(), Tags.Num())
+}
+
+void FReberuRoomCatalog::BuildConstraints(const UReberuData* ReberuData){
+	for (int32 RoomIdx = 0; RoomIdx < NumPlaceable; RoomIdx++){
+		bCanGainOpenDoors |= RoomWeights[RoomIdx] > 0.f && RoomNumDoors[RoomIdx] > 2;
+	}
+
+	const int32 NumRooms = Rooms.Num();
+	ConstraintRooms.Init(false, ReberuData->RoomConstraints.Num() * NumRooms);
+	for (int32 ConstraintIdx = 0; ConstraintIdx < ReberuData->RoomConstraints.Num(); ConstraintIdx++){
+		const FReberuRoomConstraint& Constraint = ReberuData->RoomConstraints[ConstraintIdx];
+		ConstraintMin.Add(FMath::Max(Constraint.MinCount, 0));
+		ConstraintMax.Add(Constraint.MaxCount < 0 ? MAX_int32 : Constraint.MaxCount);
+
+		for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+			const UReberuRoomData* Room = Rooms[RoomIdx];
+			if(!Room) continue;
+
+			const bool bMatchesTag = Constraint.RoomTag.IsValid() && Room->Room.RoomTags.HasTag(Constraint.RoomTag);
+			const bool bMatchesRoom = !Constraint.Room.IsNull() && Constraint.Room == Room;
+			ConstraintRooms[ConstraintIdx * NumRooms + RoomIdx] = bMatchesTag || bMatchesRoom;
+		}
+	}
+}
+
+void FReberuRoomCatalog::BuildZones(const UReberuData* ReberuData){
+	const int32 NumRooms = Rooms.Num();
+	NumZoneKinds = ReberuData->Zones.Num();
+	ZoneRooms.Init(false, NumZoneKinds * NumRooms);
+	for (int32 ZoneIdx = 0; ZoneIdx < NumZoneKinds; ZoneIdx++){
+		const FGameplayTag& ZoneTag = ReberuData->Zones[ZoneIdx].RoomTag;
+		for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+			const UReberuRoomData* Room = Rooms[RoomIdx];
+			ZoneRooms[ZoneIdx * NumRooms + RoomIdx] = Room && (!ZoneTag.IsValid() || Room->Room.RoomTags.HasTag(ZoneTag));
+		}
+	}
+}
+
+int32 FReberuRoomCatalog::GetTagIndex(const FGameplayTag& Tag) const{
+	return Tag.IsValid() ? Tags.IndexOfByKey(Tag) : 0;
+}
+
+void FReberuRoomCatalog::BuildTagCompatibility(const EReberuDoorMatching DoorMatching){
+	const int32 NumTags = Tags.Num();
+	TagCompatibility.Init(false, NumTags * NumTags);
+
+	for (int32 TagIdxA = 0; TagIdxA < NumTags; TagIdxA++){
+		for (int32 TagIdxB = 0; TagIdxB < NumTags; TagIdxB++){
+			// Untagged doors (index 0) only match each other, same as exact tags
+			bool bCompatible = TagIdxA == TagIdxB;
+			if(!bCompatible && TagIdxA != 0 && TagIdxB != 0 && DoorMatching == EReberuDoorMatching::Hierarchical){
+				bCompatible = Tags[TagIdxA].MatchesTag(Tags[TagIdxB]) || Tags[TagIdxB].MatchesTag(Tags[TagIdxA]);
+			}
+			TagCompatibility[TagIdxA * NumTags + TagIdxB] = bCompatible;
+		}
+	}
+}
+
+void FReberuAliasTable::Reset(){
+	Probabilities.Reset();
+	Aliases.Reset();
+	TotalWeight = 0.f;
+}
+
+void FReberuAliasTable::Build(TConstArrayView<float> Weights){
+	Reset();
+
+	const int32 NumWeights = Weights.Num();
+	for (const float Weight : Weights){
+		TotalWeight += FMath::Max(Weight, 0.f);
+	}
+	if(NumWeights == 0 || TotalWeight <= 0.f){
+		TotalWeight = 0.f;
+		return;
+	}
+
+	Probabilities.SetNumUninitialized(NumWeights);
+	Aliases.SetNumUninitialized(NumWeights);
+
+	// Scale the weights so the average is 1, then pair every entry under 1 with one over 1 to fill its column.
+	TArray<float> ScaledWeights;
+	ScaledWeights.SetNumUninitialized(NumWeights);
+	TArray<int32> Small;
+	TArray<int32> Large;
+	for (int32 Idx = 0; Idx < NumWeights; Idx++){
+		ScaledWeights[Idx] = FMath::Max(Weights[Idx], 0.f) * NumWeights / TotalWeight;
+		(ScaledWeights[Idx] < 1.f ? Small : Large).Add(Idx);
+	}
+
+	while (Small.Num() > 0 && Large.Num() > 0){
+		const int32 SmallIdx = Small.Pop(EAllowShrinking::No);
+		const int32 LargeIdx = Large.Pop(EAllowShrinking::No);
+
+		Probabilities[SmallIdx] = ScaledWeights[SmallIdx];
+		Aliases[SmallIdx] = LargeIdx;
+
+		ScaledWeights[LargeIdx] = ScaledWeights[LargeIdx] + ScaledWeights[SmallIdx] - 1.f;
+		(ScaledWeights[LargeIdx] < 1.f ? Small : Large).Add(LargeIdx);
+	}
+
+	// Whatever is left is 1 up to floating point errors
+	for (const int32 Idx : Large){
+		Probabilities[Idx] = 1.f;
+		Aliases[Idx] = Idx;
+	}
+	for (const int32 Idx : Small){
+		Probabilities[Idx] = 1.f;
+		Aliases[Idx] = Idx;
+	}
+}
+
+int32 FReberuAliasTable::Sample(FRandomStream& RandomStream) const{
+	if(Probabilities.Num() == 0) return INDEX_NONE;
+
+	const int32 Idx = RandomStream.RandRange(0, Probabilities.Num() - 1);
+	return RandomStream.GetFraction() < Probabilities[Idx] ? Idx : Aliases[Idx];
+}
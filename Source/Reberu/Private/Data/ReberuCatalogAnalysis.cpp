@@ -0,0 +1,262 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Data/ReberuCatalogAnalysis.h"
+
+#include "Data/ReberuCatalog.h"
+#include "Data/ReberuData.h"
+#include "Data/ReberuRoomData.h"
+
+#define LOCTEXT_NAMESPACE "ReberuCatalogAnalysis"
+
+void FReberuCatalogAnalysis::Reset(){
+	ReachableRooms.Reset();
+	TagAnalysis.Reset();
+	BranchingFactor = 0.f;
+	MaxRooms = INDEX_NONE;
+	Errors.Reset();
+	Warnings.Reset();
+	bIsAnalyzed = false;
+}
+
+void FReberuCatalogAnalysis::Analyze(const UReberuData* ReberuData, const FReberuRoomCatalog& Catalog){
+	Reset();
+	if(!ReberuData) return;
+
+	const int32 NumRooms = Catalog.NumRooms();
+	const int32 NumTags = Catalog.Tags.Num();
+	const FText DataName = FText::FromString(ReberuData->GetName());
+	auto GetRoomName = [&Catalog](const int32 RoomIdx){
+		return FText::FromName(Catalog.Rooms[RoomIdx] ? Catalog.Rooms[RoomIdx]->RoomName : NAME_None);
+	};
+	auto GetTagName = [&Catalog](const int32 TagIdx){
+		return TagIdx == 0 ? LOCTEXT("Untagged", "untagged") : FText::FromName(Catalog.Tags[TagIdx].GetTagName());
+	};
+
+	// Doors connect the same way if they have the same tag and bOnlyConnectSameDoor, so doors are only counted per group of both.
+	// A group is the tag index * 2, + 1 if it only connects to the same door.
+	const int32 NumGroups = NumTags * 2;
+	auto GetGroup = [&Catalog](const int32 DoorIdx){
+		return Catalog.DoorTagIdx[DoorIdx] * 2 + (EnumHasAnyFlags(Catalog.DoorFlags[DoorIdx], EReberuCatalogDoorFlags::OnlyConnectSameDoor) ? 1 : 0);
+	};
+	auto AreGroupsCompatible = [&Catalog](const int32 GroupA, const int32 GroupB){
+		return !((GroupA | GroupB) & 1) || Catalog.AreTagsCompatible(GroupA >> 1, GroupB >> 1);
+	};
+	// Same filter as the target rooms of ChooseNextMove
+	auto CanBeTarget = [&Catalog](const int32 RoomIdx){
+		return RoomIdx < Catalog.NumPlaceableRooms() && Catalog.RoomWeights[RoomIdx] > 0.f && Catalog.RoomNumDoors[RoomIdx] > 0;
+	};
+
+	TArray<int32> RoomGroupCounts;
+	RoomGroupCounts.Init(0, NumRooms * NumGroups);
+	for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+		for (int32 RoomDoorIdx = 0; RoomDoorIdx < Catalog.RoomNumDoors[RoomIdx]; RoomDoorIdx++){
+			const int32 DoorIdx = Catalog.GetDoorIndex(RoomIdx, RoomDoorIdx);
+			if(Catalog.DoorWeights[DoorIdx] > 0.f){
+				RoomGroupCounts[RoomIdx * NumGroups + GetGroup(DoorIdx)]++;
+			}
+		}
+	}
+
+	// Every room and door group (as RoomIdx * NumGroups + Group) that a door of each group can connect to
+	TArray<TArray<int32>> GroupTargets;
+	GroupTargets.SetNum(NumGroups);
+	for (int32 SourceGroup = 0; SourceGroup < NumGroups; SourceGroup++){
+		for (int32 TargetRoomIdx = 0; TargetRoomIdx < NumRooms; TargetRoomIdx++){
+			if(!CanBeTarget(TargetRoomIdx)) continue;
+
+			for (int32 TargetGroup = 0; TargetGroup < NumGroups; TargetGroup++){
+				if(RoomGroupCounts[TargetRoomIdx * NumGroups + TargetGroup] > 0 && AreGroupsCompatible(SourceGroup, TargetGroup)){
+					GroupTargets[SourceGroup].Add(TargetRoomIdx * NumGroups + TargetGroup);
+				}
+			}
+		}
+	}
+
+	// Amount of target doors a door of the group on the room can connect to
+	auto CountTargetDoors = [&](const int32 RoomIdx, const int32 SourceGroup){
+		const bool bAllowSameRoom = EnumHasAnyFlags(Catalog.RoomFlags[RoomIdx], EReberuCatalogRoomFlags::AllowSameRoomConnect);
+		int32 NumTargetDoors = 0;
+		for (const int32 TargetState : GroupTargets[SourceGroup]){
+			if(bAllowSameRoom || TargetState / NumGroups != RoomIdx){
+				NumTargetDoors += RoomGroupCounts[TargetState];
+			}
+		}
+		return NumTargetDoors;
+	};
+
+	// Flood the rooms from the starting room. A state is a room and the group of the door it was entered through,
+	// since the entry door is the only thing that changes which doors a placed room has left.
+	ReachableRooms.Init(false, NumRooms);
+	TBitArray<> ReachedStates(false, NumRooms * NumGroups);
+	TArray<int32> Queue;
+
+	// Returns the amount of doors that can connect to another room, for a room entered through a door of the group (INDEX_NONE for the starting room)
+	auto Expand = [&](const int32 RoomIdx, const int32 EntryGroup){
+		const bool bAllowSameRoom = EnumHasAnyFlags(Catalog.RoomFlags[RoomIdx], EReberuCatalogRoomFlags::AllowSameRoomConnect);
+		int32 NumConnectableDoors = 0;
+		for (int32 SourceGroup = 0; SourceGroup < NumGroups; SourceGroup++){
+			const int32 NumSourceDoors = RoomGroupCounts[RoomIdx * NumGroups + SourceGroup] - (SourceGroup == EntryGroup ? 1 : 0);
+			if(NumSourceDoors <= 0) continue;
+
+			bool bHasTarget = false;
+			for (const int32 TargetState : GroupTargets[SourceGroup]){
+				if(!bAllowSameRoom && TargetState / NumGroups == RoomIdx) continue;
+
+				bHasTarget = true;
+				if(!ReachedStates[TargetState]){
+					ReachedStates[TargetState] = true;
+					Queue.Add(TargetState);
+				}
+			}
+			NumConnectableDoors += bHasTarget ? NumSourceDoors : 0;
+		}
+		return NumConnectableDoors;
+	};
+
+	// Without a starting room, generation starts from any placeable room
+	TArray<int32> StartRooms;
+	if(!ReberuData->StartingRoom.IsNull()){
+		const int32 StartRoomIdx = ReberuData->GetRoomIndex(ReberuData->StartingRoom.Get());
+		if(!Catalog.Rooms.IsValidIndex(StartRoomIdx) || !Catalog.Rooms[StartRoomIdx]){
+			// Nothing can be said about the layouts without the starting room. It isn't an error of the analysis (which would stay cached),
+			// generation reports the starting room when it can't load it and the catalog is rebuilt once it is loaded.
+			return;
+		}
+		StartRooms.Add(StartRoomIdx);
+	}
+	else{
+		for (int32 RoomIdx = 0; RoomIdx < Catalog.NumPlaceableRooms(); RoomIdx++){
+			StartRooms.Add(RoomIdx);
+		}
+	}
+	bIsAnalyzed = true;
+
+	int32 MaxStartDoors = 0;
+	for (const int32 StartRoomIdx : StartRooms){
+		ReachableRooms[StartRoomIdx] = true;
+		MaxStartDoors = FMath::Max(MaxStartDoors, Expand(StartRoomIdx, INDEX_NONE));
+	}
+
+	bool bCanGrow = false;
+	for (int32 QueueIdx = 0; QueueIdx < Queue.Num(); QueueIdx++){
+		const int32 RoomIdx = Queue[QueueIdx] / NumGroups;
+		ReachableRooms[RoomIdx] = true;
+		bCanGrow |= Expand(RoomIdx, Queue[QueueIdx] % NumGroups) > 0;
+	}
+	MaxRooms = bCanGrow ? INDEX_NONE : 1 + MaxStartDoors;
+
+	// Doors and branching per tag, over every room that can be in a layout at all
+	TagAnalysis.SetNum(NumTags);
+	TArray<int64> TagTargetDoors;
+	TagTargetDoors.Init(0, NumTags);
+	int64 ReachableTargetDoors = 0;
+	int32 NumReachableDoors = 0;
+	bool bReachableCanGainDoors = false;
+	for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+		if(!CanBeTarget(RoomIdx) && !StartRooms.Contains(RoomIdx)) continue;
+
+		for (int32 Group = 0; Group < NumGroups; Group++){
+			const int32 NumDoors = RoomGroupCounts[RoomIdx * NumGroups + Group];
+			if(NumDoors == 0) continue;
+
+			const int32 NumTargetDoors = CountTargetDoors(RoomIdx, Group);
+			FReberuTagAnalysis& Tag = TagAnalysis[Group >> 1];
+			Tag.NumDoors += NumDoors;
+			Tag.NumUnmatchedDoors += NumTargetDoors == 0 ? NumDoors : 0;
+			TagTargetDoors[Group >> 1] += static_cast<int64>(NumTargetDoors) * NumDoors;
+
+			if(ReachableRooms[RoomIdx]){
+				NumReachableDoors += NumDoors;
+				ReachableTargetDoors += static_cast<int64>(NumTargetDoors) * NumDoors;
+			}
+		}
+		bReachableCanGainDoors |= ReachableRooms[RoomIdx] && CanBeTarget(RoomIdx) && Catalog.RoomNumDoors[RoomIdx] > 2;
+	}
+	for (int32 TagIdx = 0; TagIdx < NumTags; TagIdx++){
+		FReberuTagAnalysis& Tag = TagAnalysis[TagIdx];
+		Tag.BranchingFactor = Tag.NumDoors > 0 ? static_cast<float>(TagTargetDoors[TagIdx]) / Tag.NumDoors : 0.f;
+		if(Tag.NumDoors > 0 && Tag.NumUnmatchedDoors == Tag.NumDoors){
+			Warnings.Add(FText::Format(LOCTEXT("UnmatchedTag", "{0} door(s) with tag {1} in {2} can't connect to a door of any room that can be placed, they will always be blocked."),
+				Tag.NumDoors, GetTagName(TagIdx), DataName));
+		}
+	}
+	BranchingFactor = NumReachableDoors > 0 ? static_cast<float>(ReachableTargetDoors) / NumReachableDoors : 0.f;
+
+	for (int32 RoomIdx = 0; RoomIdx < Catalog.NumPlaceableRooms(); RoomIdx++){
+		if(!Catalog.Rooms[RoomIdx] || Catalog.RoomWeights[RoomIdx] <= 0.f) continue;
+
+		if(Catalog.RoomNumDoors[RoomIdx] == 0){
+			Warnings.Add(FText::Format(LOCTEXT("RoomWithoutDoors", "Room {0} in {1} has no doors, it can never be placed."), GetRoomName(RoomIdx), DataName));
+		}
+		else if(!ReachableRooms[RoomIdx]){
+			Warnings.Add(FText::Format(LOCTEXT("UnreachableRoom", "Room {0} in {1} can never be placed, none of its doors can connect to a room that can be reached from the starting room."),
+				GetRoomName(RoomIdx), DataName));
+		}
+	}
+
+	// Things that make every generation fail
+	if(ReberuData->TargetRoomAmount > UReberuData::MaxLayoutRooms){
+		Errors.Add(FText::Format(LOCTEXT("TargetOverMax", "The TargetRoomAmount ({0}) of {1} is more than the {2} rooms a layout can have."),
+			ReberuData->TargetRoomAmount, DataName, UReberuData::MaxLayoutRooms));
+	}
+	if(NumRooms > UReberuData::MaxLayoutRooms){
+		Errors.Add(FText::Format(LOCTEXT("CatalogOverMax", "{0} has {1} rooms, more than the {2} rooms it can have."), DataName, NumRooms, UReberuData::MaxLayoutRooms));
+	}
+	for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+		if(Catalog.RoomNumDoors[RoomIdx] > UReberuRoomData::MaxDoors){
+			Errors.Add(FText::Format(LOCTEXT("RoomOverMaxDoors", "Room {0} in {1} has {2} doors, rooms can have at most {3}."),
+				GetRoomName(RoomIdx), DataName, Catalog.RoomNumDoors[RoomIdx], UReberuRoomData::MaxDoors));
+		}
+	}
+	if(ReberuData->MinRoomAmount > ReberuData->TargetRoomAmount){
+		Errors.Add(FText::Format(LOCTEXT("MinOverTarget", "The MinRoomAmount ({0}) of {1} is more than its TargetRoomAmount ({2})."),
+			ReberuData->MinRoomAmount, DataName, ReberuData->TargetRoomAmount));
+	}
+	if(MaxRooms != INDEX_NONE && MaxRooms < ReberuData->MinRoomAmount){
+		Errors.Add(FText::Format(LOCTEXT("MaxUnderMin", "At most {0} room(s) can be connected in {1}, less than its MinRoomAmount ({2})."),
+			MaxRooms, DataName, ReberuData->MinRoomAmount));
+	}
+	for (int32 ConstraintIdx = 0; ConstraintIdx < Catalog.NumConstraints(); ConstraintIdx++){
+		if(Catalog.ConstraintMin[ConstraintIdx] == 0) continue;
+
+		bool bCanBeMet = false;
+		for (TConstSetBitIterator<> It(ReachableRooms); It && !bCanBeMet; ++It){
+			bCanBeMet = Catalog.MatchesConstraint(ConstraintIdx, It.GetIndex());
+		}
+		if(!bCanBeMet){
+			Errors.Add(FText::Format(LOCTEXT("ConstraintUnreachable", "Room constraint {0} of {1} needs at least {2} room(s), but none of the rooms it counts can be placed."),
+				ConstraintIdx, DataName, Catalog.ConstraintMin[ConstraintIdx]));
+		}
+	}
+
+	// Things that make generation backtrack a lot
+	if(MaxRooms != INDEX_NONE && MaxRooms >= ReberuData->MinRoomAmount && MaxRooms < ReberuData->TargetRoomAmount){
+		Warnings.Add(FText::Format(LOCTEXT("MaxUnderTarget", "At most {0} room(s) can be connected in {1}, so the TargetRoomAmount ({2}) is never reached and every generation backtracks until it gives up."),
+			MaxRooms, DataName, ReberuData->TargetRoomAmount));
+	}
+	else if(bCanGrow && !bReachableCanGainDoors && ReberuData->TargetRoomAmount > 1 + MaxStartDoors){
+		Warnings.Add(FText::Format(LOCTEXT("OnlyChains", "No room that can be placed in {0} has more than 2 doors, so the layout only grows as chains from the starting room and every overlap needs backtracking."),
+			DataName));
+	}
+	if(NumReachableDoors > 0 && BranchingFactor < 2.f){
+		Warnings.Add(FText::Format(LOCTEXT("LowBranching", "The doors of {0} can connect to {1} door(s) on average. With this few options, overlapping rooms will often need backtracking."),
+			DataName, FText::AsNumber(BranchingFactor)));
+	}
+}
+
+FString FReberuCatalogAnalysis::ToString(const FReberuRoomCatalog& Catalog) const{
+	FString Report = FString::Printf(TEXT("%d of %d rooms can be placed, average branching factor %.2f, max rooms %s"),
+		ReachableRooms.CountSetBits(), Catalog.NumRooms(), BranchingFactor, MaxRooms == INDEX_NONE ? TEXT("unlimited") : *FString::FromInt(MaxRooms));
+
+	for (int32 TagIdx = 0; TagIdx < TagAnalysis.Num() && TagIdx < Catalog.Tags.Num(); TagIdx++){
+		const FReberuTagAnalysis& Tag = TagAnalysis[TagIdx];
+		if(Tag.NumDoors == 0) continue;
+
+		Report += FString::Printf(TEXT("\n  %s: %d door(s), %d without a partner, branching factor %.2f"),
+			TagIdx == 0 ? TEXT("untagged") : *Catalog.Tags[TagIdx].ToString(), Tag.NumDoors, Tag.NumUnmatchedDoors, Tag.BranchingFactor);
+	}
+	return Report;
+}
+
+#undef LOCTEXT_NAMESPACE
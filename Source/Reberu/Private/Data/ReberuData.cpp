@@ -3,3 +3,243 @@
 
 #include "Data/ReberuData.h"
 
+#include "Reberu.h"
+#include "Data/ReberuRoomData.h"
+#include "Engine/AssetManager.h"
+#if WITH_EDITOR
+#include "Misc/DataValidation.h"
+#include "UObject/ObjectSaveContext.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "ReberuData"
+
+int32 UReberuData::GetRoomIndex(const UReberuRoomData* Room) const{
+	if(!Room) return INDEX_NONE;
+
+	const FSoftObjectPath RoomPath(Room);
+	const int32 RoomIndex = ReberuRooms.IndexOfByPredicate([&RoomPath](const TSoftObjectPtr<UReberuRoomData>& ReberuRoom){
+		return ReberuRoom.ToSoftObjectPath() == RoomPath;
+	});
+	if(RoomIndex != INDEX_NONE) return RoomIndex;
+
+	return StartingRoom.ToSoftObjectPath() == RoomPath ? ReberuRooms.Num() : INDEX_NONE;
+}
+
+UReberuRoomData* UReberuData::GetRoomByIndex(const int32 RoomIndex) const{
+	// Clients can receive rooms of a layout they didn't generate, so this can't rely on the generation having loaded them.
+	if(ReberuRooms.IsValidIndex(RoomIndex)) return ReberuRooms[RoomIndex].LoadSynchronous();
+
+	return RoomIndex == ReberuRooms.Num() ? StartingRoom.LoadSynchronous() : nullptr;
+}
+
+const FReberuDoorInfo* UReberuData::FindDoorInfo(const FGameplayTag& DoorTag) const{
+	if (!DoorTag.IsValid()){
+		return DoorMap.Find(ReberuEmptyDoorTag);
+	}
+
+	const FReberuDoorInfo* DoorInfo = DoorMap.Find(DoorTag);
+	if(DoorInfo || DoorMatching != EReberuDoorMatching::Hierarchical) return DoorInfo;
+
+	// Fall back to the closest parent tag that has door info
+	for (FGameplayTag ParentTag = DoorTag.RequestDirectParent(); ParentTag.IsValid() && !DoorInfo; ParentTag = ParentTag.RequestDirectParent()){
+		DoorInfo = DoorMap.Find(ParentTag);
+	}
+	return DoorInfo;
+}
+
+TSharedPtr<FStreamableHandle> UReberuData::LoadGenerationData() const{
+	TArray<FSoftObjectPath> PathsToLoad;
+	for (const TSoftObjectPtr<UReberuRoomData>& ReberuRoom : ReberuRooms){
+		if(!ReberuRoom.IsNull() && !ReberuRoom.IsValid()) PathsToLoad.AddUnique(ReberuRoom.ToSoftObjectPath());
+	}
+	if(!StartingRoom.IsNull() && !StartingRoom.IsValid()) PathsToLoad.AddUnique(StartingRoom.ToSoftObjectPath());
+
+	if(PathsToLoad.Num() == 0) return nullptr;
+
+	REBERU_LOG_ARGS(Log, "Loading %d rooms of %s", PathsToLoad.Num(), *GetName())
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(PathsToLoad);
+}
+
+TSharedPtr<FStreamableHandle> UReberuData::LoadDoorData(const TSet<FGameplayTag>& DoorTags) const{
+	TArray<FSoftObjectPath> PathsToLoad;
+	auto AddPath = [&PathsToLoad](const FSoftObjectPath& Path){
+		if(!Path.IsNull() && !Path.ResolveObject()) PathsToLoad.AddUnique(Path);
+	};
+
+	for (const FGameplayTag& DoorTag : DoorTags){
+		const FReberuDoorInfo* DoorInfo = FindDoorInfo(DoorTag);
+		if(!DoorInfo) continue;
+
+		AddPath(DoorInfo->DoorActor.ToSoftObjectPath());
+		AddPath(DoorInfo->BlockedDoorActor.ToSoftObjectPath());
+		if(DoorInfo->bInstanceDoors) AddPath(DoorInfo->DoorMesh.ToSoftObjectPath());
+		if(DoorInfo->bInstanceBlockedDoors) AddPath(DoorInfo->BlockedDoorMesh.ToSoftObjectPath());
+	}
+
+	if(PathsToLoad.Num() == 0) return nullptr;
+
+	REBERU_LOG_ARGS(Log, "Loading %d door assets of %s", PathsToLoad.Num(), *GetName())
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(PathsToLoad);
+}
+
+const FReberuRoomCatalog& UReberuData::GetCatalog() const{
+	if(!Catalog.IsBuilt()){
+		Catalog.Build(this);
+	}
+	return Catalog;
+}
+
+void UReberuData::InvalidateCatalog() const{
+	Catalog.Reset();
+	Analysis.Reset();
+}
+
+const FReberuCatalogAnalysis& UReberuData::GetAnalysis() const{
+	if(!Analysis.IsAnalyzed()){
+		Analysis.Analyze(this, GetCatalog());
+	}
+	return Analysis;
+}
+
+bool UReberuData::PrepareGeneration(const bool bLoadedRooms){
+	// Rooms might have been loaded (by us or anyone else) or edited since the catalog was built
+	if(bLoadedRooms || GIsEditor || GetCatalog().HasUnloadedRooms()){
+		InvalidateCatalog();
+	}
+
+	// Door ids and scales are validated when the data is edited or saved, so the rooms are only checked here if they changed since
+	if(!IsValidationUpToDate()){
+#if WITH_EDITOR
+		TArray<FText> Errors;
+		RefreshValidation(Errors);
+		for (const FText& Error : Errors){
+			REBERU_LOG_ARGS(Error, "%s", *Error.ToString())
+		}
+#else
+		REBERU_LOG_ARGS(Warning, "The rooms of %s changed since it was last validated. Resave it in the editor to check its doors.", *GetName())
+#endif
+	}
+
+	const FReberuCatalogAnalysis& RoomsAnalysis = GetAnalysis();
+	for (const FText& Error : RoomsAnalysis.Errors){
+		REBERU_LOG_ARGS(Error, "%s", *Error.ToString())
+	}
+	if(GetCatalog().NumPlaceableRooms() == 0){
+		REBERU_LOG_ARGS(Error, "%s has no rooms that can be placed!", *GetName())
+		return false;
+	}
+	return RoomsAnalysis.CanGenerate();
+}
+
+void UReberuData::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector){
+	Super::AddReferencedObjects(InThis, Collector);
+
+	UReberuData* This = CastChecked<UReberuData>(InThis);
+	Collector.AddReferencedObjects(This->Catalog.Rooms, This);
+}
+
+uint32 UReberuData::ComputeRoomsHash() const{
+	auto HashRoom = [](uint32 Hash, const TSoftObjectPtr<UReberuRoomData>& Room){
+		Hash = HashCombine(Hash, GetTypeHash(Room.ToSoftObjectPath()));
+		const UReberuRoomData* RoomData = Room.Get();
+		return HashCombine(Hash, RoomData ? RoomData->DoorsHash : 0);
+	};
+
+	uint32 Hash = HashRoom(GetTypeHash(ReberuRooms.Num()), StartingRoom);
+	for (const TSoftObjectPtr<UReberuRoomData>& ReberuRoom : ReberuRooms){
+		Hash = HashRoom(Hash, ReberuRoom);
+	}
+	// 0 means not validated
+	return Hash != 0 ? Hash : 1;
+}
+
+#if WITH_EDITOR
+bool UReberuData::ValidateRooms(TArray<FText>& OutErrors) const{
+	TArray<UReberuRoomData*> Rooms;
+	for (const TSoftObjectPtr<UReberuRoomData>& ReberuRoom : ReberuRooms){
+		Rooms.AddUnique(ReberuRoom.LoadSynchronous());
+	}
+	Rooms.AddUnique(StartingRoom.LoadSynchronous());
+	Rooms.Remove(nullptr);
+
+	TMap<FString, const UReberuRoomData*> DoorToRoomMap;
+	for (const UReberuRoomData* Room : Rooms){
+		for (const FReberuDoor& Door : Room->Room.ReberuDoors){
+			if(!Door.DoorTransform.GetScale3D().Equals(FVector::One())){
+				OutErrors.Add(UReberuRoomData::MakeDoorScaleError(Room->RoomName, Door.DoorId));
+			}
+
+			if(const UReberuRoomData** OldRoom = DoorToRoomMap.Find(Door.DoorId)){
+				OutErrors.Add(UReberuRoomData::MakeDuplicateDoorIdError(Room->RoomName, Door.DoorId, (*OldRoom)->RoomName));
+			}
+			else{
+				DoorToRoomMap.Add(Door.DoorId, Room);
+			}
+		}
+	}
+	return OutErrors.Num() == 0;
+}
+
+EDataValidationResult UReberuData::IsDataValid(FDataValidationContext& Context) const{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	TArray<FText> Errors;
+	ValidateRooms(Errors);
+
+	// The rooms are loaded now, so the catalog might have been built without some of them
+	InvalidateCatalog();
+	Errors.Append(GetAnalysis().Errors);
+
+	for (const FText& Error : Errors){
+		Context.AddError(Error);
+	}
+	for (const FText& Warning : GetAnalysis().Warnings){
+		Context.AddWarning(Warning);
+	}
+	return Errors.Num() > 0 ? EDataValidationResult::Invalid : Result;
+}
+
+bool UReberuData::RefreshValidation(TArray<FText>& OutErrors){
+	const bool bIsValid = ValidateRooms(OutErrors);
+	ValidatedRoomsHash = bIsValid ? ComputeRoomsHash() : 0;
+	return bIsValid;
+}
+
+void UReberuData::AnalyzeRooms(){
+	if(const TSharedPtr<FStreamableHandle> LoadHandle = LoadGenerationData()){
+		LoadHandle->WaitUntilComplete();
+	}
+	InvalidateCatalog();
+
+	const FReberuCatalogAnalysis& RoomsAnalysis = GetAnalysis();
+	REBERU_LOG_ARGS(Log, "Analysis of %s: %s", *GetName(), *RoomsAnalysis.ToString(GetCatalog()))
+	for (const FText& Error : RoomsAnalysis.Errors){
+		REBERU_LOG_ARGS(Error, "%s", *Error.ToString())
+	}
+	for (const FText& Warning : RoomsAnalysis.Warnings){
+		REBERU_LOG_ARGS(Warning, "%s", *Warning.ToString())
+	}
+}
+
+void UReberuData::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent){
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	InvalidateCatalog();
+
+	// Validating loads every room, so only edits of the rooms validate them again
+	const FName PropertyName = PropertyChangedEvent.GetMemberPropertyName();
+	if(PropertyName == GET_MEMBER_NAME_CHECKED(UReberuData, ReberuRooms) || PropertyName == GET_MEMBER_NAME_CHECKED(UReberuData, StartingRoom)){
+		TArray<FText> Errors;
+		RefreshValidation(Errors);
+	}
+}
+
+void UReberuData::PreSave(FObjectPreSaveContext SaveContext){
+	Super::PreSave(SaveContext);
+
+	TArray<FText> Errors;
+	RefreshValidation(Errors);
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
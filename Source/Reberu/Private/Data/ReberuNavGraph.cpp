@@ -0,0 +1,170 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Data/ReberuNavGraph.h"
+
+#include "LevelGeneratorActor.h"
+#include "Algo/Reverse.h"
+#include "Data/ReberuRoomData.h"
+#include "Data/ReberuRoomGraph.h"
+
+void FReberuNavGraph::Reset(){
+	NodeLocations.Reset();
+	RoomFirstNode.Reset();
+	RoomIndex.Reset();
+	BoxRooms.Reset();
+	NodeFirstLink.Reset();
+	LinkNodes.Reset();
+}
+
+void FReberuNavGraph::Build(const ALevelGeneratorActor& LevelGenerator, const FReberuRoomGraph& RoomGraph){
+	Reset();
+
+	const int32 NumRooms = RoomGraph.NumRooms();
+	TArray<const FReberuRoomNavData*> RoomNavData;
+	RoomNavData.Init(nullptr, NumRooms);
+	RoomFirstNode.Init(0, NumRooms + 1);
+
+	// Move the baked nodes of every room to its transform
+	TArray<int32> LinkPairs;
+	for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+		RoomFirstNode[RoomIdx] = NodeLocations.Num();
+		const FRoomLevel* RoomLevel = RoomGraph.IsValidRoom(RoomIdx) ? LevelGenerator.GetRoomLevel(RoomIdx) : nullptr;
+		if(!RoomLevel || !RoomLevel->InRoom || !RoomLevel->InRoom->Room.NavData.IsBaked()) continue;
+
+		const FReberuRoomNavData& NavData = RoomLevel->InRoom->Room.NavData;
+		RoomNavData[RoomIdx] = &NavData;
+
+		const FTransform BoundsTransform = LevelGenerator.GetRoomBoundsTransform(RoomIdx);
+		RoomIndex.Add(BoundsTransform, RoomLevel->InRoom->Room.BoxExtent);
+		BoxRooms.Add(RoomIdx);
+		const int32 FirstNode = NodeLocations.Num();
+		for (const FVector3f& NodeLocation : NavData.NodeLocations){
+			NodeLocations.Add(BoundsTransform.TransformPosition(FVector(NodeLocation)));
+		}
+		for (int32 LinkIdx = 0; LinkIdx + 1 < NavData.Links.Num(); LinkIdx += 2){
+			LinkPairs.Add(FirstNode + NavData.Links[LinkIdx]);
+			LinkPairs.Add(FirstNode + NavData.Links[LinkIdx + 1]);
+		}
+	}
+	RoomFirstNode[NumRooms] = NodeLocations.Num();
+
+	// Stitch the rooms at the door nodes of their connections
+	auto GetDoorNode = [&](const int32 RoomIdx, const int32 DoorIdx){
+		const FReberuRoomNavData* NavData = RoomNavData[RoomIdx];
+		if(!NavData || !NavData->DoorNodes.IsValidIndex(DoorIdx) || NavData->DoorNodes[DoorIdx] == INDEX_NONE) return INDEX_NONE;
+		return RoomFirstNode[RoomIdx] + NavData->DoorNodes[DoorIdx];
+	};
+	for (int32 RoomIdx = 0; RoomIdx < NumRooms; RoomIdx++){
+		for (const FReberuRoomConnection& Connection : RoomGraph.GetConnections(RoomIdx)){
+			// Connections are stored from both rooms
+			if(Connection.RoomIdx < RoomIdx) continue;
+
+			const int32 DoorNode = GetDoorNode(RoomIdx, Connection.DoorIdx);
+			const int32 OtherDoorNode = GetDoorNode(Connection.RoomIdx, Connection.OtherDoorIdx);
+			if(DoorNode != INDEX_NONE && OtherDoorNode != INDEX_NONE){
+				LinkPairs.Add(DoorNode);
+				LinkPairs.Add(OtherDoorNode);
+			}
+		}
+	}
+
+	// Counting sort of the links by node, in both directions
+	NodeFirstLink.Init(0, NodeLocations.Num() + 1);
+	for (const int32 NodeIdx : LinkPairs){
+		NodeFirstLink[NodeIdx + 1]++;
+	}
+	for (int32 NodeIdx = 0; NodeIdx < NodeLocations.Num(); NodeIdx++){
+		NodeFirstLink[NodeIdx + 1] += NodeFirstLink[NodeIdx];
+	}
+	TArray<int32> NextLink(NodeFirstLink);
+	LinkNodes.SetNumUninitialized(LinkPairs.Num());
+	for (int32 PairIdx = 0; PairIdx + 1 < LinkPairs.Num(); PairIdx += 2){
+		LinkNodes[NextLink[LinkPairs[PairIdx]]++] = LinkPairs[PairIdx + 1];
+		LinkNodes[NextLink[LinkPairs[PairIdx + 1]]++] = LinkPairs[PairIdx];
+	}
+}
+
+int32 FReberuNavGraph::FindClosestNode(const FVector& Location) const{
+	int32 ClosestNode = INDEX_NONE;
+	double ClosestDistSquared = TNumericLimits<double>::Max();
+	auto CheckNodes = [&](const int32 FirstNode, const int32 EndNode){
+		for (int32 NodeIdx = FirstNode; NodeIdx < EndNode; NodeIdx++){
+			const double DistSquared = FVector::DistSquared(NodeLocations[NodeIdx], Location);
+			if(DistSquared < ClosestDistSquared){
+				ClosestNode = NodeIdx;
+				ClosestDistSquared = DistSquared;
+			}
+		}
+	};
+	auto CheckRooms = [&](const TArray<int32>& BoxIdxs){
+		for (const int32 BoxIdx : BoxIdxs){
+			const int32 RoomIdx = BoxRooms[BoxIdx];
+			CheckNodes(RoomFirstNode[RoomIdx], RoomFirstNode[RoomIdx + 1]);
+		}
+	};
+
+	TArray<int32> BoxIdxs;
+	RoomIndex.FindBoxesAt(Location, BoxIdxs);
+	CheckRooms(BoxIdxs);
+	// Outside of every room, like in a doorway
+	if(ClosestNode == INDEX_NONE){
+		RoomIndex.FindBoxesAt(Location, BoxIdxs, RoomSearchDistance);
+		CheckRooms(BoxIdxs);
+	}
+	return ClosestNode;
+}
+
+bool FReberuNavGraph::FindPath(const FVector& Start, const FVector& End, TArray<FVector>& OutPath) const{
+	OutPath.Reset();
+	const int32 StartNode = FindClosestNode(Start);
+	const int32 EndNode = FindClosestNode(End);
+	if(StartNode == INDEX_NONE || EndNode == INDEX_NONE) return false;
+
+	struct FOpenNode{
+		double Estimate;
+		int32 NodeIdx;
+		bool operator<(const FOpenNode& Other) const{return Estimate < Other.Estimate;}
+	};
+
+	TArray<double> Costs;
+	Costs.Init(TNumericLimits<double>::Max(), NodeLocations.Num());
+	TArray<int32> PreviousNodes;
+	PreviousNodes.Init(INDEX_NONE, NodeLocations.Num());
+	TArray<FOpenNode> OpenNodes;
+
+	Costs[StartNode] = 0.;
+	OpenNodes.HeapPush({FVector::Dist(NodeLocations[StartNode], NodeLocations[EndNode]), StartNode});
+	while (OpenNodes.Num() > 0){
+		FOpenNode Current;
+		OpenNodes.HeapPop(Current, EAllowShrinking::No);
+		if(Current.NodeIdx == EndNode) break;
+
+		// Nodes can be in the heap more than once, skip the ones that were already reached cheaper
+		const double CurrentCost = Costs[Current.NodeIdx];
+		if(Current.Estimate - FVector::Dist(NodeLocations[Current.NodeIdx], NodeLocations[EndNode]) > CurrentCost + UE_KINDA_SMALL_NUMBER) continue;
+
+		for (int32 LinkIdx = NodeFirstLink[Current.NodeIdx]; LinkIdx < NodeFirstLink[Current.NodeIdx + 1]; LinkIdx++){
+			const int32 LinkedNode = LinkNodes[LinkIdx];
+			const double LinkedCost = CurrentCost + FVector::Dist(NodeLocations[Current.NodeIdx], NodeLocations[LinkedNode]);
+			if(LinkedCost >= Costs[LinkedNode]) continue;
+
+			Costs[LinkedNode] = LinkedCost;
+			PreviousNodes[LinkedNode] = Current.NodeIdx;
+			OpenNodes.HeapPush({LinkedCost + FVector::Dist(NodeLocations[LinkedNode], NodeLocations[EndNode]), LinkedNode});
+		}
+	}
+	if(StartNode != EndNode && PreviousNodes[EndNode] == INDEX_NONE) return false;
+
+	OutPath.Add(End);
+	for (int32 NodeIdx = EndNode; NodeIdx != INDEX_NONE; NodeIdx = PreviousNodes[NodeIdx]){
+		OutPath.Add(NodeLocations[NodeIdx]);
+	}
+	OutPath.Add(Start);
+	Algo::Reverse(OutPath);
+	return true;
+}
+
+SIZE_T FReberuNavGraph::GetAllocatedSize() const{
+	return NodeLocations.GetAllocatedSize() + RoomFirstNode.GetAllocatedSize() + RoomIndex.GetAllocatedSize() + BoxRooms.GetAllocatedSize() + NodeFirstLink.GetAllocatedSize() + LinkNodes.GetAllocatedSize();
+}
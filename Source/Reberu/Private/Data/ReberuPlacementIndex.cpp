@@ -0,0 +1,223 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Data/ReberuPlacementIndex.h"
+
+void FReberuPlacementIndex::Reset(const float InCellSize){
+	Boxes.Reset();
+	Cells.Reset();
+	NumRemoved = 0;
+	FreeBoxIdxs.Reset();
+	CellSize = FMath::Max(InCellSize, 1.f);
+	bHasRegion = false;
+}
+
+void FReberuPlacementIndex::SetRegion(const FTransform& InRegionTransform, const FVector& InRegionExtent){
+	bHasRegion = true;
+	RegionTransform = InRegionTransform;
+	RegionExtent = InRegionExtent;
+}
+
+bool FReberuPlacementIndex::IsInsideRegion(const FPlacedBox& Box, const float Tolerance) const{
+	// Bounds of the box in the region's space
+	const FVector LocalCenter = RegionTransform.InverseTransformPositionNoScale(Box.Center);
+	const FQuat LocalRotation = RegionTransform.GetRotation().Inverse() * Box.Rotation;
+	const FVector LocalExtent = LocalRotation.GetAxisX().GetAbs() * Box.Extent.X + LocalRotation.GetAxisY().GetAbs() * Box.Extent.Y
+		+ LocalRotation.GetAxisZ().GetAbs() * Box.Extent.Z;
+
+	const FVector Overflow = LocalCenter.GetAbs() + LocalExtent - RegionExtent;
+	return Overflow.GetMax() <= Tolerance;
+}
+
+FIntVector FReberuPlacementIndex::GetCell(const FVector& Location) const{
+	return FIntVector(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize), FMath::FloorToInt32(Location.Z / CellSize));
+}
+
+FReberuPlacementIndex::FPlacedBox FReberuPlacementIndex::MakeBox(const FTransform& BoundsTransform, const FVector& Extent) const{
+	FPlacedBox Box;
+	Box.Center = BoundsTransform.GetLocation();
+	Box.Rotation = BoundsTransform.GetRotation();
+	Box.Extent = Extent;
+
+	const FBox WorldBox = FBox(-Extent, Extent).TransformBy(FTransform(Box.Rotation, Box.Center));
+	Box.MinCell = GetCell(WorldBox.Min);
+	Box.MaxCell = GetCell(WorldBox.Max);
+	return Box;
+}
+
+int32 FReberuPlacementIndex::Add(const FTransform& BoundsTransform, const FVector& Extent){
+	// Indices that keep removing and adding boxes don't grow past the most boxes they had at once
+	int32 BoxIdx;
+	if(FreeBoxIdxs.Num() > 0){
+		BoxIdx = FreeBoxIdxs.Pop(EAllowShrinking::No);
+		Boxes[BoxIdx] = MakeBox(BoundsTransform, Extent);
+		NumRemoved--;
+	}
+	else{
+		BoxIdx = Boxes.Add(MakeBox(BoundsTransform, Extent));
+	}
+	const FPlacedBox& Box = Boxes[BoxIdx];
+
+	for (int32 X = Box.MinCell.X; X <= Box.MaxCell.X; X++){
+		for (int32 Y = Box.MinCell.Y; Y <= Box.MaxCell.Y; Y++){
+			for (int32 Z = Box.MinCell.Z; Z <= Box.MaxCell.Z; Z++){
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(BoxIdx);
+			}
+		}
+	}
+	return BoxIdx;
+}
+
+void FReberuPlacementIndex::RemoveLast(){
+	if(Boxes.Num() == 0) return;
+
+	const int32 BoxIdx = Boxes.Num() - 1;
+	const FPlacedBox& Box = Boxes[BoxIdx];
+	if(Box.bRemoved){
+		NumRemoved--;
+		FreeBoxIdxs.RemoveSingleSwap(BoxIdx, EAllowShrinking::No);
+		Boxes.Pop(EAllowShrinking::No);
+		return;
+	}
+
+	// The last box is always at the end of its cells
+	for (int32 X = Box.MinCell.X; X <= Box.MaxCell.X; X++){
+		for (int32 Y = Box.MinCell.Y; Y <= Box.MaxCell.Y; Y++){
+			for (int32 Z = Box.MinCell.Z; Z <= Box.MaxCell.Z; Z++){
+				const FIntVector Cell(X, Y, Z);
+				TArray<int32>& CellBoxes = Cells.FindChecked(Cell);
+				CellBoxes.Pop(EAllowShrinking::No);
+				if(CellBoxes.Num() == 0) Cells.Remove(Cell);
+			}
+		}
+	}
+	Boxes.Pop(EAllowShrinking::No);
+}
+
+void FReberuPlacementIndex::Remove(const int32 BoxIdx){
+	if(!Boxes.IsValidIndex(BoxIdx) || Boxes[BoxIdx].bRemoved) return;
+
+	FPlacedBox& Box = Boxes[BoxIdx];
+	for (int32 X = Box.MinCell.X; X <= Box.MaxCell.X; X++){
+		for (int32 Y = Box.MinCell.Y; Y <= Box.MaxCell.Y; Y++){
+			for (int32 Z = Box.MinCell.Z; Z <= Box.MaxCell.Z; Z++){
+				const FIntVector Cell(X, Y, Z);
+				TArray<int32>& CellBoxes = Cells.FindChecked(Cell);
+				// Keep the order so the last box stays at the end of its cells
+				CellBoxes.RemoveSingle(BoxIdx);
+				if(CellBoxes.Num() == 0) Cells.Remove(Cell);
+			}
+		}
+	}
+	Box.bRemoved = true;
+	NumRemoved++;
+	FreeBoxIdxs.Add(BoxIdx);
+
+	// Once only removed boxes are left their slots can go too
+	if(NumRemoved == Boxes.Num()){
+		Boxes.Reset();
+		NumRemoved = 0;
+		FreeBoxIdxs.Reset();
+	}
+}
+
+SIZE_T FReberuPlacementIndex::GetAllocatedSize() const{
+	SIZE_T Size = Boxes.GetAllocatedSize() + Cells.GetAllocatedSize() + FreeBoxIdxs.GetAllocatedSize();
+	for (const TTuple<FIntVector, TArray<int32>>& Cell : Cells){
+		Size += Cell.Value.GetAllocatedSize();
+	}
+	return Size;
+}
+
+bool FReberuPlacementIndex::Overlaps(const FTransform& BoundsTransform, const FVector& Extent, const float Tolerance) const{
+	const FPlacedBox Box = MakeBox(BoundsTransform, Extent);
+	if(bHasRegion && !IsInsideRegion(Box, Tolerance)) return true;
+
+	// A box spanning several cells would get tested once per cell, so remember what was tested already
+	TSet<int32, DefaultKeyFuncs<int32>, TInlineSetAllocator<32>> TestedBoxes;
+	for (int32 X = Box.MinCell.X; X <= Box.MaxCell.X; X++){
+		for (int32 Y = Box.MinCell.Y; Y <= Box.MaxCell.Y; Y++){
+			for (int32 Z = Box.MinCell.Z; Z <= Box.MaxCell.Z; Z++){
+				const TArray<int32>* CellBoxes = Cells.Find(FIntVector(X, Y, Z));
+				if(!CellBoxes) continue;
+
+				for (const int32 OtherIdx : *CellBoxes){
+					bool bAlreadyTested = false;
+					TestedBoxes.Add(OtherIdx, &bAlreadyTested);
+					if(!bAlreadyTested && BoxesOverlap(Box, Boxes[OtherIdx], Tolerance)) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void FReberuPlacementIndex::FindBoxesAt(const FVector& Location, TArray<int32>& OutBoxIdxs, const float Tolerance) const{
+	OutBoxIdxs.Reset();
+
+	// Boxes are in every cell they touch, so only the cells within the tolerance can have them
+	const FIntVector MinCell = GetCell(Location - FVector(Tolerance));
+	const FIntVector MaxCell = GetCell(Location + FVector(Tolerance));
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++){
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++){
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++){
+				const TArray<int32>* CellBoxes = Cells.Find(FIntVector(X, Y, Z));
+				if(!CellBoxes) continue;
+
+				for (const int32 BoxIdx : *CellBoxes){
+					const FPlacedBox& Box = Boxes[BoxIdx];
+					const FVector LocalLocation = Box.Rotation.UnrotateVector(Location - Box.Center);
+					if((LocalLocation.GetAbs() - Box.Extent).GetMax() <= Tolerance){
+						OutBoxIdxs.AddUnique(BoxIdx);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool FReberuPlacementIndex::BoxesOverlap(const FPlacedBox& A, const FPlacedBox& B, const float Tolerance){
+	const FVector AExtent = (A.Extent - FVector(Tolerance)).ComponentMax(FVector::ZeroVector);
+	const FVector BExtent = (B.Extent - FVector(Tolerance)).ComponentMax(FVector::ZeroVector);
+	const FVector AAxes[3] = {A.Rotation.GetAxisX(), A.Rotation.GetAxisY(), A.Rotation.GetAxisZ()};
+	const FVector BAxes[3] = {B.Rotation.GetAxisX(), B.Rotation.GetAxisY(), B.Rotation.GetAxisZ()};
+
+	// Rotation of B in A's space, with an epsilon so parallel edges don't produce a zero cross product axis
+	double R[3][3];
+	double AbsR[3][3];
+	for (int32 I = 0; I < 3; I++){
+		for (int32 J = 0; J < 3; J++){
+			R[I][J] = AAxes[I] | BAxes[J];
+			AbsR[I][J] = FMath::Abs(R[I][J]) + UE_KINDA_SMALL_NUMBER;
+		}
+	}
+
+	const FVector Offset = B.Center - A.Center;
+	const double T[3] = {Offset | AAxes[0], Offset | AAxes[1], Offset | AAxes[2]};
+
+	// A's axes
+	for (int32 I = 0; I < 3; I++){
+		const double RadiusB = BExtent.X * AbsR[I][0] + BExtent.Y * AbsR[I][1] + BExtent.Z * AbsR[I][2];
+		if(FMath::Abs(T[I]) > AExtent[I] + RadiusB) return false;
+	}
+
+	// B's axes
+	for (int32 J = 0; J < 3; J++){
+		const double RadiusA = AExtent.X * AbsR[0][J] + AExtent.Y * AbsR[1][J] + AExtent.Z * AbsR[2][J];
+		if(FMath::Abs(T[0] * R[0][J] + T[1] * R[1][J] + T[2] * R[2][J]) > RadiusA + BExtent[J]) return false;
+	}
+
+	// Cross products of both
+	for (int32 I = 0; I < 3; I++){
+		const int32 I1 = (I + 1) % 3;
+		const int32 I2 = (I + 2) % 3;
+		for (int32 J = 0; J < 3; J++){
+			const int32 J1 = (J + 1) % 3;
+			const int32 J2 = (J + 2) % 3;
+			const double RadiusA = AExtent[I1] * AbsR[I2][J] + AExtent[I2] * AbsR[I1][J];
+			const double RadiusB = BExtent[J1] * AbsR[I][J2] + BExtent[J2] * AbsR[I][J1];
+			if(FMath::Abs(T[I2] * R[I1][J] - T[I1] * R[I2][J]) > RadiusA + RadiusB) return false;
+		}
+	}
+	return true;
+}
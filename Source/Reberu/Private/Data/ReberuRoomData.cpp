@@ -1,3 +1,78 @@
 // Copyright Peter Gilbert, All Rights Reserved
 
-#include "Data/ReberuRoomData.h"
\ No newline at end of file
+#include "Data/ReberuRoomData.h"
+
+#include "Reberu.h"
+#if WITH_EDITOR
+#include "Misc/DataValidation.h"
+#include "UObject/ObjectSaveContext.h"
+#endif
+
+#define LOCTEXT_NAMESPACE "ReberuRoomData"
+
+uint32 UReberuRoomData::ComputeDoorsHash() const{
+	uint32 Hash = GetTypeHash(Room.ReberuDoors.Num());
+	for (const FReberuDoor& Door : Room.ReberuDoors){
+		Hash = HashCombine(Hash, GetTypeHash(Door.DoorId));
+		Hash = HashCombine(Hash, GetTypeHash(Door.DoorTransform.GetScale3D()));
+	}
+	return Hash;
+}
+
+#if WITH_EDITOR
+FText UReberuRoomData::MakeDoorScaleError(const FName InRoomName, const FString& DoorId){
+	return FText::Format(LOCTEXT("DoorScale", "Door {0} on room {1} has a scale != 1 in its transform. Will cause door visual to look off."),
+		FText::FromString(DoorId), FText::FromName(InRoomName));
+}
+
+FText UReberuRoomData::MakeDuplicateDoorIdError(const FName InRoomName, const FString& DoorId, const FName OtherRoomName){
+	return FText::Format(LOCTEXT("DuplicateDoorId", "Duplicate Door Id detected in {0} with id: {1} (other in {2}). Please regenerate ids to have unique door ids."),
+		FText::FromName(InRoomName), FText::FromString(DoorId), FText::FromName(OtherRoomName));
+}
+
+EDataValidationResult UReberuRoomData::IsDataValid(FDataValidationContext& Context) const{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	if(Room.ReberuDoors.Num() > MaxDoors){
+		Context.AddError(FText::Format(LOCTEXT("TooManyDoors", "Room {0} has {1} doors, rooms can have at most {2}."), FText::FromName(RoomName), Room.ReberuDoors.Num(), MaxDoors));
+		Result = EDataValidationResult::Invalid;
+	}
+
+	TSet<FString> DoorIds;
+	for (const FReberuDoor& Door : Room.ReberuDoors){
+		if(!Door.DoorTransform.GetScale3D().Equals(FVector::One())){
+			Context.AddError(MakeDoorScaleError(RoomName, Door.DoorId));
+			Result = EDataValidationResult::Invalid;
+		}
+
+		bool bIsDuplicate = false;
+		DoorIds.Add(Door.DoorId, &bIsDuplicate);
+		if(bIsDuplicate){
+			Context.AddError(MakeDuplicateDoorIdError(RoomName, Door.DoorId, RoomName));
+			Result = EDataValidationResult::Invalid;
+		}
+	}
+	return Result;
+}
+
+void UReberuRoomData::PostLoad(){
+	Super::PostLoad();
+
+	// Rooms saved before the hash existed (or edited outside of the details panel) get it fixed up here, it is saved with the next save.
+	DoorsHash = ComputeDoorsHash();
+}
+
+void UReberuRoomData::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent){
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	DoorsHash = ComputeDoorsHash();
+}
+
+void UReberuRoomData::PreSave(FObjectPreSaveContext SaveContext){
+	Super::PreSave(SaveContext);
+
+	DoorsHash = ComputeDoorsHash();
+}
+#endif
+
+#undef LOCTEXT_NAMESPACE
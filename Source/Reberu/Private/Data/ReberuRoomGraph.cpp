@@ -0,0 +1,399 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Data/ReberuRoomGraph.h"
+
+#include "LevelGeneratorActor.h"
+#include "Data/ReberuRoomData.h"
+
+void FReberuRoomGraph::Reset(){
+	bHasRoom.Reset();
+	RoomBounds.Reset();
+	RoomFirstConnection.Reset();
+	Connections.Reset();
+	HopTable.Reset();
+	RoomDepths.Reset();
+	Ancestors.Reset();
+	NumAncestorLevels = 0;
+	Landmarks.Reset();
+	LandmarkDistances.Reset();
+	bDistancesExact = true;
+	bHasMissingRooms = false;
+}
+
+FTransform FReberuRoomGraph::GetBoundsTransform(const FRoomLevel& RoomLevel){
+	// Same as ALevelGeneratorActor::GetRoomBoundsTransform, without looking the room up again
+	return RoomLevel.InRoom->Room.GetLevelOffsetTransform().Inverse() * RoomLevel.SpawnTransform;
+}
+
+FVector FReberuRoomGraph::GetDoorLocation(const FReberuRoom& Room, const FTransform& BoundsTransform, const int32 DoorIdx){
+	return Room.ReberuDoors.IsValidIndex(DoorIdx) ? ALevelGeneratorActor::GetDoorWorldTransform(Room.ReberuDoors[DoorIdx], BoundsTransform).GetLocation() : FVector::ZeroVector;
+}
+
+int32 FReberuRoomGraph::FindDoorAt(const FReberuRoom& Room, const FTransform& BoundsTransform, const FVector& Location){
+	int32 ClosestDoorIdx = INDEX_NONE;
+	double ClosestDistSquared = TNumericLimits<double>::Max();
+	for (int32 DoorIdx = 0; DoorIdx < Room.ReberuDoors.Num(); DoorIdx++){
+		const double DistSquared = FVector::DistSquared(GetDoorLocation(Room, BoundsTransform, DoorIdx), Location);
+		if(DistSquared < ClosestDistSquared){
+			ClosestDoorIdx = DoorIdx;
+			ClosestDistSquared = DistSquared;
+		}
+	}
+	return ClosestDoorIdx;
+}
+
+void FReberuRoomGraph::Build(const ALevelGeneratorActor& LevelGenerator){
+	Reset();
+
+	// Replicated rooms can arrive in any order, so everything is stored by layout index
+	const TArray<FRoomLevel>& RoomLevels = LevelGenerator.SpawnedRoomLevels.Items;
+	int32 NumRoomIdxs = 0;
+	for (const FRoomLevel& RoomLevel : RoomLevels){
+		NumRoomIdxs = FMath::Max(NumRoomIdxs, RoomLevel.RoomIdx + 1);
+	}
+
+	TArray<const FRoomLevel*> Rooms;
+	Rooms.Init(nullptr, NumRoomIdxs);
+	TArray<FTransform> BoundsTransforms;
+	BoundsTransforms.Init(FTransform::Identity, NumRoomIdxs);
+	bHasRoom.Init(false, NumRoomIdxs);
+	RoomBounds.Init(FBox(ForceInit), NumRoomIdxs);
+	for (const FRoomLevel& RoomLevel : RoomLevels){
+		if(RoomLevel.RoomIdx < 0 || !RoomLevel.InRoom) continue;
+
+		const FReberuRoom& Room = RoomLevel.InRoom->Room;
+		BoundsTransforms[RoomLevel.RoomIdx] = GetBoundsTransform(RoomLevel);
+		RoomBounds[RoomLevel.RoomIdx] = FBox(-Room.BoxExtent, Room.BoxExtent).TransformBy(BoundsTransforms[RoomLevel.RoomIdx]);
+		Rooms[RoomLevel.RoomIdx] = &RoomLevel;
+		bHasRoom[RoomLevel.RoomIdx] = true;
+	}
+
+	// Every connection is stored from both rooms
+	TArray<FReberuRoomConnection> RoomConnections;
+	TArray<int32> ConnectionRooms;
+	auto AddConnection = [&](const int32 RoomIdx, const int32 DoorIdx, const int32 OtherRoomIdx, const bool bIsLoop){
+		if(OtherRoomIdx == RoomIdx || OtherRoomIdx == INDEX_NONE) return;
+		if(!IsValidRoom(OtherRoomIdx)){
+			bHasMissingRooms = true;
+			return;
+		}
+
+		const int32 OtherDoorIdx = DoorIdx != INDEX_NONE ? FindDoorAt(Rooms[OtherRoomIdx]->InRoom->Room, BoundsTransforms[OtherRoomIdx],
+			GetDoorLocation(Rooms[RoomIdx]->InRoom->Room, BoundsTransforms[RoomIdx], DoorIdx)) : INDEX_NONE;
+		RoomConnections.Add({OtherRoomIdx, DoorIdx, OtherDoorIdx, bIsLoop});
+		ConnectionRooms.Add(RoomIdx);
+		RoomConnections.Add({RoomIdx, OtherDoorIdx, DoorIdx, bIsLoop});
+		ConnectionRooms.Add(OtherRoomIdx);
+	};
+	for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+		if(!IsValidRoom(RoomIdx)) continue;
+
+		const FRoomLevel& RoomLevel = *Rooms[RoomIdx];
+		AddConnection(RoomIdx, RoomLevel.EntryDoorIdx, RoomLevel.ParentIndex, false);
+		for (int32 LoopIdx = 0; LoopIdx < RoomLevel.LoopDoorIdxs.Num() && LoopIdx < RoomLevel.LoopRoomIdxs.Num(); LoopIdx++){
+			AddConnection(RoomIdx, RoomLevel.LoopDoorIdxs[LoopIdx], RoomLevel.LoopRoomIdxs[LoopIdx], true);
+		}
+	}
+
+	// Counting sort of the connections by room
+	RoomFirstConnection.Init(0, NumRoomIdxs + 1);
+	for (const int32 RoomIdx : ConnectionRooms){
+		RoomFirstConnection[RoomIdx + 1]++;
+	}
+	for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+		RoomFirstConnection[RoomIdx + 1] += RoomFirstConnection[RoomIdx];
+	}
+	TArray<int32> NextConnection(RoomFirstConnection);
+	Connections.SetNum(RoomConnections.Num());
+	for (int32 ConnectionIdx = 0; ConnectionIdx < RoomConnections.Num(); ConnectionIdx++){
+		Connections[NextConnection[ConnectionRooms[ConnectionIdx]]++] = RoomConnections[ConnectionIdx];
+	}
+
+	if(NumRoomIdxs <= MaxTableRooms){
+		HopTable.SetNumUninitialized(NumRoomIdxs * NumRoomIdxs);
+		for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+			ComputeDistancesFrom(RoomIdx, HopTable.GetData() + RoomIdx * NumRoomIdxs);
+		}
+		return;
+	}
+
+	// Depths by going down the room tree from every room without a parent
+	RoomDepths.Init(INDEX_NONE, NumRoomIdxs);
+	TArray<int32> Parents;
+	Parents.Init(INDEX_NONE, NumRoomIdxs);
+	TArray<int32> Queue;
+	for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+		if(!IsValidRoom(RoomIdx)) continue;
+
+		const int32 ParentIdx = Rooms[RoomIdx]->ParentIndex;
+		if(IsValidRoom(ParentIdx) && ParentIdx != RoomIdx){
+			Parents[RoomIdx] = ParentIdx;
+		}
+		else{
+			RoomDepths[RoomIdx] = 0;
+			Queue.Add(RoomIdx);
+		}
+	}
+	for (int32 QueueIdx = 0; QueueIdx < Queue.Num(); QueueIdx++){
+		const int32 RoomIdx = Queue[QueueIdx];
+		for (const FReberuRoomConnection& Connection : GetConnections(RoomIdx)){
+			if(Connection.bIsLoop || Parents[Connection.RoomIdx] != RoomIdx || RoomDepths[Connection.RoomIdx] != INDEX_NONE) continue;
+			RoomDepths[Connection.RoomIdx] = RoomDepths[RoomIdx] + 1;
+			Queue.Add(Connection.RoomIdx);
+		}
+	}
+
+	// Stored by room, so rooms added by UpdateRoom only append their ancestors
+	NumAncestorLevels = FMath::FloorLog2(NumRoomIdxs) + 1;
+	Ancestors.SetNumUninitialized(NumRoomIdxs * NumAncestorLevels);
+	for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+		Ancestors[RoomIdx * NumAncestorLevels] = Parents[RoomIdx];
+	}
+	for (int32 Level = 1; Level < NumAncestorLevels; Level++){
+		for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+			const int32 PreviousAncestor = GetAncestor(RoomIdx, Level - 1);
+			Ancestors[RoomIdx * NumAncestorLevels + Level] = PreviousAncestor != INDEX_NONE ? GetAncestor(PreviousAncestor, Level - 1) : INDEX_NONE;
+		}
+	}
+
+	// A shortest path either stays in the tree or goes through a loop connection, and so through one of its rooms
+	for (const FReberuRoomConnection& Connection : Connections){
+		if(Connection.bIsLoop) Landmarks.AddUnique(Connection.RoomIdx);
+	}
+	if(Landmarks.Num() > MaxLandmarks){
+		Landmarks.SetNum(MaxLandmarks);
+		bDistancesExact = false;
+	}
+	LandmarkDistances.SetNumUninitialized(NumRoomIdxs * Landmarks.Num());
+	TArray<uint16> Distances;
+	Distances.SetNumUninitialized(NumRoomIdxs);
+	for (int32 LandmarkIdx = 0; LandmarkIdx < Landmarks.Num(); LandmarkIdx++){
+		ComputeDistancesFrom(Landmarks[LandmarkIdx], Distances.GetData());
+		for (int32 RoomIdx = 0; RoomIdx < NumRoomIdxs; RoomIdx++){
+			LandmarkDistances[RoomIdx * Landmarks.Num() + LandmarkIdx] = Distances[RoomIdx];
+		}
+	}
+}
+
+bool FReberuRoomGraph::UpdateRoom(const ALevelGeneratorActor& LevelGenerator, const int32 RoomIdx){
+	const FRoomLevel* RoomLevel = LevelGenerator.GetRoomLevel(RoomIdx);
+	if(!RoomLevel || !RoomLevel->InRoom || RoomLevel->LoopRoomIdxs.Num() > 0 || RoomFirstConnection.Num() != NumRooms() + 1) return false;
+
+	const int32 ParentIdx = RoomLevel->ParentIndex;
+	if(ParentIdx != INDEX_NONE && (ParentIdx == RoomIdx || !IsValidRoom(ParentIdx))) return false;
+
+	const FReberuRoom& Room = RoomLevel->InRoom->Room;
+	const FTransform BoundsTransform = GetBoundsTransform(*RoomLevel);
+	auto FindParentDoor = [&](){
+		const FRoomLevel* ParentLevel = LevelGenerator.GetRoomLevel(ParentIdx);
+		if(RoomLevel->EntryDoorIdx == INDEX_NONE || !ParentLevel || !ParentLevel->InRoom) return INDEX_NONE;
+		return FindDoorAt(ParentLevel->InRoom->Room, GetBoundsTransform(*ParentLevel), GetDoorLocation(Room, BoundsTransform, RoomLevel->EntryDoorIdx));
+	};
+
+	// Rooms that are already in the graph only change the doors of the connection to their parent, as long as they keep it and don't get loops
+	if(IsValidRoom(RoomIdx)){
+		int32 ParentConnectionIdx = INDEX_NONE;
+		for (int32 ConnectionIdx = RoomFirstConnection[RoomIdx]; ConnectionIdx < RoomFirstConnection[RoomIdx + 1]; ConnectionIdx++){
+			const FReberuRoomConnection& Connection = Connections[ConnectionIdx];
+			if(Connection.bIsLoop) return false;
+
+			if(Connection.RoomIdx == ParentIdx){
+				ParentConnectionIdx = ConnectionIdx;
+				continue;
+			}
+			const FRoomLevel* OtherLevel = LevelGenerator.GetRoomLevel(Connection.RoomIdx);
+			if(!OtherLevel || OtherLevel->ParentIndex != RoomIdx) return false;
+		}
+		if((ParentIdx != INDEX_NONE) != (ParentConnectionIdx != INDEX_NONE)) return false;
+		if(ParentConnectionIdx == INDEX_NONE) return true;
+
+		FReberuRoomConnection& ParentConnection = Connections[ParentConnectionIdx];
+		ParentConnection.DoorIdx = RoomLevel->EntryDoorIdx;
+		ParentConnection.OtherDoorIdx = FindParentDoor();
+		for (int32 ConnectionIdx = RoomFirstConnection[ParentIdx]; ConnectionIdx < RoomFirstConnection[ParentIdx + 1]; ConnectionIdx++){
+			FReberuRoomConnection& Connection = Connections[ConnectionIdx];
+			if(Connection.RoomIdx == RoomIdx && !Connection.bIsLoop){
+				Connection.DoorIdx = ParentConnection.OtherDoorIdx;
+				Connection.OtherDoorIdx = ParentConnection.DoorIdx;
+			}
+		}
+		return true;
+	}
+
+	// New rooms go in a free index or right after the last one. Past MaxTableRooms or the levels of the room tree the distances
+	// are stored differently, and rooms that were missing might already have connections waiting for them, so those are built again.
+	const int32 NumRoomIdxs = NumRooms();
+	const int32 NewNumRoomIdxs = FMath::Max(NumRoomIdxs, RoomIdx + 1);
+	const bool bHasTable = RoomDepths.Num() == 0;
+	if(RoomIdx > NumRoomIdxs || bHasMissingRooms) return false;
+	if(bHasTable ? NewNumRoomIdxs > MaxTableRooms : FMath::FloorLog2(NewNumRoomIdxs) + 1 > NumAncestorLevels) return false;
+
+	const FBox Bounds = FBox(-Room.BoxExtent, Room.BoxExtent).TransformBy(BoundsTransform);
+	if(RoomIdx == NumRoomIdxs){
+		bHasRoom.Add(true);
+		RoomBounds.Add(Bounds);
+		RoomFirstConnection.Add(Connections.Num());
+	}
+	else{
+		bHasRoom[RoomIdx] = true;
+		RoomBounds[RoomIdx] = Bounds;
+	}
+	if(ParentIdx != INDEX_NONE){
+		const int32 ParentDoorIdx = FindParentDoor();
+		InsertConnection(RoomIdx, {ParentIdx, RoomLevel->EntryDoorIdx, ParentDoorIdx, false});
+		InsertConnection(ParentIdx, {RoomIdx, ParentDoorIdx, RoomLevel->EntryDoorIdx, false});
+	}
+
+	// Every path from the room goes through its parent, so it is one hop further from everything
+	auto GetDistanceFromParent = [](const uint16 ParentDistance){
+		return ParentDistance != MAX_uint16 ? static_cast<uint16>(FMath::Min(ParentDistance + 1, MAX_uint16 - 1)) : MAX_uint16;
+	};
+	if(bHasTable){
+		if(RoomIdx == NumRoomIdxs){
+			// Every row of the table gets longer
+			const TArray<uint16> OldHopTable = MoveTemp(HopTable);
+			HopTable.Init(MAX_uint16, NewNumRoomIdxs * NewNumRoomIdxs);
+			for (int32 Row = 0; Row < NumRoomIdxs; Row++){
+				FMemory::Memcpy(HopTable.GetData() + Row * NewNumRoomIdxs, OldHopTable.GetData() + Row * NumRoomIdxs, NumRoomIdxs * sizeof(uint16));
+			}
+		}
+		for (int32 OtherRoomIdx = 0; OtherRoomIdx < NewNumRoomIdxs; OtherRoomIdx++){
+			const uint16 Distance = OtherRoomIdx == RoomIdx ? 0
+				: ParentIdx != INDEX_NONE ? GetDistanceFromParent(HopTable[ParentIdx * NewNumRoomIdxs + OtherRoomIdx]) : MAX_uint16;
+			HopTable[RoomIdx * NewNumRoomIdxs + OtherRoomIdx] = Distance;
+			HopTable[OtherRoomIdx * NewNumRoomIdxs + RoomIdx] = Distance;
+		}
+		return true;
+	}
+
+	if(RoomIdx == NumRoomIdxs){
+		RoomDepths.Add(INDEX_NONE);
+		Ancestors.AddUninitialized(NumAncestorLevels);
+		LandmarkDistances.AddUninitialized(Landmarks.Num());
+	}
+	RoomDepths[RoomIdx] = ParentIdx == INDEX_NONE ? 0 : RoomDepths[ParentIdx] != INDEX_NONE ? RoomDepths[ParentIdx] + 1 : INDEX_NONE;
+	int32* RoomAncestors = Ancestors.GetData() + RoomIdx * NumAncestorLevels;
+	RoomAncestors[0] = ParentIdx;
+	for (int32 Level = 1; Level < NumAncestorLevels; Level++){
+		RoomAncestors[Level] = RoomAncestors[Level - 1] != INDEX_NONE ? GetAncestor(RoomAncestors[Level - 1], Level - 1) : INDEX_NONE;
+	}
+	for (int32 LandmarkIdx = 0; LandmarkIdx < Landmarks.Num(); LandmarkIdx++){
+		LandmarkDistances[RoomIdx * Landmarks.Num() + LandmarkIdx] = ParentIdx != INDEX_NONE
+			? GetDistanceFromParent(LandmarkDistances[ParentIdx * Landmarks.Num() + LandmarkIdx]) : MAX_uint16;
+	}
+	return true;
+}
+
+void FReberuRoomGraph::InsertConnection(const int32 RoomIdx, const FReberuRoomConnection& Connection){
+	Connections.Insert(Connection, RoomFirstConnection[RoomIdx + 1]);
+	for (int32 NextRoomIdx = RoomIdx + 1; NextRoomIdx < RoomFirstConnection.Num(); NextRoomIdx++){
+		RoomFirstConnection[NextRoomIdx]++;
+	}
+}
+
+TConstArrayView<FReberuRoomConnection> FReberuRoomGraph::GetConnections(const int32 RoomIdx) const{
+	if(!RoomFirstConnection.IsValidIndex(RoomIdx + 1)) return TConstArrayView<FReberuRoomConnection>();
+
+	return TConstArrayView<FReberuRoomConnection>(Connections.GetData() + RoomFirstConnection[RoomIdx], RoomFirstConnection[RoomIdx + 1] - RoomFirstConnection[RoomIdx]);
+}
+
+void FReberuRoomGraph::ComputeDistancesFrom(const int32 RoomIdx, uint16* OutDistances) const{
+	for (int32 OtherRoomIdx = 0; OtherRoomIdx < NumRooms(); OtherRoomIdx++){
+		OutDistances[OtherRoomIdx] = MAX_uint16;
+	}
+	if(!IsValidRoom(RoomIdx)) return;
+
+	TArray<int32> Queue;
+	Queue.Add(RoomIdx);
+	OutDistances[RoomIdx] = 0;
+	for (int32 QueueIdx = 0; QueueIdx < Queue.Num(); QueueIdx++){
+		const int32 CurrentIdx = Queue[QueueIdx];
+		for (const FReberuRoomConnection& Connection : GetConnections(CurrentIdx)){
+			if(OutDistances[Connection.RoomIdx] != MAX_uint16) continue;
+			OutDistances[Connection.RoomIdx] = OutDistances[CurrentIdx] + 1;
+			Queue.Add(Connection.RoomIdx);
+		}
+	}
+}
+
+uint16 FReberuRoomGraph::GetTreeDistance(int32 FromRoomIdx, int32 ToRoomIdx) const{
+	if(RoomDepths[FromRoomIdx] < RoomDepths[ToRoomIdx]){
+		Swap(FromRoomIdx, ToRoomIdx);
+	}
+	const int32 Distance = RoomDepths[FromRoomIdx] + RoomDepths[ToRoomIdx];
+
+	// Bring both rooms to the same depth, then go up until right below their closest common ancestor
+	for (int32 Level = 0, DepthDifference = RoomDepths[FromRoomIdx] - RoomDepths[ToRoomIdx]; DepthDifference > 0; Level++, DepthDifference >>= 1){
+		if(DepthDifference & 1) FromRoomIdx = GetAncestor(FromRoomIdx, Level);
+	}
+	if(FromRoomIdx != ToRoomIdx){
+		for (int32 Level = NumAncestorLevels - 1; Level >= 0; Level--){
+			const int32 FromAncestor = GetAncestor(FromRoomIdx, Level);
+			const int32 ToAncestor = GetAncestor(ToRoomIdx, Level);
+			if(FromAncestor != ToAncestor){
+				FromRoomIdx = FromAncestor;
+				ToRoomIdx = ToAncestor;
+			}
+		}
+		FromRoomIdx = GetAncestor(FromRoomIdx, 0);
+		if(FromRoomIdx == INDEX_NONE) return MAX_uint16;
+	}
+	return static_cast<uint16>(FMath::Min(Distance - 2 * RoomDepths[FromRoomIdx], MAX_uint16 - 1));
+}
+
+int32 FReberuRoomGraph::GetHopDistance(const int32 FromRoomIdx, const int32 ToRoomIdx) const{
+	if(!IsValidRoom(FromRoomIdx) || !IsValidRoom(ToRoomIdx)) return INDEX_NONE;
+
+	const int32 NumRoomIdxs = NumRooms();
+	if(HopTable.Num() > 0){
+		const uint16 Distance = HopTable[FromRoomIdx * NumRoomIdxs + ToRoomIdx];
+		return Distance != MAX_uint16 ? Distance : INDEX_NONE;
+	}
+
+	int32 Distance = RoomDepths[FromRoomIdx] != INDEX_NONE && RoomDepths[ToRoomIdx] != INDEX_NONE ? GetTreeDistance(FromRoomIdx, ToRoomIdx) : MAX_uint16;
+	for (int32 LandmarkIdx = 0; LandmarkIdx < Landmarks.Num(); LandmarkIdx++){
+		const uint16 FromDistance = LandmarkDistances[FromRoomIdx * Landmarks.Num() + LandmarkIdx];
+		const uint16 ToDistance = LandmarkDistances[ToRoomIdx * Landmarks.Num() + LandmarkIdx];
+		if(FromDistance != MAX_uint16 && ToDistance != MAX_uint16){
+			Distance = FMath::Min<int32>(Distance, FromDistance + ToDistance);
+		}
+	}
+	return Distance < MAX_uint16 ? Distance : INDEX_NONE;
+}
+
+bool FReberuRoomGraph::GetRoomsBetween(const int32 FromRoomIdx, const int32 ToRoomIdx, TArray<int32>& OutRooms) const{
+	OutRooms.Reset();
+	if(GetHopDistance(FromRoomIdx, ToRoomIdx) == INDEX_NONE) return false;
+
+	// Distances are only an upper bound without bDistancesExact, then they come from a search from the destination instead
+	TArray<uint16> ToDistances;
+	if(!bDistancesExact){
+		ToDistances.SetNumUninitialized(NumRooms());
+		ComputeDistancesFrom(ToRoomIdx, ToDistances.GetData());
+	}
+	auto GetDistanceTo = [&](const int32 RoomIdx){
+		return bDistancesExact ? GetHopDistance(RoomIdx, ToRoomIdx) : ToDistances[RoomIdx];
+	};
+
+	// Every step goes to a connected room one hop closer
+	OutRooms.Add(FromRoomIdx);
+	for (int32 CurrentIdx = FromRoomIdx; CurrentIdx != ToRoomIdx;){
+		const int32 CurrentDistance = GetDistanceTo(CurrentIdx);
+		const FReberuRoomConnection* NextConnection = GetConnections(CurrentIdx).FindByPredicate([&](const FReberuRoomConnection& Connection){
+			return GetDistanceTo(Connection.RoomIdx) == CurrentDistance - 1;
+		});
+		if(!NextConnection){
+			OutRooms.Reset();
+			return false;
+		}
+		CurrentIdx = NextConnection->RoomIdx;
+		OutRooms.Add(CurrentIdx);
+	}
+	return true;
+}
+
+SIZE_T FReberuRoomGraph::GetAllocatedSize() const{
+	return bHasRoom.GetAllocatedSize() + RoomBounds.GetAllocatedSize() + RoomFirstConnection.GetAllocatedSize() + Connections.GetAllocatedSize()
+		+ HopTable.GetAllocatedSize() + RoomDepths.GetAllocatedSize() + Ancestors.GetAllocatedSize() + Landmarks.GetAllocatedSize() + LandmarkDistances.GetAllocatedSize();
+}
@@ -2,3 +2,20 @@
 
 
 #include "Data/ReberuRule.h"
+
+void UReberuRule::PostInitProperties(){
+	Super::PostInitProperties();
+
+	bHasScriptImplementation = GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(UReberuRule, ShouldPlaceRoom));
+}
+
+bool UReberuRule::ShouldPlaceRoom_Implementation(UReberuRoomData* OwningRoom, UReberuRoomData* ConnectingRoom){
+	return true;
+}
+
+bool UReberuRule::EvaluateRule(UReberuRoomData* OwningRoom, UReberuRoomData* ConnectingRoom){
+	if(bHasScriptImplementation){
+		return ShouldPlaceRoom(OwningRoom, ConnectingRoom);
+	}
+	return ShouldPlaceRoom_Implementation(OwningRoom, ConnectingRoom);
+}
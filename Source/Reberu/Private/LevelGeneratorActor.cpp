@@ -5,14 +5,30 @@
 
 #include "Reberu.h"
 #include "RoomBounds.h"
+#include "Component/ReberuPlayerComponent.h"
 #include "Components/BillboardComponent.h"
 #include "Components/BoxComponent.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Data/ReberuData.h"
 #include "Data/ReberuRoomData.h"
+#include "Data/ReberuRule.h"
 #include "Engine/LevelStreamingDynamic.h"
+#include "Components/LineBatchComponent.h"
 #include "Engine/OverlapResult.h"
+#include "EngineUtils.h"
+#include "Algo/Accumulate.h"
+#include "Algo/BinarySearch.h"
+#include "Algo/StableSort.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "LevelUtils.h"
+#include "Misc/Compression.h"
+#include "TimerManager.h"
 #include "Net/UnrealNetwork.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Task/FinalizeRoomsTask.h"
+#include "Task/GenerateRoomsTask.h"
+#include "Subsystem/ReberuGenerationSubsystem.h"
 
 ALevelGeneratorActor::ALevelGeneratorActor(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
 {
@@ -24,6 +40,7 @@ ALevelGeneratorActor::ALevelGeneratorActor(const FObjectInitializer& ObjectIniti
 	SetRootComponent(SceneComponent);
 
 	bReplicates = true;
+	SpawnedRoomLevels.LevelGenerator = this;
 
 	// Structure to hold one-time initialization
     struct FConstructorStatics
@@ -56,6 +73,13 @@ ALevelGeneratorActor::ALevelGeneratorActor(const FObjectInitializer& ObjectIniti
 		SpriteComponent->Mobility = EComponentMobility::Static;
 		SpriteComponent->SetupAttachment(RootComponent);
 	}
+
+	PreviewLineBatcher = CreateEditorOnlyDefaultSubobject<ULineBatchComponent>(TEXT("PreviewLines"));
+	if (PreviewLineBatcher)
+	{
+		PreviewLineBatcher->SetupAttachment(RootComponent);
+		PreviewLineBatcher->SetHiddenInGame(true);
+	}
 #endif
 }
 
@@ -86,21 +110,44 @@ bool ALevelGeneratorActor::CanStartGeneration() const{
 	return true;
 }
 
-ULevelStreamingDynamic* ALevelGeneratorActor::SpawnRoom(UReberuRoomData* InRoom, const FTransform& SpawnTransform, FString LevelName){
+ULevelStreamingDynamic* ALevelGeneratorActor::SpawnRoom(UReberuRoomData* InRoom, const FTransform& SpawnTransform, FString LevelName, const int32 ParentIndex, const int32 RoomIdx){
 	if(!GetWorld() || !InRoom) return nullptr;
 
 	bool bSpawnedSuccessfully = false;
 
 	// Check if there is already a level with this name:
 	if (LocalSpawnedLevels.Contains(LevelName)) {return nullptr;}
-	
-	ULevelStreamingDynamic* SpawnedRoom = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(this, InRoom->Room.Level, SpawnTransform,
-		bSpawnedSuccessfully, LevelName);
+
+	ULevelStreamingDynamic* SpawnedRoom = AcquirePooledRoom(InRoom, SpawnTransform);
+	if(SpawnedRoom){
+		bSpawnedSuccessfully = true;
+	}
+	else{
+		SpawnedRoom = ULevelStreamingDynamic::LoadLevelInstanceBySoftObjectPtr(this, InRoom->Room.Level, SpawnTransform,
+			bSpawnedSuccessfully, LevelName);
+	}
 
 	if(!bSpawnedSuccessfully) REBERU_LOG_ARGS(Warning, "SpawnRoom failed spawning room with name %s %d", *InRoom->RoomName.ToString(), HasAuthority())
 
-	if(HasAuthority()){
-		SpawnedRoomLevels.Add(FRoomLevel(InRoom, SpawnTransform, LevelName));
+	if(SpawnedRoom){
+		LocalSpawnedLevels.Add(LevelName, SpawnedRoom);
+		RoomLevelSources.Add(SpawnedRoom, InRoom->Room.Level.ToSoftObjectPath());
+	}
+
+	if(ShouldRecordRoomLevels()){
+		const int32 CatalogIdx = ActiveReberuData ? ActiveReberuData->GetRoomIndex(InRoom) : INDEX_NONE;
+		if(CatalogIdx == INDEX_NONE) REBERU_LOG_ARGS(Warning, "Room %s isn't part of the active ReberuData, clients won't be able to spawn it.", *InRoom->RoomName.ToString())
+
+		const int32 NewRoomIdx = RoomIdx != INDEX_NONE ? RoomIdx : SpawnedRoomLevels.Items.Num();
+		// The catalog analysis keeps generations within the limits, this catches anything else that spawns rooms
+		if(NewRoomIdx >= UReberuData::MaxLayoutRooms || CatalogIdx >= UReberuData::MaxLayoutRooms){
+			REBERU_LOG_ARGS(Error, "Room %d (catalog index %d) is past the %d rooms a layout can replicate, clients won't spawn it.", NewRoomIdx, CatalogIdx, UReberuData::MaxLayoutRooms)
+			return SpawnedRoom;
+		}
+		FRoomLevel& RoomLevel = SpawnedRoomLevels.Items.Add_GetRef(FRoomLevel(InRoom, CatalogIdx, SpawnTransform, LevelName, NewRoomIdx, ParentIndex));
+		SetRoomLevelItemIdx(NewRoomIdx, SpawnedRoomLevels.Items.Num() - 1);
+		SpawnedRoomLevels.MarkItemDirty(RoomLevel);
+		MarkRoomLevelChanged(NewRoomIdx);
 	}
 	
 	return SpawnedRoom;
@@ -110,52 +157,247 @@ void ALevelGeneratorActor::DespawnRoom(ULevelStreamingDynamic* SpawnedRoom){
 	SpawnedRoom->SetIsRequestingUnloadAndRemoval(true);
 }
 
+void ALevelGeneratorActor::ReleaseRoom(ULevelStreamingDynamic* SpawnedRoom){
+	if(!SpawnedRoom) return;
+
+	FSoftObjectPath RoomLevelSource;
+	RoomLevelSources.RemoveAndCopyValue(SpawnedRoom, RoomLevelSource);
+
+	if(!bPoolRoomLevels || RoomLevelSource.IsNull()){
+		DespawnRoom(SpawnedRoom);
+		return;
+	}
+
+	// Hide it so it doesn't collide with the next generation, but keep it loaded so it can be moved and shown again.
+	SpawnedRoom->SetShouldBeVisible(false);
+	RoomLevelPool.FindOrAdd(RoomLevelSource).Levels.Add(SpawnedRoom);
+
+	// The server flushes when finalize is done, clients flush once the server stopped sending rooms for a while.
+	if(!HasAuthority() && GetWorld()){
+		GetWorldTimerManager().SetTimer(PoolFlushTimerHandle, this, &ALevelGeneratorActor::FlushRoomLevelPool, ClientPoolFlushDelay);
+	}
+}
+
+void ALevelGeneratorActor::FlushRoomLevelPool(){
+	int32 FlushedLevels = 0;
+	for(TTuple<FSoftObjectPath, FReberuPooledLevels>& PoolEntry : RoomLevelPool){
+		for(ULevelStreamingDynamic* PooledLevel : PoolEntry.Value.Levels){
+			if(PooledLevel){
+				DespawnRoom(PooledLevel);
+				FlushedLevels++;
+			}
+		}
+	}
+	RoomLevelPool.Empty();
+
+	if(FlushedLevels > 0){
+		REBERU_LOG_ARGS(Log, "Unloaded %d pooled room levels that weren't reused.", FlushedLevels)
+	}
+}
+
+ULevelStreamingDynamic* ALevelGeneratorActor::AcquirePooledRoom(const UReberuRoomData* InRoom, const FTransform& SpawnTransform){
+	if(!bPoolRoomLevels) return nullptr;
+
+	FReberuPooledLevels* PooledLevels = RoomLevelPool.Find(InRoom->Room.Level.ToSoftObjectPath());
+	if(!PooledLevels) return nullptr;
+
+	PooledLevels->Levels.RemoveAll([](const ULevelStreamingDynamic* PooledLevel){ return !IsValid(PooledLevel); });
+	if(PooledLevels->Levels.IsEmpty()) return nullptr;
+
+	// Rooms regenerated with the same seed usually end up at the same spot, so try to find one that doesn't need to move.
+	int32 ChosenIdx = PooledLevels->Levels.IndexOfByPredicate([&SpawnTransform](const ULevelStreamingDynamic* PooledLevel){
+		return PooledLevel->LevelTransform.Equals(SpawnTransform);
+	});
+	if(ChosenIdx == INDEX_NONE){
+		ChosenIdx = PooledLevels->Levels.Num() - 1;
+	}
+
+	ULevelStreamingDynamic* PooledLevel = PooledLevels->Levels[ChosenIdx];
+	PooledLevels->Levels.RemoveAtSwap(ChosenIdx);
+
+	MoveRoomLevel(PooledLevel, SpawnTransform);
+	PooledLevel->SetShouldBeLoaded(true);
+	PooledLevel->SetShouldBeVisible(true);
+
+	REBERU_LOG_ARGS(Verbose, "Reusing pooled level %s for room %s", *PooledLevel->GetWorldAssetPackageName(), *InRoom->RoomName.ToString())
+	return PooledLevel;
+}
+
+void ALevelGeneratorActor::MoveRoomLevel(ULevelStreamingDynamic* RoomLevel, const FTransform& NewTransform){
+	if(RoomLevel->LevelTransform.Equals(NewTransform)) return;
+
+	// If the actors were already moved by the old transform we have to move them by the difference ourselves,
+	// otherwise the new transform gets applied when the level is added to the world.
+	ULevel* LoadedLevel = RoomLevel->GetLoadedLevel();
+	if(LoadedLevel && LoadedLevel->bAlreadyMovedActors){
+		const FTransform DeltaTransform = RoomLevel->LevelTransform.Inverse() * NewTransform;
+		FLevelUtils::ApplyLevelTransform(LoadedLevel, DeltaTransform, LoadedLevel->bIsVisible);
+	}
+	RoomLevel->LevelTransform = NewTransform;
+}
+
+FString ALevelGeneratorActor::MakeRoomLevelName(const UReberuRoomData* InRoom, const int32 RoomIdx) const{
+	return FString::Printf(TEXT("%s%d_%d"), *InRoom->RoomName.ToString(), RoomIdx, GenerationId);
+}
+
+FRoomLevel* ALevelGeneratorActor::FindRoomLevel(const int32 RoomIdx){
+	TArray<FRoomLevel>& Items = SpawnedRoomLevels.Items;
+	if(RoomIdx < 0) return nullptr;
+
+	int32 ItemIdx = RoomLevelItemIdxs.IsValidIndex(RoomIdx) ? RoomLevelItemIdxs[RoomIdx] : INDEX_NONE;
+	if(Items.IsValidIndex(ItemIdx) && Items[ItemIdx].RoomIdx == RoomIdx) return &Items[ItemIdx];
+	if(ItemIdx == INDEX_NONE && !bRoomLevelItemIdxsDirty) return nullptr;
+
+	// Replication added or moved items since the map was built
+	RebuildRoomLevelItemIdxs();
+	ItemIdx = RoomLevelItemIdxs.IsValidIndex(RoomIdx) ? RoomLevelItemIdxs[RoomIdx] : INDEX_NONE;
+	return ItemIdx != INDEX_NONE ? &Items[ItemIdx] : nullptr;
+}
+
+void ALevelGeneratorActor::SetRoomLevelItemIdx(const int32 RoomIdx, const int32 ItemIdx){
+	if(RoomIdx < 0) return;
+
+	while (RoomLevelItemIdxs.Num() <= RoomIdx){
+		RoomLevelItemIdxs.Add(INDEX_NONE);
+	}
+	RoomLevelItemIdxs[RoomIdx] = ItemIdx;
+}
+
+void ALevelGeneratorActor::RebuildRoomLevelItemIdxs(){
+	bRoomLevelItemIdxsDirty = false;
+	RoomLevelItemIdxs.Reset();
+	for (int32 ItemIdx = 0; ItemIdx < SpawnedRoomLevels.Items.Num(); ItemIdx++){
+		SetRoomLevelItemIdx(SpawnedRoomLevels.Items[ItemIdx].RoomIdx, ItemIdx);
+	}
+}
+
+const FRoomLevel* ALevelGeneratorActor::GetRoomLevel(const int32 RoomIdx) const{
+	return const_cast<ALevelGeneratorActor*>(this)->FindRoomLevel(RoomIdx);
+}
+
+ULevelStreamingDynamic* ALevelGeneratorActor::GetRoomLevelInstance(const int32 RoomIdx) const{
+	const FRoomLevel* RoomLevel = GetRoomLevel(RoomIdx);
+	if(!RoomLevel) return nullptr;
+
+	ULevelStreamingDynamic* const* SpawnedLevel = LocalSpawnedLevels.Find(RoomLevel->LevelName);
+	return SpawnedLevel ? *SpawnedLevel : nullptr;
+}
+
+FTransform ALevelGeneratorActor::GetRoomBoundsTransform(const int32 RoomIdx) const{
+	const FRoomLevel* RoomLevel = GetRoomLevel(RoomIdx);
+	if(!RoomLevel || !RoomLevel->InRoom) return FTransform::Identity;
+
+	// The level is spawned at (level offset * bounds transform), so undo the offset to get the bounds back.
+	return RoomLevel->InRoom->Room.GetLevelOffsetTransform().Inverse() * RoomLevel->SpawnTransform;
+}
+
+void ALevelGeneratorActor::MarkRoomLevelsChanged(){
+	bRoomGraphDirty = true;
+	ChangedRoomIdxs.Reset();
+	RoomLevelsVersion++;
+}
+
+void ALevelGeneratorActor::MarkRoomLevelChanged(const int32 RoomIdx){
+	if(bRoomGraphDirty || ChangedRoomIdxs.Num() >= MaxChangedRooms){
+		MarkRoomLevelsChanged();
+		return;
+	}
+	ChangedRoomIdxs.Add(RoomIdx);
+	RoomLevelsVersion++;
+}
+
+const FReberuRoomGraph& ALevelGeneratorActor::GetRoomGraph() const{
+	if(!bRoomGraphDirty && ChangedRoomIdxs.Num() > 0){
+		for (const int32 RoomIdx : ChangedRoomIdxs){
+			if(!RoomGraph.UpdateRoom(*this, RoomIdx)){
+				bRoomGraphDirty = true;
+				break;
+			}
+		}
+		ChangedRoomIdxs.Reset();
+		RoomGraphVersion++;
+	}
+	if(bRoomGraphDirty){
+		bRoomGraphDirty = false;
+		RoomGraph.Build(*this);
+		RoomGraphVersion++;
+	}
+	return RoomGraph;
+}
+
+const FReberuNavGraph& ALevelGeneratorActor::GetNavGraph() const{
+	const FReberuRoomGraph& CurrentRoomGraph = GetRoomGraph();
+	if(NavGraphVersion != RoomGraphVersion){
+		NavGraphVersion = RoomGraphVersion;
+		NavGraph.Build(*this, CurrentRoomGraph);
+	}
+	return NavGraph;
+}
+
+bool ALevelGeneratorActor::FindNavigationPath(const FVector& Start, const FVector& End, TArray<FVector>& OutPath) const{
+	return GetNavGraph().FindPath(Start, End, OutPath);
+}
+
+int32 ALevelGeneratorActor::GetRoomHopDistance(const int32 FromRoomIdx, const int32 ToRoomIdx) const{
+	return GetRoomGraph().GetHopDistance(FromRoomIdx, ToRoomIdx);
+}
+
+bool ALevelGeneratorActor::GetRoomsBetween(const int32 FromRoomIdx, const int32 ToRoomIdx, TArray<int32>& OutRooms) const{
+	return GetRoomGraph().GetRoomsBetween(FromRoomIdx, ToRoomIdx, OutRooms);
+}
+
 AActor* ALevelGeneratorActor::SpawnDoor(UReberuData* ReberuData, ARoomBounds* TargetRoomBounds, FString DoorId, bool bIsOrphaned){
 	if(DoorId.IsEmpty()) return nullptr;
 	
-	FReberuDoor ReberuDoor = *TargetRoomBounds->Room.GetDoorById(DoorId);
-	if(!HasAuthority()) return nullptr;
+	const FReberuDoor ReberuDoor = *TargetRoomBounds->Room.GetDoorById(DoorId);
+	return SpawnDoor(ReberuData, ReberuDoor, TargetRoomBounds->GetActorTransform(), bIsOrphaned);
+}
 
+AActor* ALevelGeneratorActor::SpawnDoor(UReberuData* ReberuData, const FReberuDoor& ReberuDoor, const FTransform& RoomBoundsTransform, const bool bIsOrphaned, int32* OutInstanceIdx){
 	UWorld* World = GetWorld();
 	if (!World) return nullptr;
 
-	FTransform LastRoomTransform = TargetRoomBounds->GetActorTransform();
-	FVector RotatedFromDoorExtent = UKismetMathLibrary::Quat_RotateVector(
-		ReberuDoor.DoorTransform.GetRotation(),
-		FVector(ReberuDoor.BoxExtent.X, 0.f, -ReberuDoor.BoxExtent.Z));
-	ReberuDoor.DoorTransform.SetLocation(ReberuDoor.DoorTransform.GetLocation() + RotatedFromDoorExtent);
-	FTransform LastRoomDoorTransform = ReberuDoor.DoorTransform * LastRoomTransform;
+	const FTransform LastRoomDoorTransform = GetDoorWorldTransform(ReberuDoor, RoomBoundsTransform);
 	
 	FActorSpawnParameters SpawnParams;
 	SpawnParams.Owner = this;
 
-	FReberuDoorInfo* DoorInfo = nullptr;
-	if (ReberuDoor.DoorTag.IsValid()){
-		DoorInfo = ReberuData->DoorMap.Find(ReberuDoor.DoorTag);
-	}
-	else if (ReberuData->DoorMap.Contains(ReberuEmptyDoorTag)){
-		DoorInfo = ReberuData->DoorMap.Find(ReberuEmptyDoorTag);
-	}
-	else{
+	const FReberuDoorInfo* DoorInfo = FindDoorInfo(ReberuData, ReberuDoor);
+	if(!DoorInfo){
+		if(ReberuDoor.DoorTag.IsValid()){
+			REBERU_LOG_ARGS(Warning, "No door found in door map with the tag: %s", *ReberuDoor.DoorTag.ToString())
+		}
 		return nullptr;
 	}
 
-	if(!DoorInfo){
-		REBERU_LOG_ARGS(Warning, "No door found in door map with the tag: %s", *ReberuDoor.DoorTag.ToString())
+	// Instanced doors don't get an actor, clients add their own instances when the room is replicated or generated locally.
+	if(DoorInfo->ShouldInstance(bIsOrphaned)){
+		const int32 InstanceIdx = AddDoorInstance(ReberuDoor.DoorTag, *DoorInfo, LastRoomDoorTransform, bIsOrphaned);
+		if(OutInstanceIdx) *OutInstanceIdx = InstanceIdx;
 		return nullptr;
 	}
 
-	if(!bIsOrphaned && !DoorInfo->DoorActor->IsValidLowLevel()){
+	// Door actors are replicated by the server
+	if(!HasAuthority()) return nullptr;
+
+	if(!bIsOrphaned && DoorInfo->DoorActor.IsNull()){
 		REBERU_LOG_ARGS(Warning, "No door actor found in door map with the tag: %s", *ReberuDoor.DoorTag.ToString())
 		return nullptr;
 	}
 
-	if(bIsOrphaned && !DoorInfo->BlockedDoorActor->IsValidLowLevel()){
+	if(bIsOrphaned && DoorInfo->BlockedDoorActor.IsNull()){
 		REBERU_LOG_ARGS(Warning, "No blocked door found in door map with the tag: %s", *ReberuDoor.DoorTag.ToString())
 		return nullptr;
 	}
 
-	TSubclassOf<AActor> DoorActorClass = bIsOrphaned ? DoorInfo->BlockedDoorActor : DoorInfo->DoorActor;
+	// Should already be loaded by the finalize task, load it now otherwise
+	const TSoftClassPtr<AActor>& DoorActorPtr = bIsOrphaned ? DoorInfo->BlockedDoorActor : DoorInfo->DoorActor;
+	TSubclassOf<AActor> DoorActorClass = DoorActorPtr.Get();
+	if(!DoorActorClass){
+		REBERU_LOG_ARGS(Verbose, "Door class %s wasn't preloaded, loading it synchronously.", *DoorActorPtr.ToString())
+		DoorActorClass = DoorActorPtr.LoadSynchronous();
+	}
+	if(!DoorActorClass) return nullptr;
 	
 	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 	AActor* SpawnedDoor = World->SpawnActor<AActor>(DoorActorClass, LastRoomDoorTransform, SpawnParams);
@@ -163,25 +405,460 @@ AActor* ALevelGeneratorActor::SpawnDoor(UReberuData* ReberuData, ARoomBounds* Ta
 	return SpawnedDoor;
 }
 
+const FReberuDoorInfo* ALevelGeneratorActor::FindDoorInfo(const UReberuData* ReberuData, const FReberuDoor& Door){
+	return ReberuData ? ReberuData->FindDoorInfo(Door.DoorTag) : nullptr;
+}
+
+FTransform ALevelGeneratorActor::GetDoorWorldTransform(const FReberuDoor& Door, const FTransform& RoomBoundsTransform){
+	// The door transform is in the middle of its box, move it to the bottom center so door actors can be placed on the floor
+	FTransform DoorTransform = Door.DoorTransform;
+	const FVector RotatedDoorExtent = UKismetMathLibrary::Quat_RotateVector(
+		DoorTransform.GetRotation(),
+		FVector(Door.BoxExtent.X, 0.f, -Door.BoxExtent.Z));
+	DoorTransform.SetLocation(DoorTransform.GetLocation() + RotatedDoorExtent);
+	return DoorTransform * RoomBoundsTransform;
+}
+
+int32 ALevelGeneratorActor::AddDoorInstance(const FGameplayTag& DoorTag, const FReberuDoorInfo& DoorInfo, const FTransform& DoorWorldTransform, const bool bIsBlocked){
+	TMap<FGameplayTag, UHierarchicalInstancedStaticMeshComponent*>& InstancesMap = bIsBlocked ? BlockedDoorInstances : DoorInstances;
+
+	UHierarchicalInstancedStaticMeshComponent* Instances = InstancesMap.FindRef(DoorTag);
+	TArray<int32>* HiddenInstances = Instances ? HiddenDoorInstances.Find(Instances) : nullptr;
+	if(HiddenInstances && HiddenInstances->Num() > 0){
+		const int32 InstanceIdx = HiddenInstances->Pop(EAllowShrinking::No);
+		Instances->UpdateInstanceTransform(InstanceIdx, DoorInfo.MeshOffset * DoorWorldTransform, true, true);
+		return InstanceIdx;
+	}
+	if(!Instances){
+		Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+		Instances->SetMobility(EComponentMobility::Static);
+		Instances->SetStaticMesh((bIsBlocked ? DoorInfo.BlockedDoorMesh : DoorInfo.DoorMesh).LoadSynchronous());
+		Instances->SetupAttachment(RootComponent);
+		Instances->RegisterComponent();
+		InstancesMap.Add(DoorTag, Instances);
+	}
+
+	return Instances->AddInstance(DoorInfo.MeshOffset * DoorWorldTransform, true);
+}
+
+void ALevelGeneratorActor::HideDoorInstance(const FGameplayTag& DoorTag, const int32 InstanceIdx, const bool bIsBlocked){
+	UHierarchicalInstancedStaticMeshComponent* Instances = (bIsBlocked ? BlockedDoorInstances : DoorInstances).FindRef(DoorTag);
+	FTransform InstanceTransform;
+	if(!Instances || !Instances->GetInstanceTransform(InstanceIdx, InstanceTransform, true)) return;
+
+	InstanceTransform.SetScale3D(FVector::ZeroVector);
+	Instances->UpdateInstanceTransform(InstanceIdx, InstanceTransform, true, true);
+	HiddenDoorInstances.FindOrAdd(Instances).Add(InstanceIdx);
+}
+
+void ALevelGeneratorActor::ClearDoorInstances(){
+	for(TTuple<FGameplayTag, UHierarchicalInstancedStaticMeshComponent*>& Instances : DoorInstances){
+		if(Instances.Value) Instances.Value->DestroyComponent();
+	}
+	for(TTuple<FGameplayTag, UHierarchicalInstancedStaticMeshComponent*>& Instances : BlockedDoorInstances){
+		if(Instances.Value) Instances.Value->DestroyComponent();
+	}
+	DoorInstances.Empty();
+	BlockedDoorInstances.Empty();
+	HiddenDoorInstances.Empty();
+}
+
+void ALevelGeneratorActor::SetRoomDoors(const int32 RoomIdx, const int32 EntryDoorIdx, const TArray<int32>& BlockedDoorIdxs, const TArray<int32>& LoopDoorIdxs,
+	const TArray<int32>& LoopRoomIdxs){
+	if(!ShouldRecordRoomLevels()) return;
+
+	FRoomLevel* RoomLevel = FindRoomLevel(RoomIdx);
+	if(!RoomLevel) return;
+
+	// Rooms with more doors fail validation, their doors past MaxDoors aren't replicated
+	auto IsValidDoorIdx = [RoomIdx](const int32 DoorIdx){
+		if(DoorIdx >= 0 && DoorIdx < UReberuRoomData::MaxDoors) return true;
+
+		REBERU_LOG_ARGS(Error, "Door %d of room %d is past the %d doors a room can replicate.", DoorIdx, RoomIdx, UReberuRoomData::MaxDoors)
+		return false;
+	};
+	RoomLevel->EntryDoorIdx = EntryDoorIdx == INDEX_NONE || IsValidDoorIdx(EntryDoorIdx) ? EntryDoorIdx : INDEX_NONE;
+	RoomLevel->BlockedDoorIdxs.Reset(BlockedDoorIdxs.Num());
+	for (const int32 BlockedDoorIdx : BlockedDoorIdxs){
+		if(IsValidDoorIdx(BlockedDoorIdx)) RoomLevel->BlockedDoorIdxs.Add(static_cast<uint8>(BlockedDoorIdx));
+	}
+	RoomLevel->LoopDoorIdxs.Reset(LoopDoorIdxs.Num());
+	RoomLevel->LoopRoomIdxs.Reset(LoopRoomIdxs.Num());
+	for (int32 LoopIdx = 0; LoopIdx < LoopDoorIdxs.Num() && LoopIdx < LoopRoomIdxs.Num(); LoopIdx++){
+		if(!IsValidDoorIdx(LoopDoorIdxs[LoopIdx]) || LoopRoomIdxs[LoopIdx] < 0 || LoopRoomIdxs[LoopIdx] >= UReberuData::MaxLayoutRooms) continue;
+
+		RoomLevel->LoopDoorIdxs.Add(static_cast<uint8>(LoopDoorIdxs[LoopIdx]));
+		RoomLevel->LoopRoomIdxs.Add(static_cast<int16>(LoopRoomIdxs[LoopIdx]));
+	}
+	SpawnedRoomLevels.MarkItemDirty(*RoomLevel);
+	MarkRoomLevelChanged(RoomIdx);
+}
+
+void ALevelGeneratorActor::SpawnInstancedRoomDoors(const int32 RoomIdx){
+	const FRoomLevel* RoomLevel = GetRoomLevel(RoomIdx);
+	if(!RoomLevel || !RoomLevel->InRoom || !ActiveReberuData) return;
+
+	const TArray<FReberuDoor>& RoomDoors = RoomLevel->InRoom->Room.ReberuDoors;
+	const FTransform RoomBoundsTransform = GetRoomBoundsTransform(RoomIdx);
+
+	auto AddInstanceForDoor = [&](const int32 DoorIdx, const bool bIsBlocked){
+		if(!RoomDoors.IsValidIndex(DoorIdx)) return;
+
+		const FReberuDoorInfo* DoorInfo = FindDoorInfo(ActiveReberuData, RoomDoors[DoorIdx]);
+		if(DoorInfo && DoorInfo->ShouldInstance(bIsBlocked)){
+			AddDoorInstance(RoomDoors[DoorIdx].DoorTag, *DoorInfo, GetDoorWorldTransform(RoomDoors[DoorIdx], RoomBoundsTransform), bIsBlocked);
+		}
+	};
+
+	AddInstanceForDoor(RoomLevel->EntryDoorIdx, false);
+	for(const int32 BlockedDoorIdx : RoomLevel->BlockedDoorIdxs){
+		AddInstanceForDoor(BlockedDoorIdx, true);
+	}
+	for(const int32 LoopDoorIdx : RoomLevel->LoopDoorIdxs){
+		AddInstanceForDoor(LoopDoorIdx, false);
+	}
+}
+
 void ALevelGeneratorActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const{
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ALevelGeneratorActor, SpawnedRoomLevels);
+	// Only active in full replication mode, see PreReplication
+	DOREPLIFETIME_CONDITION(ALevelGeneratorActor, SpawnedRoomLevels, COND_Custom);
+	DOREPLIFETIME(ALevelGeneratorActor, ActiveReberuData);
+	DOREPLIFETIME(ALevelGeneratorActor, SeedLayout);
+	DOREPLIFETIME(ALevelGeneratorActor, LayoutSnapshotId);
+}
+
+void ALevelGeneratorActor::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker){
+	Super::PreReplication(ChangedPropertyTracker);
+
+	DOREPLIFETIME_ACTIVE_OVERRIDE_FAST(ALevelGeneratorActor, SpawnedRoomLevels, ReplicationMode == EReberuReplicationMode::Full);
+}
+
+void ALevelGeneratorActor::OnRoomsGenerated(UReberuData* ReberuData, const FTransform& StartRoomTransform){
+	if(!HasAuthority() || ReplicationMode != EReberuReplicationMode::Seed) return;
+
+	PendingSeedLayout.Seed = ReberuRandomStream.GetInitialSeed();
+	PendingSeedLayout.ReberuData = ReberuData;
+	PendingSeedLayout.StartTransform = StartRoomTransform;
+	PendingSeedLayout.LayoutChecksum = ComputeLayoutChecksum();
+}
+
+void ALevelGeneratorActor::OnRoomsFinalized(){
+	bRoomsFinalized = true;
+	if(!HasAuthority() || ReplicationMode == EReberuReplicationMode::Full) return;
+
+	// Seed clients also use snapshots when their layout doesn't match
+	LayoutSnapshotId = GenerationId + 1;
+	if(ReplicationMode != EReberuReplicationMode::Seed) return;
+
+	// We only send the seed once the rooms are finalized so a client falling back to full replication gets every room.
+	SeedLayout = PendingSeedLayout;
+	REBERU_LOG_ARGS(Log, "Replicating seed layout (seed %d, checksum %u)", SeedLayout.Seed, SeedLayout.LayoutChecksum)
+}
+
+uint32 ALevelGeneratorActor::ComputeLayoutChecksum() const{
+	uint32 Checksum = 0;
+	for (const FReberuMove& Move : MovesList){
+		if(!Move.RoomData || !Move.TargetRoomBounds) continue;
+
+		// Quantize the transform so tiny floating point differences between machines don't count as a different layout
+		const FTransform BoundsTransform = Move.TargetRoomBounds->GetActorTransform();
+		const FVector Location = BoundsTransform.GetLocation();
+		const FIntVector QuantizedLocation(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y), FMath::RoundToInt(Location.Z));
+		const int32 QuantizedYaw = FMath::RoundToInt(BoundsTransform.Rotator().Yaw);
+
+		Checksum = HashCombine(Checksum, FCrc::StrCrc32(*Move.RoomData->GetPathName()));
+		Checksum = HashCombine(Checksum, GetTypeHash(QuantizedLocation));
+		Checksum = HashCombine(Checksum, GetTypeHash(QuantizedYaw));
+		Checksum = HashCombine(Checksum, GetTypeHash(Move.SourceMoveIdx));
+		Checksum = HashCombine(Checksum, GetTypeHash(Move.SourceDoorIdx));
+		Checksum = HashCombine(Checksum, GetTypeHash(Move.TargetDoorIdx));
+		for (const int32 LoopDoorIdx : Move.LoopDoorIdxs){
+			Checksum = HashCombine(Checksum, GetTypeHash(LoopDoorIdx));
+		}
+	}
+	return Checksum;
+}
+
+void ALevelGeneratorActor::CompactGeneration(){
+	if(!bRoomsFinalized || bIsIncremental){
+		REBERU_LOG(Warning, "Only finalized layouts can be compacted, incremental generations need their search state for as long as they run.")
+		return;
+	}
+	const FReberuMemoryReport ReportBefore = GetMemoryReport();
+
+	for (FReberuMove& Move : MovesList){
+		// Finalize already copied the doors into the room levels
+		Move.AttemptedMoves.Empty();
+		Move.ClearUsedDoors();
+		Move.LoopDoorIdxs.Empty();
+		Move.LoopMoveIdxs.Empty();
+		Move.SpawnedBlockedDoors.Shrink();
+		Move.SpawnedLoopDoors.Shrink();
+	}
+	PlacementIndex = FReberuPlacementIndex();
+	PureRuleResults.Empty();
+	PureRulesEvaluated.Empty();
+	RoomConstraintCounts.Empty();
+	RoomPools.Empty();
+	SpawnedRoomLevels.Items.Shrink();
+
+	const FReberuMemoryReport ReportAfter = GetMemoryReport();
+	REBERU_LOG_ARGS(Log, "Compacted the generation from %lld to %lld bytes: %s", ReportBefore.TotalBytes, ReportAfter.TotalBytes, *ReportAfter.ToString())
+}
+
+FReberuMemoryReport ALevelGeneratorActor::GetMemoryReport() const{
+	FReberuMemoryReport Report;
+
+	auto GetMoveSize = [](const FReberuMove& Move) -> int64{
+		return Move.AttemptedMoves.GetAllocatedSize() + Move.UsedDoors.GetAllocatedSize() + Move.SpawnedBlockedDoors.GetAllocatedSize() + Move.LoopDoorIdxs.GetAllocatedSize()
+			+ Move.LoopMoveIdxs.GetAllocatedSize() + Move.SpawnedLoopDoors.GetAllocatedSize();
+	};
+	auto AddRoomBytes = [&Report](const int32 RoomIdx, const int64 Bytes){
+		if(RoomIdx < 0) return;
+		if(RoomIdx >= Report.RoomBytes.Num()){
+			Report.RoomBytes.SetNumZeroed(RoomIdx + 1);
+		}
+		Report.RoomBytes[RoomIdx] += Bytes;
+	};
+
+	for (const FReberuMove& Move : MovesList){
+		const int64 MoveBytes = sizeof(TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode) + GetMoveSize(Move);
+		// Finalize destroys the room bounds, only layouts that are still being placed have them
+		const int64 BoundsBytes = !bRoomsFinalized && IsValid(Move.TargetRoomBounds) ? Move.TargetRoomBounds->Room.GetAllocatedSize() : 0;
+		Report.MovesBytes += MoveBytes;
+		Report.RoomBoundsBytes += BoundsBytes;
+		AddRoomBytes(Move.MoveIdx, MoveBytes + BoundsBytes);
+	}
+
+	Report.RoomLevelsBytes = SpawnedRoomLevels.Items.GetAllocatedSize() + RoomLevelItemIdxs.GetAllocatedSize();
+	for (const FRoomLevel& RoomLevel : SpawnedRoomLevels.Items){
+		const int64 RoomLevelBytes = RoomLevel.BlockedDoorIdxs.GetAllocatedSize() + RoomLevel.LoopDoorIdxs.GetAllocatedSize() + RoomLevel.LoopRoomIdxs.GetAllocatedSize()
+			+ RoomLevel.LevelName.GetAllocatedSize();
+		Report.RoomLevelsBytes += RoomLevelBytes;
+		AddRoomBytes(RoomLevel.RoomIdx, sizeof(FRoomLevel) + RoomLevelBytes);
+	}
+
+	Report.SearchBytes = PlacementIndex.GetAllocatedSize() + WorldObstacleIndex.GetAllocatedSize() + PureRuleResults.GetAllocatedSize() + PureRulesEvaluated.GetAllocatedSize() + RoomConstraintCounts.GetAllocatedSize()
+		+ InDataMoves.GetAllocatedSize() + InDataBounds.GetAllocatedSize() + InDataZoneFill.Zones.GetAllocatedSize() + IncrementalRooms.GetAllocatedSize()
+		+ FrontierDoors.GetAllocatedSize() + FrontierCells.GetAllocatedSize() + OpeningDoors.GetAllocatedSize() + RoomPools.GetAllocatedSize();
+	for (const TPair<uint64, FReberuRoomPool>& Pool : RoomPools){
+		Report.SearchBytes += Pool.Value.Rooms.GetAllocatedSize() + Pool.Value.AliasTable.GetAllocatedSize();
+	}
+	for (const FReberuMove& Move : InDataMoves){
+		Report.SearchBytes += GetMoveSize(Move);
+	}
+	for (const FReberuIncrementalRoom& IncrementalRoom : IncrementalRooms){
+		Report.SearchBytes += GetMoveSize(IncrementalRoom.Move);
+	}
+	for (const TPair<FIntVector, TArray<int32>>& FrontierCell : FrontierCells){
+		Report.SearchBytes += FrontierCell.Value.GetAllocatedSize();
+	}
+
+	Report.RoomGraphBytes = RoomGraph.GetAllocatedSize();
+	Report.NavGraphBytes = NavGraph.GetAllocatedSize();
+	Report.TotalBytes = Report.MovesBytes + Report.RoomBoundsBytes + Report.RoomLevelsBytes + Report.SearchBytes + Report.RoomGraphBytes + Report.NavGraphBytes;
+	return Report;
+}
+
+void ALevelGeneratorActor::OnRep_SeedLayout(){
+	if(HasAuthority() || ReplicationMode != EReberuReplicationMode::Seed) return;
+
+	UWorld* World = GetWorld();
+	if(!World) return;
+
+	// Get rid of whatever we generated for the previous seed
+	ClearGeneration();
+
+	if(!SeedLayout.ReberuData) return;
+
+	REBERU_LOG_ARGS(Log, "Generating layout locally from seed %d", SeedLayout.Seed)
+	bIsGenerating = true;
+
+	const FLatentActionInfo LatentInfo(0, 1, TEXT("OnLocalGenerateRoomsUpdate"), this);
+	FGenerateRoomsAction* GenerateAction = new FGenerateRoomsAction(this, SeedLayout.ReberuData, LocalGeneratedRooms, bLocalGenerationSuccess,
+		LatentInfo, LocalGenerateOutput, SeedLayout.Seed, false, SeedLayout.StartTransform);
+	GenerateAction->bUseExactSeed = true;
+	World->GetLatentActionManager().AddNewAction(this, LatentInfo.UUID, GenerateAction);
+}
+
+void ALevelGeneratorActor::OnLocalGenerateRoomsUpdate(){
+	UWorld* World = GetWorld();
+	if(!World) return;
+
+	if(LocalGenerateOutput == EGenerateRoomsOutputPins::OnFailed){
+		REBERU_LOG(Warning, "Local generation from seed failed, falling back to a layout snapshot.")
+		RequestLayoutSnapshot();
+		return;
+	}
+
+	if(LocalGenerateOutput != EGenerateRoomsOutputPins::OnCompleted) return;
+
+	const uint32 LocalChecksum = ComputeLayoutChecksum();
+	if(LocalChecksum != SeedLayout.LayoutChecksum){
+		REBERU_LOG_ARGS(Warning, "Local layout checksum %u doesn't match the server's %u, falling back to a layout snapshot.", LocalChecksum, SeedLayout.LayoutChecksum)
+		RequestLayoutSnapshot();
+		return;
+	}
+
+	const FLatentActionInfo LatentInfo(0, 2, TEXT("OnLocalFinalizeRoomsUpdate"), this);
+	World->GetLatentActionManager().AddNewAction(this, LatentInfo.UUID,
+		new FFinalizeRoomsTask(this, SeedLayout.ReberuData, bLocalGenerationSuccess, LatentInfo, LocalFinalizeOutput));
+}
+
+void ALevelGeneratorActor::OnLocalFinalizeRoomsUpdate(){
+	if(LocalFinalizeOutput == EFinalizeRoomsOutputPins::OnCompleted){
+		REBERU_LOG_ARGS(Log, "Finished local generation from seed %d", SeedLayout.Seed)
+		bIsGenerating = false;
+	}
+}
+
+void ALevelGeneratorActor::RequestLayoutSnapshot(){
+	ClearGeneration();
+
+	// Rooms come in over several chunks
+	bIsGenerating = true;
+	bSnapshotRequestPending = true;
+	RetryLayoutSnapshotRequest();
+}
+
+void ALevelGeneratorActor::RetryLayoutSnapshotRequest(){
+	if(!bSnapshotRequestPending || !GetWorld()) return;
+
+	UReberuPlayerComponent* PlayerComponent = UReberuPlayerComponent::FindLocalPlayerComponent(this);
+	if(!PlayerComponent){
+		// Expected for late joiners, the component's BeginPlay or the timer sends the request once it's there
+		if(!GetWorldTimerManager().IsTimerActive(SnapshotRequestTimerHandle)){
+			REBERU_LOG(Log, "Waiting for the local player's ReberuPlayerComponent to request a layout snapshot.")
+		}
+		GetWorldTimerManager().SetTimer(SnapshotRequestTimerHandle, this, &ALevelGeneratorActor::RetryLayoutSnapshotRequest, SnapshotRequestRetryDelay);
+		return;
+	}
+	bSnapshotRequestPending = false;
+	GetWorldTimerManager().ClearTimer(SnapshotRequestTimerHandle);
+	PlayerComponent->ServerRequestLayoutSnapshot(this);
+}
+
+void ALevelGeneratorActor::OnRep_LayoutSnapshotId(){
+	if(HasAuthority() || ReplicationMode != EReberuReplicationMode::Snapshot) return;
+
+	// Get rid of the rooms of the previous snapshot
+	ClearGeneration();
+
+	if(LayoutSnapshotId != 0){
+		RequestLayoutSnapshot();
+	}
+}
+
+void ALevelGeneratorActor::BuildLayoutSnapshot(const FVector& Origin, TArray<FReberuLayoutChunk>& OutChunks) const{
+	OutChunks.Reset();
+
+	// Nearest rooms first, by the center of their bounds since the level instance can be offset from it
+	TArray<TPair<double, const FRoomLevel*>> SortedRooms;
+	SortedRooms.Reserve(SpawnedRoomLevels.Items.Num());
+	for (const FRoomLevel& RoomLevel : SpawnedRoomLevels.Items){
+		SortedRooms.Emplace(FVector::DistSquared(GetRoomBoundsTransform(RoomLevel.RoomIdx).GetLocation(), Origin), &RoomLevel);
+	}
+	SortedRooms.Sort([](const TPair<double, const FRoomLevel*>& A, const TPair<double, const FRoomLevel*>& B){
+		return A.Key < B.Key;
+	});
+
+	const int32 RoomsPerChunk = FMath::Max(1, SnapshotRoomsPerChunk);
+	// Always send at least one chunk so the client knows the snapshot is complete
+	const int32 NumChunks = FMath::Max(1, FMath::DivideAndRoundUp(SortedRooms.Num(), RoomsPerChunk));
+
+	for (int32 ChunkIdx = 0; ChunkIdx < NumChunks; ChunkIdx++){
+		TArray<uint8> UncompressedData;
+		FMemoryWriter Writer(UncompressedData);
+
+		const int32 FirstRoom = ChunkIdx * RoomsPerChunk;
+		const int32 LastRoom = FMath::Min(FirstRoom + RoomsPerChunk, SortedRooms.Num());
+		for (int32 RoomIdx = FirstRoom; RoomIdx < LastRoom; RoomIdx++){
+			FRoomLevel RoomLevel = *SortedRooms[RoomIdx].Value;
+			RoomLevel.SerializeSnapshot(Writer);
+		}
+
+		FReberuLayoutChunk& Chunk = OutChunks.AddDefaulted_GetRef();
+		Chunk.SnapshotId = LayoutSnapshotId;
+		Chunk.ChunkIdx = ChunkIdx;
+		Chunk.NumChunks = NumChunks;
+		Chunk.UncompressedSize = UncompressedData.Num();
+
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, UncompressedData.Num());
+		Chunk.Data.SetNumUninitialized(CompressedSize);
+		Chunk.bCompressed = UncompressedData.Num() > 0 && FCompression::CompressMemory(NAME_Zlib, Chunk.Data.GetData(), CompressedSize, UncompressedData.GetData(), UncompressedData.Num())
+			&& CompressedSize < UncompressedData.Num();
+		if(Chunk.bCompressed){
+			Chunk.Data.SetNum(CompressedSize);
+		}
+		else{
+			Chunk.Data = MoveTemp(UncompressedData);
+		}
+	}
+}
+
+void ALevelGeneratorActor::ApplyLayoutChunk(UReberuData* ReberuData, const FReberuLayoutChunk& Chunk){
+	if(HasAuthority()) return;
+
+	if(Chunk.SnapshotId != LayoutSnapshotId){
+		REBERU_LOG_ARGS(Verbose, "Ignoring chunk of outdated layout snapshot %d", Chunk.SnapshotId)
+		return;
+	}
+
+	// The data asset might not have replicated yet
+	if(!ActiveReberuData){
+		ActiveReberuData = ReberuData;
+	}
+
+	TArray<uint8> UncompressedData;
+	if(!Chunk.bCompressed){
+		UncompressedData = Chunk.Data;
+	}
+	else{
+		UncompressedData.SetNumUninitialized(Chunk.UncompressedSize);
+		if(!FCompression::UncompressMemory(NAME_Zlib, UncompressedData.GetData(), Chunk.UncompressedSize, Chunk.Data.GetData(), Chunk.Data.Num())){
+			REBERU_LOG_ARGS(Error, "Failed to decompress chunk %d of layout snapshot %d", Chunk.ChunkIdx, Chunk.SnapshotId)
+			return;
+		}
+	}
+
+	FMemoryReader Reader(UncompressedData);
+	while (!Reader.AtEnd() && !Reader.IsError()){
+		FRoomLevel RoomLevel;
+		RoomLevel.SerializeSnapshot(Reader);
+
+		if(Reader.IsError() || !ResolveRoomLevel(RoomLevel)){
+			REBERU_LOG_ARGS(Warning, "Can't resolve room %d of layout snapshot %d (catalog index %d).", RoomLevel.RoomIdx, Chunk.SnapshotId, RoomLevel.CatalogIdx)
+			continue;
+		}
+		SpawnRoom(RoomLevel.InRoom, RoomLevel.SpawnTransform, MakeRoomLevelName(RoomLevel.InRoom, RoomLevel.RoomIdx), RoomLevel.ParentIndex, RoomLevel.RoomIdx);
+
+		TArray<int32> BlockedDoorIdxs;
+		BlockedDoorIdxs.Append(RoomLevel.BlockedDoorIdxs);
+		TArray<int32> LoopDoorIdxs;
+		LoopDoorIdxs.Append(RoomLevel.LoopDoorIdxs);
+		TArray<int32> LoopRoomIdxs;
+		LoopRoomIdxs.Append(RoomLevel.LoopRoomIdxs);
+		SetRoomDoors(RoomLevel.RoomIdx, RoomLevel.EntryDoorIdx, BlockedDoorIdxs, LoopDoorIdxs, LoopRoomIdxs);
+		SpawnInstancedRoomDoors(RoomLevel.RoomIdx);
+	}
+
+	if(Chunk.ChunkIdx + 1 >= Chunk.NumChunks){
+		REBERU_LOG_ARGS(Log, "Received all %d chunks of layout snapshot %d", Chunk.NumChunks, Chunk.SnapshotId)
+		bIsGenerating = false;
+	}
 }
 
-FTransform ALevelGeneratorActor::CalculateTransformFromDoor(ARoomBounds* SourceRoomBounds, FReberuDoor SourceRoomChosenDoor, UReberuRoomData* TargetRoom, FReberuDoor TargetRoomChosenDoor){
+FTransform ALevelGeneratorActor::CalculateTransformFromDoor(const FTransform& SourceRoomTransform, const FReberuDoor& SourceRoomChosenDoor, const UReberuRoomData* TargetRoom,
+	const FReberuDoor& TargetRoomChosenDoor){
 
 	FTransform CalculatedTransform = FTransform::Identity;
 
 	// We also alter the door location by the extent of the door
 	
 	// Get the location of the last room chosen door in world space
-	FTransform LastRoomTransform = SourceRoomBounds->GetActorTransform();
-	FVector RotatedFromDoorExtent = UKismetMathLibrary::Quat_RotateVector(
-		SourceRoomChosenDoor.DoorTransform.GetRotation(),
-		FVector(SourceRoomChosenDoor.BoxExtent.X, 0.f, -SourceRoomChosenDoor.BoxExtent.Z));
-	SourceRoomChosenDoor.DoorTransform.SetLocation(SourceRoomChosenDoor.DoorTransform.GetLocation() + RotatedFromDoorExtent);
-	FTransform LastRoomDoorTransform = SourceRoomChosenDoor.DoorTransform * LastRoomTransform;
+	FTransform LastRoomDoorTransform = GetDoorWorldTransform(SourceRoomChosenDoor, SourceRoomTransform);
 
 	// Get the location of the next room chosen door in world space
 	FTransform TargetRoomTransform = TargetRoom->Room.BoxActorTransform;
@@ -189,7 +866,7 @@ FTransform ALevelGeneratorActor::CalculateTransformFromDoor(ARoomBounds* SourceR
 	// Calculate Rotation
 	// https://forums.unrealengine.com/t/how-to-get-an-angle-between-2-vectors/280850/39
 	
-	FVector FromDoorForwardVector = SourceRoomBounds->GetActorForwardVector();
+	FVector FromDoorForwardVector = SourceRoomTransform.GetUnitAxis(EAxis::X);
 	FromDoorForwardVector = UKismetMathLibrary::Quat_RotateVector(SourceRoomChosenDoor.DoorTransform.GetRotation(), FromDoorForwardVector);
 	
 	FVector ToDoorForwardVector = TargetRoom->Room.BoxActorTransform.GetUnitAxis( EAxis::X );
@@ -253,12 +930,13 @@ bool ALevelGeneratorActor::ChooseSourceRoom(TDoubleLinkedList<FReberuMove>::TDou
 	// TODO implement other selection types
 
 	const ARoomBounds* SourceRoomBounds = SourceRoomNode->GetValue().TargetRoomBounds;
+	const int32 NumUsedDoors = SourceRoomNode->GetValue().NumUsedDoors;
 	
 	switch(SelectionType){
 	case ERoomSelection::Breadth:
 		// If we've used all doors on our current bounds, let's move to the next room
 		// Place all that we can on the most recent room
-		if(SourceRoomBounds->Room.UsedDoors.Num() == SourceRoomBounds->Room.ReberuDoors.Num() || bFromError){
+		if(NumUsedDoors == SourceRoomBounds->Room.ReberuDoors.Num() || bFromError){
 			while(SourceRoomNode != MovesList.GetTail() && (SourceRoomNode->GetValue().TargetRoomBounds == SourceRoomBounds || SourceRoomNode->GetValue().TargetRoomBounds == nullptr)){
 				SourceRoomNode = SourceRoomNode->GetNextNode();
 				REBERU_LOG(Verbose, "Iterated here!")
@@ -303,8 +981,15 @@ bool ALevelGeneratorActor::BacktrackSourceRoom(TDoubleLinkedList<FReberuMove>::T
 			
 			// Destroy the bounds that we are backtracking from
 			CurrentTail->GetValue().TargetRoomBounds->Destroy();
-			// update used doors on the bounds that we are backtracking to
-			CurrentTail->GetValue().SourceRoomBounds->Room.UsedDoors.Remove(CurrentTail->GetValue().SourceRoomDoor);
+			RemoveLastPlacedRoom();
+			TrackMove(CurrentTail->GetValue(), false);
+			// update used doors on the move that we are backtracking to, moves are in order so it's found walking back from the tail
+			for (TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode* Node = CurrentTail->GetPrevNode(); Node; Node = Node->GetPrevNode()){
+				if(Node->GetValue().MoveIdx == CurrentTail->GetValue().SourceMoveIdx){
+					Node->GetValue().SetDoorUsed(CurrentTail->GetValue().SourceDoorIdx, false);
+					break;
+				}
+			}
 			
 			MovesList.RemoveNode(CurrentTail);
 			return true;
@@ -317,96 +1002,175 @@ bool ALevelGeneratorActor::BacktrackSourceRoom(TDoubleLinkedList<FReberuMove>::T
 	return false;
 }
 
-void ALevelGeneratorActor::ChooseTargetRoom(TArray<UReberuRoomData*>& TargetRoomChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove){
+void ALevelGeneratorActor::ChooseTargetRoom(TArray<int32>& TargetRoomChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove){
+	bIsDefaultChooseTargetRoom = true;
 }
 
-void ALevelGeneratorActor::ChooseSourceDoor(TArray<FReberuDoor>& SourceRoomDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove){
+void ALevelGeneratorActor::ChooseSourceDoor(TArray<int32>& SourceDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove){
 }
 
-void ALevelGeneratorActor::ChooseTargetDoor(TArray<FReberuDoor>& SourceRoomDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuDoor& SourceDoor,
-	UReberuRoomData* TargetRoom){
+void ALevelGeneratorActor::ChooseTargetDoor(TArray<int32>& TargetDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove, int32 SourceDoorIdx,
+	int32 TargetRoomIdx){
 }
 
 bool ALevelGeneratorActor::PreProcessing(UReberuData* ReberuData){
 	return true;
 }
 
-void ALevelGeneratorActor::PostProcessing(UReberuData* ReberuData){
-	K2_PostProcessing(ReberuData);
-}
-
-bool ALevelGeneratorActor::PlaceNextRoom(UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove){
-	REBERU_LOG(Log, "Trying to place next room...")
-
-	NewMove.SourceRoomBounds = SourceMove.TargetRoomBounds;
-
-	// Get all choices for everything. Could definitely make this more efficient.
+int32 ALevelGeneratorActor::CloseLoops(UReberuData* ReberuData){
+	if(!ReberuData || !ReberuData->bCloseLoops) return 0;
 
-	// Get source room possible doors (remove the already used doors)
-	TArray<FReberuDoor> SourceRoomDoorChoices;
-	for(FReberuDoor Door: SourceMove.TargetRoomBounds->Room.ReberuDoors){
-		if(!SourceMove.TargetRoomBounds->Room.UsedDoors.Contains(Door.DoorId)){
-			SourceRoomDoorChoices.Add(Door);
-		}
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+	TArray<FReberuMove*> Moves;
+	for (FReberuMove& Move : MovesList){
+		Moves.Add(&Move);
 	}
-	ChooseSourceDoor(SourceRoomDoorChoices, ReberuData, SourceMove);
 
-	// get target room possibilities
-	TArray<UReberuRoomData*> TargetRoomChoices;
-	for(UReberuRoomData* TargetRoom : ReberuData->ReberuRooms){
-		if(SourceMove.RoomData->Room.bAllowSameRoomConnect == false && SourceMove.RoomData == TargetRoom){
-			continue;
+	struct FOpenDoor{
+		uint64 CellKey = 0;
+		int32 MoveIdx = INDEX_NONE;
+		int32 DoorIdx = INDEX_NONE;
+		FVector Location = FVector::ZeroVector;
+		FVector Forward = FVector::ZeroVector;
+		bool bIsConnected = false;
+	};
+
+	// Cells are as big as the tolerance so doors close enough to connect are always in neighboring cells
+	const float CellSize = FMath::Max(ReberuData->LoopDoorTolerance, 1.f);
+	auto MakeCellKey = [](const FIntVector& Cell){
+		// 21 bits per axis, cells that wrap around only add candidates that fail the distance check
+		return (static_cast<uint64>(Cell.X & 0x1FFFFF) << 42) | (static_cast<uint64>(Cell.Y & 0x1FFFFF) << 21) | static_cast<uint64>(Cell.Z & 0x1FFFFF);
+	};
+	auto GetCell = [CellSize](const FVector& Location){
+		return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+	};
+
+	TArray<FOpenDoor> OpenDoors;
+	for (int32 MoveIdx = 0; MoveIdx < Moves.Num(); MoveIdx++){
+		const FReberuMove& Move = *Moves[MoveIdx];
+		if(!Move.TargetRoomBounds || !Catalog.Rooms.IsValidIndex(Move.CatalogIdx)) continue;
+
+		const FReberuRoom& BoundsRoom = Move.TargetRoomBounds->Room;
+		const FTransform BoundsTransform = Move.TargetRoomBounds->GetActorTransform();
+		const int32 NumDoors = FMath::Min<int32>(Catalog.RoomNumDoors[Move.CatalogIdx], BoundsRoom.ReberuDoors.Num());
+		for (int32 DoorIdx = 0; DoorIdx < NumDoors; DoorIdx++){
+			const FReberuDoor& Door = BoundsRoom.ReberuDoors[DoorIdx];
+			// Doors with a weight of 0 are never used, loops included
+			if(Move.IsDoorUsed(DoorIdx) || Catalog.DoorWeights[Catalog.GetDoorIndex(Move.CatalogIdx, DoorIdx)] <= 0.f) continue;
+
+			const FTransform DoorTransform = GetDoorWorldTransform(Door, BoundsTransform);
+			FOpenDoor& OpenDoor = OpenDoors.AddDefaulted_GetRef();
+			OpenDoor.MoveIdx = MoveIdx;
+			OpenDoor.DoorIdx = DoorIdx;
+			OpenDoor.Location = DoorTransform.GetLocation();
+			OpenDoor.Forward = DoorTransform.GetUnitAxis(EAxis::X);
+			OpenDoor.CellKey = MakeCellKey(GetCell(OpenDoor.Location));
 		}
-		TargetRoomChoices.Add(TargetRoom);
 	}
-	ChooseTargetRoom(TargetRoomChoices, ReberuData, SourceMove, NewMove);
-	
-	TArray<FAttemptedMove> PossibleMoves;
-	
-	// Generate possible moves and then delete them based on the already created attempted moves...
-	// TODO get rid of the nested loop bc this is pretty gross. O(n^3)
-	for(FReberuDoor SourceDoor : SourceRoomDoorChoices){
-		for(UReberuRoomData* TargetRoom : TargetRoomChoices){
-			TArray<FReberuDoor> TargetRoomDoorChoices = TargetRoom->Room.ReberuDoors;
-			ChooseTargetDoor(TargetRoomDoorChoices, ReberuData, SourceMove, SourceDoor, TargetRoom);
-			
-			for(FReberuDoor TargetDoor : TargetRoomDoorChoices){
-				FAttemptedMove PossibleMove = FAttemptedMove(TargetRoom, SourceDoor.DoorId, TargetDoor.DoorId);
-				if(!SourceMove.AttemptedMoves.Contains(PossibleMove)){
-					if(SourceDoor.bOnlyConnectSameDoor || TargetDoor.bOnlyConnectSameDoor){
-						if(SourceDoor.DoorTag.MatchesTagExact(TargetDoor.DoorTag) || (SourceDoor.DoorTag.IsValid() == false && TargetDoor.DoorTag.IsValid() == false)){
-							PossibleMoves.Add(PossibleMove);
+	// Stable so doors in the same cell stay in layout order, the loops have to be the same on seed replicated clients
+	Algo::StableSortBy(OpenDoors, &FOpenDoor::CellKey);
+
+	auto CanConnect = [&](const FOpenDoor& Door, const FOpenDoor& OtherDoor){
+		if(Door.MoveIdx == OtherDoor.MoveIdx || OtherDoor.bIsConnected) return false;
+		// Connected doors are at the same spot, facing each other
+		if(FVector::DistSquared(Door.Location, OtherDoor.Location) > FMath::Square(ReberuData->LoopDoorTolerance)) return false;
+		if(Door.Forward.Dot(OtherDoor.Forward) > -.99f) return false;
+
+		// The earlier room is the source, like it would be during generation
+		const FOpenDoor& SourceDoor = Door.MoveIdx < OtherDoor.MoveIdx ? Door : OtherDoor;
+		const FOpenDoor& TargetDoor = Door.MoveIdx < OtherDoor.MoveIdx ? OtherDoor : Door;
+		const int32 SourceRoomIdx = Moves[SourceDoor.MoveIdx]->CatalogIdx;
+		const int32 TargetRoomIdx = Moves[TargetDoor.MoveIdx]->CatalogIdx;
+		if(SourceRoomIdx == TargetRoomIdx && !EnumHasAnyFlags(Catalog.RoomFlags[SourceRoomIdx], EReberuCatalogRoomFlags::AllowSameRoomConnect)) return false;
+
+		const int32 SourceCatalogDoor = Catalog.GetDoorIndex(SourceRoomIdx, SourceDoor.DoorIdx);
+		const int32 TargetCatalogDoor = Catalog.GetDoorIndex(TargetRoomIdx, TargetDoor.DoorIdx);
+		if(EnumHasAnyFlags(Catalog.DoorFlags[SourceCatalogDoor] | Catalog.DoorFlags[TargetCatalogDoor], EReberuCatalogDoorFlags::OnlyConnectSameDoor)){
+			if(!Catalog.AreTagsCompatible(Catalog.DoorTagIdx[SourceCatalogDoor], Catalog.DoorTagIdx[TargetCatalogDoor])) return false;
+		}
+		return PassesRules(ReberuData, Catalog, SourceRoomIdx, TargetRoomIdx);
+	};
+
+	int32 NumLoops = 0;
+	for (int32 DoorIdx = 0; DoorIdx < OpenDoors.Num(); DoorIdx++){
+		FOpenDoor& Door = OpenDoors[DoorIdx];
+		if(Door.bIsConnected) continue;
+
+		// Closest door that can connect in the neighboring cells, each cell is found with a binary search
+		int32 BestIdx = INDEX_NONE;
+		double BestDistSquared = TNumericLimits<double>::Max();
+		const FIntVector Cell = GetCell(Door.Location);
+		for (int32 X = -1; X <= 1; X++){
+			for (int32 Y = -1; Y <= 1; Y++){
+				for (int32 Z = -1; Z <= 1; Z++){
+					const uint64 CellKey = MakeCellKey(Cell + FIntVector(X, Y, Z));
+					for (int32 OtherIdx = Algo::LowerBoundBy(OpenDoors, CellKey, &FOpenDoor::CellKey); OtherIdx < OpenDoors.Num() && OpenDoors[OtherIdx].CellKey == CellKey; OtherIdx++){
+						const double DistSquared = FVector::DistSquared(Door.Location, OpenDoors[OtherIdx].Location);
+						if(DistSquared < BestDistSquared && CanConnect(Door, OpenDoors[OtherIdx])){
+							BestIdx = OtherIdx;
+							BestDistSquared = DistSquared;
 						}
 					}
-					else{
-						PossibleMoves.Add(PossibleMove);
-					}
 				}
 			}
 		}
+		if(BestIdx == INDEX_NONE) continue;
+
+		FOpenDoor& OtherDoor = OpenDoors[BestIdx];
+		Door.bIsConnected = true;
+		OtherDoor.bIsConnected = true;
+		const FOpenDoor& TargetDoor = Door.MoveIdx < OtherDoor.MoveIdx ? OtherDoor : Door;
+		for (const FOpenDoor* LoopDoor : {&Door, &OtherDoor}){
+			Moves[LoopDoor->MoveIdx]->SetDoorUsed(LoopDoor->DoorIdx);
+		}
+		FReberuMove& TargetMove = *Moves[TargetDoor.MoveIdx];
+		TargetMove.LoopDoorIdxs.Add(TargetDoor.DoorIdx);
+		TargetMove.LoopMoveIdxs.Add(Door.MoveIdx < OtherDoor.MoveIdx ? Door.MoveIdx : OtherDoor.MoveIdx);
+		NumLoops++;
 	}
 
-	if(PossibleMoves.Num() == 0){
-		REBERU_LOG(Log, "No more possible moves on this source room.")
-		return false;
-	}
-
-	FAttemptedMove ChosenMove = GetRandomObjectInArray(PossibleMoves, ReberuRandomStream);
-	SourceMove.AttemptedMoves.Add(ChosenMove);
-
-	NewMove.RoomData = ChosenMove.RoomData;
-	NewMove.SourceRoomDoor = ChosenMove.SourceRoomDoor;
-	NewMove.TargetRoomDoor = ChosenMove.TargetRoomDoor;
+	REBERU_LOG_ARGS(Log, "Closed %d loops between %d open doors.", NumLoops, OpenDoors.Num())
+	return NumLoops;
+}
 
-	REBERU_LOG_ARGS(Log, "Trying : Source Room [%s] Source Door [%s] Target Room [%s] Target Door [%s]", *SourceMove.RoomData->RoomName.ToString(), *NewMove.SourceRoomDoor,
-		*NewMove.RoomData->RoomName.ToString(), *NewMove.TargetRoomDoor)
-	
-	FReberuDoor SourceDoor = *SourceMove.RoomData->Room.GetDoorById(NewMove.SourceRoomDoor);
-	FReberuDoor TargetDoor = *NewMove.RoomData->Room.GetDoorById(NewMove.TargetRoomDoor);
+void ALevelGeneratorActor::PostProcessing(UReberuData* ReberuData){
+	K2_PostProcessing(ReberuData);
+}
 
-	const FTransform TargetRoomTransform = CalculateTransformFromDoor(SourceMove.TargetRoomBounds,
+bool ALevelGeneratorActor::PlaceNextRoom(UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove){
+	REBERU_LOG(Log, "Trying to place next room...")
+
+	NewMove.SourceRoomBounds = SourceMove.TargetRoomBounds;
+	NewMove.SourceMoveIdx = SourceMove.MoveIdx;
+
+	FAttemptedMove ChosenMove;
+	if(!ChooseNextMove(ReberuData, SourceMove, SourceMove.UsedDoors, MovesList.Num(), NewMove, ChosenMove)){
+		return false;
+	}
+	SetMoveTarget(ReberuData->GetCatalog(), ChosenMove, NewMove);
+
+	const FReberuDoor& SourceDoor = SourceMove.RoomData->Room.ReberuDoors[ChosenMove.SourceDoorIdx];
+	const FReberuDoor& TargetDoor = NewMove.RoomData->Room.ReberuDoors[ChosenMove.TargetDoorIdx];
+	REBERU_LOG_ARGS(Log, "Trying : Source Room [%s] Source Door [%s] Target Room [%s] Target Door [%s]", *SourceMove.RoomData->RoomName.ToString(), *SourceDoor.DoorId,
+		*NewMove.RoomData->RoomName.ToString(), *TargetDoor.DoorId)
+
+	const FTransform TargetRoomTransform = CalculateTransformFromDoor(SourceMove.TargetRoomBounds->GetActorTransform(),
 		SourceDoor, NewMove.RoomData, TargetDoor);
 
+	// The placed rooms (of every generator in the world) and the obstacles are in memory, so they are checked before spawning anything
+	if(OverlapsPlacedRooms(TargetRoomTransform, NewMove.RoomData->Room.BoxExtent)){
+		REBERU_LOG_ARGS(Verbose, "%s overlaps a placed room or world obstacle", *NewMove.RoomData->RoomName.ToString())
+		return PlaceNextRoom(ReberuData, SourceMove, NewMove);
+	}
+	if(bSnapshotWorldObstacles && SharedPlacementIndex){
+		NewMove.TargetRoomBounds = SpawnRoomBounds(NewMove.RoomData, TargetRoomTransform);
+		AddPlacedRoom(TargetRoomTransform, NewMove.RoomData->Room.BoxExtent);
+		return true;
+	}
+	// Without the generation subsystem (outside of game and PIE worlds) the rooms of other generators are only found with the physics overlap.
+	// The snapshot already covers the world obstacles, so only room bounds count then.
+	const bool bOnlyOverlapRoomBounds = bSnapshotWorldObstacles;
+
 	ARoomBounds* TargetRoomBounds = SpawnRoomBounds(NewMove.RoomData, TargetRoomTransform);
 
 	REBERU_LOG_ARGS(Log, "Spawned in New room bounds, %s (%s), which is connected to: %s", *TargetRoomBounds->GetName(), *NewMove.RoomData->RoomName.ToString(), *SourceMove.TargetRoomBounds->GetName())
@@ -428,7 +1192,9 @@ bool ALevelGeneratorActor::PlaceNextRoom(UReberuData* ReberuData, FReberuMove& S
 	World->OverlapMultiByObjectType(Overlaps, TargetRoomBounds->RoomBox->GetCenterOfMass(), TargetRoomBounds->GetActorRotation().Quaternion(), ObjectParams, FCollisionShape::MakeBox(TargetRoomBounds->RoomBox->GetUnscaledBoxExtent()), Params);
 
 	for (FOverlapResult& Overlap : Overlaps){
-		OverlappingActors.Add(Overlap.GetActor());
+		if(!bOnlyOverlapRoomBounds || Cast<ARoomBounds>(Overlap.GetActor())){
+			OverlappingActors.Add(Overlap.GetActor());
+		}
 	}
 	
 	REBERU_LOG_ARGS(Log, "Number of overlapping actors for %s is: %d", *TargetRoomBounds->GetName(), OverlappingActors.Num())
@@ -439,6 +1205,7 @@ bool ALevelGeneratorActor::PlaceNextRoom(UReberuData* ReberuData, FReberuMove& S
 	
 	if(OverlappingActors.Num() == 0){
 		NewMove.TargetRoomBounds = TargetRoomBounds;
+		AddPlacedRoom(TargetRoomTransform, NewMove.RoomData->Room.BoxExtent);
 		// DrawDebugBox(World, TargetRoomBounds->RoomBox->GetCenterOfMass(), TargetRoomBounds->RoomBox->GetUnscaledBoxExtent(), TargetRoomBounds->GetActorRotation().Quaternion(), FColor::Green, true, -1, 0, 2.f);
 		return true;
 	}
@@ -447,6 +1214,1267 @@ bool ALevelGeneratorActor::PlaceNextRoom(UReberuData* ReberuData, FReberuMove& S
 	return PlaceNextRoom(ReberuData, SourceMove, NewMove);
 }
 
+bool ALevelGeneratorActor::ChooseNextMove(UReberuData* ReberuData, FReberuMove& SourceMove, const TBitArray<>& UsedSourceDoors, const int32 NumPlacedRooms,
+	FReberuMove& NewMove, FAttemptedMove& OutMove){
+	// All candidates are enumerated from the flattened catalog so we only go over indices here
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+	const int32 SourceRoomIdx = SourceMove.CatalogIdx;
+	if(!Catalog.Rooms.IsValidIndex(SourceRoomIdx)){
+		REBERU_LOG_ARGS(Error, "Source room %s isn't part of %s!", *GetNameSafe(SourceMove.RoomData), *ReberuData->GetName())
+		return false;
+	}
+
+	// Get source room possible doors (remove the already used doors)
+	TArray<int32>& SourceDoorChoices = SourceDoorScratch;
+	SourceDoorChoices.Reset();
+	for(int32 DoorIdx = 0; DoorIdx < Catalog.RoomNumDoors[SourceRoomIdx]; DoorIdx++){
+		if(!UsedSourceDoors.IsValidIndex(DoorIdx) || !UsedSourceDoors[DoorIdx]){
+			SourceDoorChoices.Add(DoorIdx);
+		}
+	}
+	ChooseSourceDoor(SourceDoorChoices, ReberuData, SourceMove);
+
+	// get target room possibilities from the pool of the zone and full constraints. Rules, the other constraints and connecting
+	// to the same room are only checked once a room is drawn.
+	// Only an overridden ChooseTargetRoom gets a copy of the pool to change, the base one is called once to find out it isn't overridden
+	const FReberuRoomPool& Pool = GetRoomPool(Catalog);
+	TArray<int32>& TargetRoomChoices = TargetRoomScratch;
+	TargetRoomChoices.Reset();
+	if(!bIsDefaultChooseTargetRoom){
+		TargetRoomChoices.Append(Pool.Rooms);
+		ChooseTargetRoom(TargetRoomChoices, ReberuData, SourceMove, NewMove);
+	}
+
+	// Rooms are drawn by weight from the pool's alias table, drawing again when a room turns out to be excluded.
+	// Once too much of the table's weight is excluded we switch to a table of only the remaining rooms.
+	if(RejectedRoomScratch.Num() != Catalog.NumRooms()){
+		RejectedRoomScratch.Init(false, Catalog.NumRooms());
+	}
+	const FReberuAliasTable* AliasTable = &Pool.AliasTable;
+	const TArray<int32>* AliasRooms = &Pool.Rooms;
+	int32 NumCandidates = Pool.Rooms.Num();
+	float CandidateWeight = Pool.AliasTable.GetTotalWeight();
+	if(!bIsDefaultChooseTargetRoom && (TargetRoomChoices.Num() != Pool.Rooms.Num() || FMemory::Memcmp(TargetRoomChoices.GetData(), Pool.Rooms.GetData(), TargetRoomChoices.Num() * sizeof(int32)) != 0)){
+		// ChooseTargetRoom changed the choices, so they get a table of their own
+		LocalAliasRooms.Reset();
+		LocalAliasWeights.Reset();
+		for(const int32 TargetRoomIdx : TargetRoomChoices){
+			if(!Catalog.Rooms.IsValidIndex(TargetRoomIdx) || RejectedRoomScratch[TargetRoomIdx] || Catalog.RoomWeights[TargetRoomIdx] <= 0.f) continue;
+
+			// Marked to skip duplicates, cleared right after
+			RejectedRoomScratch[TargetRoomIdx] = true;
+			LocalAliasRooms.Add(TargetRoomIdx);
+			LocalAliasWeights.Add(Catalog.RoomWeights[TargetRoomIdx]);
+		}
+		for(const int32 TargetRoomIdx : LocalAliasRooms){
+			RejectedRoomScratch[TargetRoomIdx] = false;
+		}
+		LocalAliasTable.Build(LocalAliasWeights);
+		AliasTable = &LocalAliasTable;
+		AliasRooms = &LocalAliasRooms;
+		NumCandidates = LocalAliasRooms.Num();
+		CandidateWeight = LocalAliasTable.GetTotalWeight();
+	}
+	float AliasTableWeight = AliasTable->GetTotalWeight();
+
+	const bool bAllowSameRoomConnect = EnumHasAnyFlags(Catalog.RoomFlags[SourceRoomIdx], EReberuCatalogRoomFlags::AllowSameRoomConnect);
+	const int32 RemainingRooms = ReberuData->TargetRoomAmount - NumPlacedRooms;
+	TArray<FAttemptedMove>& PossibleMoves = PossibleMovesScratch;
+	TArray<float>& PossibleMoveWeights = PossibleMoveWeightsScratch;
+	PossibleMoves.Reset();
+	PossibleMoveWeights.Reset();
+
+	while(NumCandidates > 0){
+		if(CandidateWeight < AliasTableWeight * .5f){
+			// Rebuilt from the rooms of the current table, which can be the local table itself
+			RemainingAliasRooms.Reset();
+			LocalAliasWeights.Reset();
+			for(const int32 TargetRoomIdx : *AliasRooms){
+				if(!RejectedRoomScratch[TargetRoomIdx]){
+					RemainingAliasRooms.Add(TargetRoomIdx);
+					LocalAliasWeights.Add(Catalog.RoomWeights[TargetRoomIdx]);
+				}
+			}
+			Swap(LocalAliasRooms, RemainingAliasRooms);
+			LocalAliasTable.Build(LocalAliasWeights);
+			AliasTable = &LocalAliasTable;
+			AliasRooms = &LocalAliasRooms;
+			AliasTableWeight = LocalAliasTable.GetTotalWeight();
+			CandidateWeight = AliasTableWeight;
+		}
+
+		const int32 DrawnIdx = AliasTable->Sample(ReberuRandomStream);
+		if(DrawnIdx == INDEX_NONE) break;
+
+		const int32 TargetRoomIdx = (*AliasRooms)[DrawnIdx];
+		if(RejectedRoomScratch[TargetRoomIdx]) continue;
+
+		if((bAllowSameRoomConnect || TargetRoomIdx != SourceRoomIdx) && CanMeetRoomConstraints(Catalog, TargetRoomIdx, RemainingRooms)
+			&& PassesRules(ReberuData, Catalog, SourceRoomIdx, TargetRoomIdx)){
+			GatherDoorPairs(ReberuData, Catalog, SourceMove, SourceDoorChoices, TargetRoomIdx, PossibleMoves, PossibleMoveWeights);
+			if(PossibleMoves.Num() > 0) break;
+		}
+
+		// Nothing left to try with this room
+		RejectedRoomScratch[TargetRoomIdx] = true;
+		RejectedRoomIdxs.Add(TargetRoomIdx);
+		NumCandidates--;
+		CandidateWeight -= Catalog.RoomWeights[TargetRoomIdx];
+	}
+	for(const int32 TargetRoomIdx : RejectedRoomIdxs){
+		RejectedRoomScratch[TargetRoomIdx] = false;
+	}
+	RejectedRoomIdxs.Reset();
+
+	if(PossibleMoves.Num() == 0){
+		REBERU_LOG(Log, "No more possible moves on this source room.")
+		return false;
+	}
+
+	// Then pick the door pair of the drawn room by the weights of both doors
+	float DoorPairDraw = ReberuRandomStream.FRandRange(0.f, Algo::Accumulate(PossibleMoveWeights, 0.f));
+	int32 ChosenMoveIdx = 0;
+	for(; ChosenMoveIdx < PossibleMoves.Num() - 1; ChosenMoveIdx++){
+		DoorPairDraw -= PossibleMoveWeights[ChosenMoveIdx];
+		if(DoorPairDraw < 0.f) break;
+	}
+	OutMove = PossibleMoves[ChosenMoveIdx];
+	SourceMove.AttemptedMoves.Add(OutMove);
+	return true;
+}
+
+void ALevelGeneratorActor::SetMoveTarget(const FReberuRoomCatalog& Catalog, const FAttemptedMove& ChosenMove, FReberuMove& NewMove){
+	NewMove.RoomData = Catalog.Rooms[ChosenMove.RoomIdx];
+	NewMove.CatalogIdx = ChosenMove.RoomIdx;
+	NewMove.SourceDoorIdx = ChosenMove.SourceDoorIdx;
+	NewMove.TargetDoorIdx = ChosenMove.TargetDoorIdx;
+}
+
+bool ALevelGeneratorActor::GenerateDataLayout(UReberuData* ReberuData, const int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves, int32* OutNumBacktracks){
+	OutMoves.Reset();
+	if(OutNumBacktracks) *OutNumBacktracks = 0;
+	if(!ReberuData || bIsGenerating) return false;
+
+	// Nothing gets spawned, so other generators don't need to know about these rooms. The rooms this generator already
+	// placed stay in the shared index (and in SharedBoxIdxs), ClearGeneration still has to release them.
+	TGuardValue<FReberuPlacementIndex*> SharedIndexGuard(SharedPlacementIndex, nullptr);
+	FReberuPlacementIndex PlacedRooms = MoveTemp(PlacementIndex);
+	const bool bSuccess = BuildDataLayout(ReberuData, Seed, StartTransform, OutMoves, OutNumBacktracks);
+	PlacementIndex = MoveTemp(PlacedRooms);
+	return bSuccess;
+}
+
+bool ALevelGeneratorActor::BeginRoomsInData(UReberuData* ReberuData, const int32 Seed, const FTransform& StartTransform){
+	SharedPlacementIndex = FindSharedPlacementIndex();
+	InDataBounds.Reset();
+	bInDataFilled = false;
+	if(!BeginDataLayout(ReberuData, Seed, StartTransform, InDataMoves)) return false;
+
+	InDataReberuData = ReberuData;
+	if(ReberuData->Zones.Num() > 0){
+		BeginDataZones(ReberuData, StartTransform, InDataZoneFill);
+	}
+	else{
+		InDataFill = MakeDataFill(ReberuData, 0, ReberuData->TargetRoomAmount);
+	}
+	return true;
+}
+
+bool ALevelGeneratorActor::StepRoomsInData(){
+	if(!InDataReberuData) return false;
+
+	if(!bInDataFilled){
+		bInDataFilled = InDataReberuData->Zones.Num() > 0 ? !StepDataZones(InDataReberuData, InDataMoves, InDataZoneFill)
+			: !StepDataLayout(InDataReberuData, InDataMoves, InDataFill);
+		return true;
+	}
+	// Spawning thousands of RoomBounds at once is a hitch too, so they are spawned a room per step
+	return !SpawnDataLayoutBounds(InDataMoves, InDataBounds, 1);
+}
+
+bool ALevelGeneratorActor::EndRoomsInData(){
+	const UReberuData* ReberuData = InDataReberuData;
+	const bool bSuccess = ReberuData && InDataBounds.Num() >= ReberuData->MinRoomAmount && AreRoomConstraintsMet();
+	InDataReberuData = nullptr;
+	InDataMoves.Reset();
+	InDataBounds.Reset();
+	InDataZoneFill = FReberuZoneFill();
+	bInDataFilled = false;
+	return bSuccess;
+}
+
+bool ALevelGeneratorActor::SpawnDataLayoutBounds(TArray<FReberuMove>& DataMoves, TArray<ARoomBounds*>& SpawnedBounds, const int32 MaxBounds){
+	SpawnedBounds.Reserve(DataMoves.Num());
+	const int32 EndMoveIdx = FMath::Min(DataMoves.Num(), SpawnedBounds.Num() + MaxBounds);
+	for (int32 MoveIdx = SpawnedBounds.Num(); MoveIdx < EndMoveIdx; MoveIdx++){
+		FReberuMove& Move = DataMoves[MoveIdx];
+		Move.TargetRoomBounds = SpawnRoomBounds(Move.RoomData, Move.SpawnedTransform);
+		Move.AttemptedMoves.Reset();
+		if(SpawnedBounds.IsValidIndex(Move.SourceMoveIdx)){
+			Move.SourceRoomBounds = SpawnedBounds[Move.SourceMoveIdx];
+			Move.TargetRoomBounds->Room.Depth = Move.SourceRoomBounds->Room.Depth + 1;
+		}
+		else{
+			Move.CanRevertMove = false;
+		}
+		SpawnedBounds.Add(Move.TargetRoomBounds);
+		MovesList.AddTail(MoveTemp(Move));
+	}
+	if(SpawnedBounds.Num() < DataMoves.Num()) return false;
+
+	DataMoves.Reset();
+	return true;
+}
+
+bool ALevelGeneratorActor::BuildDataLayout(UReberuData* ReberuData, const int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves, int32* OutNumBacktracks){
+	if(OutNumBacktracks) *OutNumBacktracks = 0;
+
+	if(!BeginDataLayout(ReberuData, Seed, StartTransform, OutMoves)) return false;
+
+	int32 NumBacktracks = 0;
+	if(ReberuData->Zones.Num() > 0){
+		NumBacktracks = FillDataZones(ReberuData, StartTransform, OutMoves);
+	}
+	else{
+		NumBacktracks = FillDataLayout(ReberuData, OutMoves, 0, ReberuData->TargetRoomAmount);
+	}
+	if(OutNumBacktracks) *OutNumBacktracks = NumBacktracks;
+
+	return OutMoves.Num() >= ReberuData->MinRoomAmount && AreRoomConstraintsMet();
+}
+
+bool ALevelGeneratorActor::BeginDataLayout(UReberuData* ReberuData, const int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves){
+	OutMoves.Reset();
+	if(!ReberuData) return false;
+
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+	if(Catalog.NumPlaceableRooms() == 0 || !ReberuData->GetAnalysis().CanGenerate()) return false;
+
+	ReberuRandomStream = FRandomStream(Seed);
+	ResetRuleCache();
+	ResetRoomConstraints(ReberuData);
+
+	UReberuRoomData* StartingRoomData = !ReberuData->StartingRoom.IsNull() ? ReberuData->StartingRoom.Get()
+		: Catalog.Rooms[ReberuRandomStream.RandRange(0, Catalog.NumPlaceableRooms() - 1)];
+	if(!StartingRoomData){
+		REBERU_LOG(Error, "The starting room couldn't be loaded!")
+		return false;
+	}
+
+	PlacementIndex.Reset();
+	if(bSnapshotWorldObstacles && !bHasWorldObstacles){
+		SnapshotWorldObstacles();
+	}
+
+	FReberuMove& StartMove = OutMoves.Emplace_GetRef(StartingRoomData, StartTransform);
+	StartMove.MoveIdx = 0;
+	StartMove.CatalogIdx = ReberuData->GetRoomIndex(StartingRoomData);
+	AddPlacedRoom(StartTransform, StartingRoomData->Room.BoxExtent);
+	TrackMove(StartMove, true);
+	return true;
+}
+
+int32 ALevelGeneratorActor::FillDataLayout(UReberuData* ReberuData, TArray<FReberuMove>& Moves, const int32 FirstMoveIdx, const int32 TargetAmount){
+	FReberuDataFill Fill = MakeDataFill(ReberuData, FirstMoveIdx, TargetAmount);
+	while(StepDataLayout(ReberuData, Moves, Fill)){}
+	return Fill.NumBacktracks;
+}
+
+FReberuDataFill ALevelGeneratorActor::MakeDataFill(const UReberuData* ReberuData, const int32 FirstMoveIdx, const int32 TargetAmount){
+	FReberuDataFill Fill;
+	Fill.FirstMoveIdx = FirstMoveIdx;
+	Fill.TargetAmount = TargetAmount;
+	Fill.SourceIdx = FirstMoveIdx;
+	Fill.BacktrackTries = ReberuData->MaxBacktrackTries;
+	// Backtracking loses the attempted moves of the removed rooms, so also cap the total to always finish
+	Fill.TotalBacktracks = (TargetAmount - FirstMoveIdx) * (ReberuData->MaxBacktrackTries + 1);
+	return Fill;
+}
+
+bool ALevelGeneratorActor::StepDataLayout(UReberuData* ReberuData, TArray<FReberuMove>& Moves, FReberuDataFill& Fill){
+	if(Moves.Num() >= Fill.TargetAmount) return false;
+
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+	FReberuMove NewMove;
+	NewMove.SourceMoveIdx = Fill.SourceIdx;
+	FAttemptedMove ChosenMove;
+	bool bPlaced = false;
+	while(!bPlaced && ChooseNextMove(ReberuData, Moves[Fill.SourceIdx], Moves[Fill.SourceIdx].UsedDoors, Moves.Num(), NewMove, ChosenMove)){
+		const FReberuMove& SourceMove = Moves[Fill.SourceIdx];
+		SetMoveTarget(Catalog, ChosenMove, NewMove);
+		NewMove.SpawnedTransform = CalculateTransformFromDoor(SourceMove.SpawnedTransform, SourceMove.RoomData->Room.ReberuDoors[ChosenMove.SourceDoorIdx],
+			NewMove.RoomData, NewMove.RoomData->Room.ReberuDoors[ChosenMove.TargetDoorIdx]);
+		bPlaced = !OverlapsPlacedRooms(NewMove.SpawnedTransform, NewMove.RoomData->Room.BoxExtent);
+	}
+
+	if(bPlaced){
+		Fill.BacktrackTries = ReberuData->MaxBacktrackTries;
+		AddDataMove(Moves, NewMove);
+
+		// Breadth first like ChooseSourceRoom, keep the source room until all of its doors are used
+		if(Moves[Fill.SourceIdx].NumUsedDoors >= Catalog.RoomNumDoors[Moves[Fill.SourceIdx].CatalogIdx]){
+			Fill.SourceIdx++;
+		}
+	}
+	else if(Fill.SourceIdx < Moves.Num() - 1){
+		Fill.SourceIdx++;
+	}
+	else if(Fill.BacktrackTries > 0 && Fill.TotalBacktracks > 0 && Moves.Num() > Fill.FirstMoveIdx + 1){
+		Fill.BacktrackTries--;
+		Fill.TotalBacktracks--;
+		Fill.NumBacktracks++;
+
+		// The attempted moves of the source keep the tail from being placed the same way again
+		const FReberuMove Tail = Moves.Pop(EAllowShrinking::No);
+		TrackMove(Tail, false);
+		Moves[Tail.SourceMoveIdx].SetDoorUsed(Tail.SourceDoorIdx, false);
+		RemoveLastPlacedRoom();
+		Fill.SourceIdx = Tail.SourceMoveIdx;
+	}
+	else{
+		return false;
+	}
+	return true;
+}
+
+void ALevelGeneratorActor::AddDataMove(TArray<FReberuMove>& Moves, FReberuMove& NewMove){
+	Moves[NewMove.SourceMoveIdx].SetDoorUsed(NewMove.SourceDoorIdx);
+	NewMove.SetDoorUsed(NewMove.TargetDoorIdx);
+	NewMove.MoveIdx = Moves.Num();
+	AddPlacedRoom(NewMove.SpawnedTransform, NewMove.RoomData->Room.BoxExtent);
+	TrackMove(NewMove, true);
+	Moves.Add(MoveTemp(NewMove));
+}
+
+int32 ALevelGeneratorActor::FillDataZones(UReberuData* ReberuData, const FTransform& StartTransform, TArray<FReberuMove>& Moves){
+	FReberuZoneFill ZoneFill;
+	BeginDataZones(ReberuData, StartTransform, ZoneFill);
+	while(StepDataZones(ReberuData, Moves, ZoneFill)){}
+	return ZoneFill.NumBacktracks;
+}
+
+void ALevelGeneratorActor::BeginDataZones(UReberuData* ReberuData, const FTransform& StartTransform, FReberuZoneFill& ZoneFill){
+	ZoneFill = FReberuZoneFill();
+	constexpr int32 MaxRegionAttempts = 16;
+
+	// First stage: lay out the zone regions. The first one is around the starting room and every other one is put against
+	// a side of a random region laid out before it, so the zones form a tree.
+	TArray<FReberuDataZone>& DataZones = ZoneFill.Zones;
+	FReberuPlacementIndex RegionIndex;
+	float MaxRegionExtent = 1.f;
+	for (const FReberuZone& Zone : ReberuData->Zones){
+		MaxRegionExtent = FMath::Max(MaxRegionExtent, Zone.RegionExtent.GetMax());
+	}
+	RegionIndex.Reset(MaxRegionExtent * 2.f);
+	const FQuat RegionRotation = StartTransform.GetRotation();
+
+	for (int32 ZoneIdx = 0; ZoneIdx < ReberuData->Zones.Num(); ZoneIdx++){
+		const FVector& RegionExtent = ReberuData->Zones[ZoneIdx].RegionExtent;
+		for (int32 Count = 0; Count < ReberuData->Zones[ZoneIdx].Count; Count++){
+			FReberuDataZone& DataZone = DataZones.AddDefaulted_GetRef();
+			DataZone.ZoneIdx = ZoneIdx;
+
+			bool bPlaced = DataZones.Num() == 1;
+			if(bPlaced){
+				DataZone.RegionTransform = FTransform(RegionRotation, StartTransform.GetLocation());
+			}
+			for (int32 Attempt = 0; Attempt < MaxRegionAttempts && !bPlaced; Attempt++){
+				DataZone.ParentIdx = ReberuRandomStream.RandRange(0, DataZones.Num() - 2);
+				const FReberuDataZone& Parent = DataZones[DataZone.ParentIdx];
+				const FVector& ParentExtent = ReberuData->Zones[Parent.ZoneIdx].RegionExtent;
+
+				// One of the 4 horizontal sides, slid along it so the smaller region's side is fully shared
+				const int32 Side = ReberuRandomStream.RandRange(0, 3);
+				const int32 Axis = Side & 1;
+				const int32 OtherAxis = 1 - Axis;
+				FVector LocalOffset = FVector::ZeroVector;
+				LocalOffset[Axis] = (Side & 2 ? -1.f : 1.f) * (ParentExtent[Axis] + RegionExtent[Axis]);
+				LocalOffset[OtherAxis] = ReberuRandomStream.FRandRange(-1.f, 1.f) * FMath::Abs(ParentExtent[OtherAxis] - RegionExtent[OtherAxis]);
+
+				DataZone.RegionTransform = FTransform(RegionRotation, Parent.RegionTransform.TransformPositionNoScale(LocalOffset));
+				bPlaced = !RegionIndex.Overlaps(DataZone.RegionTransform, RegionExtent);
+			}
+
+			if(bPlaced){
+				RegionIndex.Add(DataZone.RegionTransform, RegionExtent);
+			}
+			else{
+				REBERU_LOG_ARGS(Verbose, "Couldn't find space for a zone of kind %d, skipping it.", ZoneIdx)
+				DataZones.Pop(EAllowShrinking::No);
+			}
+		}
+	}
+}
+
+bool ALevelGeneratorActor::StepDataZones(UReberuData* ReberuData, TArray<FReberuMove>& Moves, FReberuZoneFill& ZoneFill){
+	// Second stage: fill the zones in order, so a zone's parent is always filled before it. Each zone only searches the rooms of its kind
+	// and only tests overlaps against its own rooms, since the rooms of other zones are outside of its region.
+	if(ZoneFill.Zones.IsValidIndex(ZoneFill.DataZoneIdx)){
+		if(StepDataLayout(ReberuData, Moves, ZoneFill.Fill)) return true;
+
+		ZoneFill.NumBacktracks += ZoneFill.Fill.NumBacktracks;
+		ZoneFill.Zones[ZoneFill.DataZoneIdx].EndMoveIdx = Moves.Num();
+	}
+
+	// The current zone is done, start the next one
+	ZoneFill.DataZoneIdx++;
+	if(ZoneFill.DataZoneIdx >= ZoneFill.Zones.Num() || Moves.Num() >= ReberuData->TargetRoomAmount){
+		ZoneFill.DataZoneIdx = ZoneFill.Zones.Num();
+		CurrentZoneIdx = INDEX_NONE;
+		return false;
+	}
+
+	FReberuDataZone& DataZone = ZoneFill.Zones[ZoneFill.DataZoneIdx];
+	const FReberuZone& Zone = ReberuData->Zones[DataZone.ZoneIdx];
+	CurrentZoneIdx = DataZone.ZoneIdx;
+	PlacementIndex.Reset();
+	PlacementIndex.SetRegion(DataZone.RegionTransform, Zone.RegionExtent);
+
+	// A zone that can't be connected stays empty, its fill is done right away
+	ZoneFill.Fill = FReberuDataFill();
+	DataZone.FirstMoveIdx = Moves.Num();
+	DataZone.EndMoveIdx = Moves.Num();
+	if(ZoneFill.DataZoneIdx == 0){
+		DataZone.FirstMoveIdx = 0;
+		PlacementIndex.Add(Moves[0].SpawnedTransform, Moves[0].RoomData->Room.BoxExtent);
+	}
+	else if(const FReberuDataZone& Parent = ZoneFill.Zones[DataZone.ParentIdx];
+		!ConnectDataZone(ReberuData, Moves, Parent.FirstMoveIdx, Parent.EndMoveIdx, DataZone.RegionTransform.GetLocation())){
+		REBERU_LOG_ARGS(Verbose, "Couldn't connect zone %d to zone %d, skipping it.", ZoneFill.DataZoneIdx, DataZone.ParentIdx)
+		return true;
+	}
+
+	const int32 TargetAmount = FMath::Min(ReberuData->TargetRoomAmount, DataZone.FirstMoveIdx + Zone.RoomAmount);
+	ZoneFill.Fill = MakeDataFill(ReberuData, DataZone.FirstMoveIdx, TargetAmount);
+	return true;
+}
+
+bool ALevelGeneratorActor::ConnectDataZone(UReberuData* ReberuData, TArray<FReberuMove>& Moves, const int32 FirstParentMoveIdx,
+	const int32 EndParentMoveIdx, const FVector& RegionCenter){
+	constexpr int32 MaxSourceRooms = 8;
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+
+	// The rooms of the parent zone that are closest to the region are the likeliest to have a door into it
+	TArray<int32> SourceIdxs;
+	for (int32 MoveIdx = FirstParentMoveIdx; MoveIdx < EndParentMoveIdx; MoveIdx++){
+		if(Moves[MoveIdx].NumUsedDoors < Catalog.RoomNumDoors[Moves[MoveIdx].CatalogIdx]){
+			SourceIdxs.Add(MoveIdx);
+		}
+	}
+	SourceIdxs.Sort([&Moves, &RegionCenter](const int32 A, const int32 B){
+		return FVector::DistSquared(Moves[A].SpawnedTransform.GetLocation(), RegionCenter) < FVector::DistSquared(Moves[B].SpawnedTransform.GetLocation(), RegionCenter);
+	});
+	SourceIdxs.SetNum(FMath::Min(SourceIdxs.Num(), MaxSourceRooms), EAllowShrinking::No);
+
+	for (const int32 SourceIdx : SourceIdxs){
+		FReberuMove NewMove;
+		NewMove.SourceMoveIdx = SourceIdx;
+		FAttemptedMove ChosenMove;
+		while(ChooseNextMove(ReberuData, Moves[SourceIdx], Moves[SourceIdx].UsedDoors, Moves.Num(), NewMove, ChosenMove)){
+			const FReberuMove& SourceMove = Moves[SourceIdx];
+			SetMoveTarget(Catalog, ChosenMove, NewMove);
+			NewMove.SpawnedTransform = CalculateTransformFromDoor(SourceMove.SpawnedTransform, SourceMove.RoomData->Room.ReberuDoors[ChosenMove.SourceDoorIdx],
+				NewMove.RoomData, NewMove.RoomData->Room.ReberuDoors[ChosenMove.TargetDoorIdx]);
+
+			// The index only has the region of the new zone, so this only checks that the room is inside of it (and clear of other generators)
+			if(!OverlapsPlacedRooms(NewMove.SpawnedTransform, NewMove.RoomData->Room.BoxExtent)){
+				AddDataMove(Moves, NewMove);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool ALevelGeneratorActor::BeginScheduledGeneration(UReberuData* ReberuData, const int32 Seed, const FTransform& StartTransform){
+	if(!ReberuData || !CanStartGeneration()) return false;
+
+	bIsGenerating = true;
+	bIsScheduled = true;
+	ScheduledStartTransform = StartTransform;
+	if(!BeginRoomsInData(ReberuData, Seed, StartTransform)){
+		bIsScheduled = false;
+		bIsGenerating = false;
+		return false;
+	}
+	return true;
+}
+
+bool ALevelGeneratorActor::StepScheduledGeneration(){
+	return bIsScheduled && StepRoomsInData();
+}
+
+bool ALevelGeneratorActor::FinishScheduledGeneration(){
+	if(!bIsScheduled) return false;
+	bIsScheduled = false;
+
+	UReberuData* ReberuData = InDataReberuData;
+	bool bSuccess = EndRoomsInData();
+	if(!ReberuData){
+		bIsGenerating = false;
+		return false;
+	}
+	REBERU_LOG_ARGS(Log, "Scheduled generation of %s complete! Created %d rooms!", *ReberuData->GetName(), MovesList.Num())
+
+	// Same as the end of the generate rooms task
+	bSuccess = bSuccess && PreProcessing(ReberuData);
+	if(bSuccess){
+		CloseLoops(ReberuData);
+		OnRoomsGenerated(ReberuData, ScheduledStartTransform);
+	}
+	else{
+		bIsGenerating = false;
+	}
+	return bSuccess;
+}
+
+FReberuPlacementIndex* ALevelGeneratorActor::FindSharedPlacementIndex() const{
+	const UWorld* World = GetWorld();
+	UReberuGenerationSubsystem* GenerationSubsystem = World ? World->GetSubsystem<UReberuGenerationSubsystem>() : nullptr;
+	return GenerationSubsystem ? &GenerationSubsystem->GetSharedPlacementIndex() : nullptr;
+}
+
+bool ALevelGeneratorActor::OverlapsPlacedRooms(const FTransform& BoundsTransform, const FVector& Extent) const{
+	return PlacementIndex.Overlaps(BoundsTransform, Extent) || (SharedPlacementIndex && SharedPlacementIndex->Overlaps(BoundsTransform, Extent))
+		|| (bHasWorldObstacles && WorldObstacleIndex.Overlaps(BoundsTransform, Extent));
+}
+
+int32 ALevelGeneratorActor::AddPlacedRoom(const FTransform& BoundsTransform, const FVector& Extent){
+	if(SharedPlacementIndex){
+		SharedBoxIdxs.Add(SharedPlacementIndex->Add(BoundsTransform, Extent));
+	}
+	return PlacementIndex.Add(BoundsTransform, Extent);
+}
+
+void ALevelGeneratorActor::RemoveLastPlacedRoom(){
+	PlacementIndex.RemoveLast();
+	if(SharedPlacementIndex && SharedBoxIdxs.Num() > 0){
+		SharedPlacementIndex->Remove(SharedBoxIdxs.Pop(EAllowShrinking::No));
+	}
+}
+
+void ALevelGeneratorActor::RemovePlacedRoom(const int32 BoxIdx, const int32 SharedBoxIdx){
+	PlacementIndex.Remove(BoxIdx);
+	if(SharedPlacementIndex && SharedBoxIdx != INDEX_NONE){
+		SharedPlacementIndex->Remove(SharedBoxIdx);
+		// Keep the order, RemoveLastPlacedRoom pops the last one
+		SharedBoxIdxs.RemoveSingle(SharedBoxIdx);
+	}
+}
+
+void ALevelGeneratorActor::BeginPlacedRooms(const FTransform& StartTransform, const FVector& StartExtent){
+	if(bSnapshotWorldObstacles && !bHasWorldObstacles){
+		SnapshotWorldObstacles();
+	}
+	PlacementIndex.Reset();
+	SharedPlacementIndex = FindSharedPlacementIndex();
+	AddPlacedRoom(StartTransform, StartExtent);
+}
+
+void ALevelGeneratorActor::SnapshotWorldObstacles(){
+	UWorld* World = GetWorld();
+	if(!World) return;
+
+	WorldObstacleIndex.Reset();
+	int32 NumSkipped = 0;
+	for (TActorIterator<AActor> ActorIt(World); ActorIt; ++ActorIt){
+		const AActor* Actor = *ActorIt;
+		if(Actor->IsA<ARoomBounds>() || Actor->IsA<ALevelGeneratorActor>()) continue;
+		if(!ObstacleTag.IsNone() && !Actor->ActorHasTag(ObstacleTag)) continue;
+		// Rooms (including pooled ones) are level instances, generators keep them out of each other through the placement indices
+		if(Cast<ULevelStreamingDynamic>(FLevelUtils::FindStreamingLevel(Actor->GetLevel()))) continue;
+
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+		for (const UPrimitiveComponent* Primitive : Primitives){
+			if(!Primitive->IsRegistered() || Primitive->Mobility == EComponentMobility::Movable || !Primitive->IsQueryCollisionEnabled()
+				|| Primitive->GetCollisionObjectType() != ObstacleObjectType) continue;
+
+			const FTransform& ComponentTransform = Primitive->GetComponentTransform();
+			const FBoxSphereBounds LocalBounds = Primitive->CalcLocalBounds();
+			const FVector Extent = LocalBounds.BoxExtent * ComponentTransform.GetScale3D().GetAbs();
+			if(Extent.GetMax() > MaxObstacleExtent){
+				REBERU_LOG_ARGS(Verbose, "Left %s out of the world obstacles, it is larger than the max obstacle extent.", *Primitive->GetReadableName())
+				NumSkipped++;
+				continue;
+			}
+			WorldObstacleIndex.Add(FTransform(ComponentTransform.GetRotation(), ComponentTransform.TransformPosition(LocalBounds.Origin)), Extent);
+		}
+	}
+	bHasWorldObstacles = true;
+	REBERU_LOG_ARGS(Log, "Took a snapshot of %d world obstacles for %s (%d too large)", WorldObstacleIndex.Num(), *GetName(), NumSkipped)
+}
+
+void ALevelGeneratorActor::ReleaseSharedRooms(){
+	// The subsystem (and its index) might already be gone when the world is torn down
+	if(SharedPlacementIndex && FindSharedPlacementIndex() == SharedPlacementIndex){
+		for (const int32 BoxIdx : SharedBoxIdxs){
+			SharedPlacementIndex->Remove(BoxIdx);
+		}
+	}
+	SharedBoxIdxs.Reset();
+	SharedPlacementIndex = nullptr;
+}
+
+bool ALevelGeneratorActor::StartIncrementalGeneration(UReberuData* ReberuData, const int32 Seed, const FTransform StartTransform){
+	if(!ReberuData || !GetWorld() || !HasAuthority()) return false;
+	if(bIsGenerating){
+		REBERU_LOG(Warning, "Level generation has already begun, we can't start incremental generation!")
+		return false;
+	}
+	if(ReplicationMode != EReberuReplicationMode::Full && GetNetMode() != NM_Standalone){
+		REBERU_LOG(Warning, "Incremental generation depends on where the players are, so clients only get its rooms with the Full replication mode.")
+	}
+
+	REBERU_LOG_ARGS(Log, "Starting incremental level generation with %s", *ReberuData->GetName())
+	bIsGenerating = true;
+	bIsIncremental = true;
+	IncrementalReberuData = ReberuData;
+	IncrementalSeed = Seed;
+	IncrementalStartTransform = StartTransform;
+
+	// The starting room is placed by the first expansion once the rooms are loaded
+	IncrementalLoadHandle = ReberuData->LoadGenerationData();
+	return true;
+}
+
+bool ALevelGeneratorActor::BeginIncrementalGeneration(){
+	UReberuData* ReberuData = IncrementalReberuData;
+
+	const bool bCanGenerate = ReberuData->PrepareGeneration(IncrementalLoadHandle.IsValid());
+	IncrementalLoadHandle.Reset();
+	if(!bCanGenerate){
+		bIsIncremental = false;
+		bIsGenerating = false;
+		return false;
+	}
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+
+	ReberuRandomStream = FRandomStream(IncrementalSeed);
+	ResetRuleCache();
+	ResetRoomConstraints(ReberuData);
+	PlacementIndex.Reset();
+	SharedPlacementIndex = FindSharedPlacementIndex();
+	if(bSnapshotWorldObstacles && !bHasWorldObstacles){
+		SnapshotWorldObstacles();
+	}
+
+	UReberuRoomData* StartingRoomData = !ReberuData->StartingRoom.IsNull() ? ReberuData->StartingRoom.Get()
+		: Catalog.Rooms[ReberuRandomStream.RandRange(0, Catalog.NumPlaceableRooms() - 1)];
+	if(!StartingRoomData){
+		REBERU_LOG(Error, "The starting room couldn't be loaded!")
+		bIsIncremental = false;
+		bIsGenerating = false;
+		return false;
+	}
+
+	// We don't know which rooms will be placed, so keep the doors of every room loaded
+	TSet<FGameplayTag> DoorTags;
+	for (const UReberuRoomData* Room : Catalog.Rooms){
+		if(!Room) continue;
+		for (const FReberuDoor& Door : Room->Room.ReberuDoors){
+			DoorTags.Add(Door.DoorTag);
+		}
+	}
+	DoorLoadHandle = ReberuData->LoadDoorData(DoorTags);
+	ActiveReberuData = ReberuData;
+
+	FReberuMove StartMove(StartingRoomData, IncrementalStartTransform);
+	StartMove.CatalogIdx = ReberuData->GetRoomIndex(StartingRoomData);
+	AddIncrementalMove(StartMove);
+	return true;
+}
+
+int32 ALevelGeneratorActor::ExpandIncrementalGeneration(const TConstArrayView<FVector> Locations, const float FrontierDistance, const int32 MaxNewRooms){
+	if(!bIsIncremental) return 0;
+
+	if(IncrementalRooms.Num() == 0){
+		if(IncrementalLoadHandle.IsValid() && !IncrementalLoadHandle->HasLoadCompleted()) return 0;
+		if(!BeginIncrementalGeneration()) return 0;
+	}
+
+	OpenLoadedDoors();
+
+	const float MaxDistanceSquared = FMath::Square(FrontierDistance);
+	TBitArray<> CheckedDoors(false, FrontierDoors.GetMaxIndex());
+	TArray<TPair<float, int32>> NearDoors;
+	auto CheckDoor = [&](const int32 FrontierIdx){
+		if(CheckedDoors[FrontierIdx]) return;
+		CheckedDoors[FrontierIdx] = true;
+
+		float DistanceSquared = MAX_flt;
+		for (const FVector& Location : Locations){
+			DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(Location, FrontierDoors[FrontierIdx].Location));
+		}
+		if(DistanceSquared <= MaxDistanceSquared){
+			NearDoors.Emplace(DistanceSquared, FrontierIdx);
+		}
+	};
+
+	// Only the doors in the cells within FrontierDistance of a location can be near it, unless there are less cells with doors than that
+	const double CellRadius = FMath::CeilToDouble(FrontierDistance / FrontierCellSize);
+	if(FMath::Cube(2. * CellRadius + 1.) * Locations.Num() > FrontierCells.Num()){
+		for (TSparseArray<FReberuFrontierDoor>::TConstIterator It(FrontierDoors); It; ++It){
+			CheckDoor(It.GetIndex());
+		}
+	}
+	else{
+		const int32 NumCells = static_cast<int32>(CellRadius);
+		for (const FVector& Location : Locations){
+			const FIntVector LocationCell = GetFrontierCell(Location);
+			for (int32 X = -NumCells; X <= NumCells; X++){
+				for (int32 Y = -NumCells; Y <= NumCells; Y++){
+					for (int32 Z = -NumCells; Z <= NumCells; Z++){
+						if(const TArray<int32>* CellDoors = FrontierCells.Find(LocationCell + FIntVector(X, Y, Z))){
+							for (const int32 FrontierIdx : *CellDoors){
+								CheckDoor(FrontierIdx);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	if(NearDoors.Num() == 0) return 0;
+
+	// Nearest doors first, so players walking towards a door get its room before the ones behind them
+	NearDoors.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B){return A.Key < B.Key;});
+
+	int32 NumPlaced = 0;
+	for (const TPair<float, int32>& NearDoor : NearDoors){
+		if(NumPlaced >= MaxNewRooms) break;
+
+		FReberuFrontierDoor FrontierDoor = FrontierDoors[NearDoor.Value];
+		RemoveFrontierDoor(NearDoor.Value);
+
+		// Doors that nothing fits behind stay closed
+		FrontierDoor.OpeningMoveIdx = PlaceIncrementalRoom(FrontierDoor.MoveIdx, FrontierDoor.DoorIdx);
+		if(FrontierDoor.OpeningMoveIdx == INDEX_NONE) continue;
+
+		NumPlaced++;
+		OpeningDoors.Add(FrontierDoor);
+	}
+
+	if(NumPlaced > 0){
+		REBERU_LOG_ARGS(Verbose, "Placed %d rooms, %d rooms in total and %d doors on the frontier.", NumPlaced, IncrementalRooms.Num(), FrontierDoors.Num())
+	}
+	return NumPlaced;
+}
+
+int32 ALevelGeneratorActor::EvictIncrementalRooms(const TConstArrayView<FVector> Locations, const float EvictionDistance){
+	if(!bIsIncremental || EvictionDistance <= 0.f || Locations.Num() == 0 || IncrementalRooms.Num() == 0) return 0;
+
+	// Rooms with a door still opening are next to a new room, so they stay
+	const double MinDistanceSquared = FMath::Square(EvictionDistance);
+	TBitArray<> EvictedRooms(false, IncrementalRooms.GetMaxIndex());
+	int32 NumEvicted = 0;
+	for (TSparseArray<FReberuIncrementalRoom>::TConstIterator It(IncrementalRooms); It; ++It){
+		const int32 MoveIdx = It.GetIndex();
+		const FReberuMove& Move = It->Move;
+		const FVector& Extent = Move.RoomData->Room.BoxExtent;
+		const FBox Bounds = FBox(-Extent, Extent).TransformBy(Move.SpawnedTransform);
+		bool bIsFar = !OpeningDoors.ContainsByPredicate([MoveIdx](const FReberuFrontierDoor& OpeningDoor){
+			return OpeningDoor.MoveIdx == MoveIdx || OpeningDoor.OpeningMoveIdx == MoveIdx;
+		});
+		for (int32 LocationIdx = 0; bIsFar && LocationIdx < Locations.Num(); LocationIdx++){
+			bIsFar = Bounds.ComputeSquaredDistanceToPoint(Locations[LocationIdx]) > MinDistanceSquared;
+		}
+		if(bIsFar){
+			EvictedRooms[MoveIdx] = true;
+			NumEvicted++;
+		}
+	}
+	// Players far from every room (like right after a teleport) would leave nothing to grow from
+	if(NumEvicted == 0 || NumEvicted == IncrementalRooms.Num()) return 0;
+
+	for (TSparseArray<FReberuFrontierDoor>::TIterator It(FrontierDoors); It; ++It){
+		if(!EvictedRooms[It->MoveIdx]) continue;
+
+		RemoveFrontierBlockedDoor(*It);
+		RemoveFrontierDoor(It.GetIndex());
+	}
+
+	// The doors between an evicted room and a remaining one close on the remaining room's side, rooms whose parent is evicted become roots
+	TArray<TPair<int32, int32>> ClosedDoors;
+	for (TSparseArray<FReberuIncrementalRoom>::TIterator It(IncrementalRooms); It; ++It){
+		FReberuMove& Move = It->Move;
+		const int32 MoveIdx = It.GetIndex();
+		if(Move.SourceMoveIdx == INDEX_NONE || EvictedRooms[MoveIdx] == EvictedRooms[Move.SourceMoveIdx]) continue;
+
+		RemoveIncrementalEntryDoor(*It);
+		if(EvictedRooms[MoveIdx]){
+			ClosedDoors.Emplace(Move.SourceMoveIdx, Move.SourceDoorIdx);
+			continue;
+		}
+		ClosedDoors.Emplace(MoveIdx, Move.TargetDoorIdx);
+		TrackMove(Move, false);
+		Move.SourceMoveIdx = INDEX_NONE;
+		Move.SourceDoorIdx = INDEX_NONE;
+		TrackMove(Move, true);
+		if(FRoomLevel* RoomLevel = FindRoomLevel(MoveIdx)){
+			RoomLevel->ParentIndex = INDEX_NONE;
+			SpawnedRoomLevels.MarkItemDirty(*RoomLevel);
+		}
+	}
+
+	for (TConstSetBitIterator<> It(EvictedRooms); It; ++It){
+		const int32 MoveIdx = It.GetIndex();
+		FReberuIncrementalRoom& IncrementalRoom = IncrementalRooms[MoveIdx];
+		RemoveIncrementalEntryDoor(IncrementalRoom);
+		RemovePlacedRoom(IncrementalRoom.BoxIdx, IncrementalRoom.SharedBoxIdx);
+		TrackMove(IncrementalRoom.Move, false);
+		RemoveRoomLevel(MoveIdx);
+		IncrementalRooms.RemoveAt(MoveIdx);
+	}
+
+	for (const TPair<int32, int32>& ClosedDoor : ClosedDoors){
+		IncrementalRooms[ClosedDoor.Key].Move.SetDoorUsed(ClosedDoor.Value, false);
+		AddFrontierDoor(ClosedDoor.Key, ClosedDoor.Value);
+	}
+	for (const TPair<int32, int32>& ClosedDoor : ClosedDoors){
+		UpdateIncrementalRoomDoors(ClosedDoor.Key);
+	}
+	MarkRoomLevelsChanged();
+
+	REBERU_LOG_ARGS(Verbose, "Evicted %d rooms, %d rooms left and %d doors on the frontier.", NumEvicted, IncrementalRooms.Num(), FrontierDoors.Num())
+	return NumEvicted;
+}
+
+int32 ALevelGeneratorActor::PlaceIncrementalRoom(const int32 SourceMoveIdx, const int32 SourceDoorIdx){
+	// Room levels store their layout index in an int16
+	if(IncrementalRooms.Num() >= UReberuData::MaxLayoutRooms) return INDEX_NONE;
+
+	UReberuData* ReberuData = IncrementalReberuData;
+	const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+
+	// Only the frontier door can be chosen, so every other door counts as used
+	TBitArray<> OtherDoors(true, Catalog.RoomNumDoors[IncrementalRooms[SourceMoveIdx].Move.CatalogIdx]);
+	if(OtherDoors.IsValidIndex(SourceDoorIdx)){
+		OtherDoors[SourceDoorIdx] = false;
+	}
+
+	FReberuMove NewMove;
+	NewMove.SourceMoveIdx = SourceMoveIdx;
+	FAttemptedMove ChosenMove;
+	// The layout never ends, so constraints are checked as if no rooms were placed: maximums still apply but minimums can't be guaranteed
+	while(ChooseNextMove(ReberuData, IncrementalRooms[SourceMoveIdx].Move, OtherDoors, 0, NewMove, ChosenMove)){
+		const FReberuMove& SourceMove = IncrementalRooms[SourceMoveIdx].Move;
+		SetMoveTarget(Catalog, ChosenMove, NewMove);
+		NewMove.SpawnedTransform = CalculateTransformFromDoor(SourceMove.SpawnedTransform, SourceMove.RoomData->Room.ReberuDoors[ChosenMove.SourceDoorIdx],
+			NewMove.RoomData, NewMove.RoomData->Room.ReberuDoors[ChosenMove.TargetDoorIdx]);
+		if(!OverlapsPlacedRooms(NewMove.SpawnedTransform, NewMove.RoomData->Room.BoxExtent)){
+			return AddIncrementalMove(NewMove);
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 ALevelGeneratorActor::AddIncrementalMove(FReberuMove& NewMove){
+	// Evicted rooms free their index, so layout indices stay below the most rooms there were at once
+	const int32 MoveIdx = IncrementalRooms.Add(FReberuIncrementalRoom());
+	NewMove.MoveIdx = MoveIdx;
+	if(IncrementalRooms.IsValidIndex(NewMove.SourceMoveIdx)){
+		IncrementalRooms[NewMove.SourceMoveIdx].Move.SetDoorUsed(NewMove.SourceDoorIdx);
+		NewMove.SetDoorUsed(NewMove.TargetDoorIdx);
+	}
+	FReberuIncrementalRoom& IncrementalRoom = IncrementalRooms[MoveIdx];
+	IncrementalRoom.BoxIdx = AddPlacedRoom(NewMove.SpawnedTransform, NewMove.RoomData->Room.BoxExtent);
+	IncrementalRoom.SharedBoxIdx = SharedPlacementIndex ? SharedBoxIdxs.Last() : INDEX_NONE;
+	TrackMove(NewMove, true);
+
+	// The room is finalized right away, its level loads behind the closed door. Level names have to be unique even when the layout index is reused.
+	UReberuRoomData* RoomData = NewMove.RoomData;
+	NewMove.SpawnedLevel = SpawnRoom(RoomData, RoomData->Room.GetLevelOffsetTransform() * NewMove.SpawnedTransform, MakeRoomLevelName(RoomData, NumIncrementalLevels++),
+		NewMove.SourceMoveIdx, MoveIdx);
+	IncrementalRoom.Move = MoveTemp(NewMove);
+
+	// Every other door stays closed until a room is placed behind it
+	const FReberuMove& Move = IncrementalRoom.Move;
+	for (int32 DoorIdx = 0; DoorIdx < RoomData->Room.ReberuDoors.Num(); DoorIdx++){
+		if(Move.SourceMoveIdx != INDEX_NONE && DoorIdx == Move.TargetDoorIdx) continue;
+
+		AddFrontierDoor(MoveIdx, DoorIdx);
+	}
+
+	UpdateIncrementalRoomDoors(MoveIdx);
+	return MoveIdx;
+}
+
+void ALevelGeneratorActor::AddFrontierDoor(const int32 MoveIdx, const int32 DoorIdx){
+	const FReberuMove& Move = IncrementalRooms[MoveIdx].Move;
+	const FReberuDoor& Door = Move.RoomData->Room.ReberuDoors[DoorIdx];
+
+	FReberuFrontierDoor FrontierDoor;
+	FrontierDoor.MoveIdx = MoveIdx;
+	FrontierDoor.DoorIdx = DoorIdx;
+	FrontierDoor.Location = GetDoorWorldTransform(Door, Move.SpawnedTransform).GetLocation();
+	FrontierDoor.InstanceTag = Door.DoorTag;
+	FrontierDoor.BlockedDoor = SpawnDoor(IncrementalReberuData, Door, Move.SpawnedTransform, true, &FrontierDoor.InstanceIdx);
+
+	const int32 FrontierIdx = FrontierDoors.Add(FrontierDoor);
+	FrontierCells.FindOrAdd(GetFrontierCell(FrontierDoor.Location)).Add(FrontierIdx);
+}
+
+void ALevelGeneratorActor::RemoveFrontierDoor(const int32 FrontierIdx){
+	const FIntVector Cell = GetFrontierCell(FrontierDoors[FrontierIdx].Location);
+	TArray<int32>& CellDoors = FrontierCells.FindChecked(Cell);
+	CellDoors.RemoveSingleSwap(FrontierIdx, EAllowShrinking::No);
+	if(CellDoors.Num() == 0) FrontierCells.Remove(Cell);
+
+	FrontierDoors.RemoveAt(FrontierIdx);
+}
+
+FIntVector ALevelGeneratorActor::GetFrontierCell(const FVector& Location) const{
+	return FIntVector(FMath::FloorToInt32(Location.X / FrontierCellSize), FMath::FloorToInt32(Location.Y / FrontierCellSize), FMath::FloorToInt32(Location.Z / FrontierCellSize));
+}
+
+void ALevelGeneratorActor::OpenLoadedDoors(){
+	for (int32 OpeningIdx = OpeningDoors.Num() - 1; OpeningIdx >= 0; OpeningIdx--){
+		const FReberuFrontierDoor FrontierDoor = OpeningDoors[OpeningIdx];
+		FReberuIncrementalRoom& NewRoom = IncrementalRooms[FrontierDoor.OpeningMoveIdx];
+		FReberuMove& NewMove = NewRoom.Move;
+		if(NewMove.SpawnedLevel && !NewMove.SpawnedLevel->IsLevelVisible()) continue;
+
+		OpeningDoors.RemoveAtSwap(OpeningIdx, 1, EAllowShrinking::No);
+		RemoveFrontierBlockedDoor(FrontierDoor);
+		NewMove.SpawnedDoor = SpawnDoor(IncrementalReberuData, NewMove.RoomData->Room.ReberuDoors[NewMove.TargetDoorIdx], NewMove.SpawnedTransform, false,
+			&NewRoom.DoorInstanceIdx);
+
+		UpdateIncrementalRoomDoors(FrontierDoor.MoveIdx);
+		UpdateIncrementalRoomDoors(FrontierDoor.OpeningMoveIdx);
+	}
+}
+
+void ALevelGeneratorActor::RemoveFrontierBlockedDoor(const FReberuFrontierDoor& FrontierDoor){
+	if(AActor* BlockedDoor = FrontierDoor.BlockedDoor.Get()){
+		BlockedDoor->Destroy();
+	}
+	if(FrontierDoor.InstanceIdx != INDEX_NONE){
+		HideDoorInstance(FrontierDoor.InstanceTag, FrontierDoor.InstanceIdx, true);
+	}
+}
+
+void ALevelGeneratorActor::RemoveIncrementalEntryDoor(FReberuIncrementalRoom& IncrementalRoom){
+	FReberuMove& Move = IncrementalRoom.Move;
+	if(Move.SpawnedDoor){
+		Move.SpawnedDoor->Destroy();
+		Move.SpawnedDoor = nullptr;
+	}
+	const TArray<FReberuDoor>& Doors = Move.RoomData->Room.ReberuDoors;
+	if(IncrementalRoom.DoorInstanceIdx != INDEX_NONE && Doors.IsValidIndex(Move.TargetDoorIdx)){
+		HideDoorInstance(Doors[Move.TargetDoorIdx].DoorTag, IncrementalRoom.DoorInstanceIdx, false);
+	}
+	IncrementalRoom.DoorInstanceIdx = INDEX_NONE;
+}
+
+void ALevelGeneratorActor::RemoveRoomLevel(const int32 RoomIdx){
+	TArray<FRoomLevel>& Items = SpawnedRoomLevels.Items;
+	const FRoomLevel* RoomLevel = FindRoomLevel(RoomIdx);
+	if(!RoomLevel) return;
+
+	ULevelStreamingDynamic* SpawnedLevel = nullptr;
+	if(LocalSpawnedLevels.RemoveAndCopyValue(RoomLevel->LevelName, SpawnedLevel)){
+		ReleaseRoom(SpawnedLevel);
+	}
+
+	// The last item takes the place of the removed one
+	const int32 ItemIdx = UE_PTRDIFF_TO_INT32(RoomLevel - Items.GetData());
+	Items.RemoveAtSwap(ItemIdx);
+	SetRoomLevelItemIdx(RoomIdx, INDEX_NONE);
+	if(Items.IsValidIndex(ItemIdx)){
+		SetRoomLevelItemIdx(Items[ItemIdx].RoomIdx, ItemIdx);
+	}
+	SpawnedRoomLevels.MarkArrayDirty();
+}
+
+void ALevelGeneratorActor::UpdateIncrementalRoomDoors(const int32 MoveIdx){
+	const FReberuMove& Move = IncrementalRooms[MoveIdx].Move;
+	const TArray<FReberuDoor>& Doors = Move.RoomData->Room.ReberuDoors;
+
+	// Doors with a room still loading behind them are closed too
+	TArray<int32> BlockedDoorIdxs;
+	for (int32 DoorIdx = 0; DoorIdx < Doors.Num(); DoorIdx++){
+		if(!Move.IsDoorUsed(DoorIdx)){
+			BlockedDoorIdxs.Add(DoorIdx);
+		}
+	}
+	bool bIsEntryOpen = Move.SourceMoveIdx != INDEX_NONE;
+	for (const FReberuFrontierDoor& OpeningDoor : OpeningDoors){
+		if(OpeningDoor.MoveIdx == MoveIdx){
+			BlockedDoorIdxs.Add(OpeningDoor.DoorIdx);
+		}
+		bIsEntryOpen &= OpeningDoor.OpeningMoveIdx != MoveIdx;
+	}
+	SetRoomDoors(MoveIdx, bIsEntryOpen ? Move.TargetDoorIdx : INDEX_NONE, BlockedDoorIdxs);
+}
+
+void ALevelGeneratorActor::OnConstruction(const FTransform& Transform){
+	Super::OnConstruction(Transform);
+
+#if WITH_EDITOR
+	// Moving the actor or changing the preview settings reruns construction
+	const UWorld* World = GetWorld();
+	if(World && World->WorldType == EWorldType::Editor){
+		RefreshPreview();
+	}
+#endif
+}
+
+#if WITH_EDITOR
+void ALevelGeneratorActor::RefreshPreview(){
+	if(!PreviewLineBatcher) return;
+
+	PreviewLineBatcher->Flush();
+	if(!bPreviewLayout || !PreviewReberuData || bIsGenerating) return;
+
+	if(!PreviewObjectChangedHandle.IsValid()){
+		PreviewObjectChangedHandle = FCoreUObjectDelegates::OnObjectPropertyChanged.AddUObject(this, &ALevelGeneratorActor::OnPreviewObjectChanged);
+	}
+
+	// The rooms have to be loaded to generate, which only has to wait the first time
+	if(const TSharedPtr<FStreamableHandle> LoadHandle = PreviewReberuData->LoadGenerationData()){
+		LoadHandle->WaitUntilComplete();
+		PreviewReberuData->InvalidateCatalog();
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<FReberuMove> PreviewMoves;
+	const bool bSuccess = GenerateDataLayout(PreviewReberuData, PreviewSeed, GetActorTransform(), PreviewMoves);
+	DrawPreviewLayout(PreviewMoves);
+
+	REBERU_LOG_ARGS(Log, "Previewed %d rooms of %s with seed %d in %.2fms%s", PreviewMoves.Num(), *PreviewReberuData->GetName(), PreviewSeed,
+		(FPlatformTime::Seconds() - StartTime) * 1000.0, bSuccess ? TEXT("") : TEXT(" (generation would fail)"))
+}
+
+void ALevelGeneratorActor::SetPreview(UReberuData* InReberuData, const int32 InSeed){
+	Modify();
+	bPreviewLayout = true;
+	PreviewReberuData = InReberuData;
+	PreviewSeed = InSeed;
+	RefreshPreview();
+}
+
+void ALevelGeneratorActor::DrawPreviewLayout(const TArray<FReberuMove>& PreviewMoves) const{
+	TArray<FBatchedLine> Lines;
+	Lines.Reserve(PreviewMoves.Num() * 14);
+
+	for (const FReberuMove& Move : PreviewMoves){
+		const FVector& Extent = Move.RoomData->Room.BoxExtent;
+		const FLinearColor RoomColor = Move.SourceMoveIdx == INDEX_NONE ? FLinearColor::Green : FLinearColor::White;
+
+		// Each bit of the corner index picks the positive side of an axis, so edges connect corners that differ by one bit
+		FVector Corners[8];
+		for (int32 CornerIdx = 0; CornerIdx < 8; CornerIdx++){
+			const FVector LocalCorner(CornerIdx & 1 ? Extent.X : -Extent.X, CornerIdx & 2 ? Extent.Y : -Extent.Y, CornerIdx & 4 ? Extent.Z : -Extent.Z);
+			Corners[CornerIdx] = Move.SpawnedTransform.TransformPosition(LocalCorner);
+		}
+		for (int32 CornerIdx = 0; CornerIdx < 8; CornerIdx++){
+			for (int32 AxisBit = 1; AxisBit < 8; AxisBit <<= 1){
+				if(!(CornerIdx & AxisBit)){
+					Lines.Emplace(Corners[CornerIdx], Corners[CornerIdx | AxisBit], RoomColor, 0.f, PreviewLineThickness, SDPG_World);
+				}
+			}
+		}
+
+		// Connect the room to its source room through the door they share
+		if(PreviewMoves.IsValidIndex(Move.SourceMoveIdx)){
+			const FReberuMove& SourceMove = PreviewMoves[Move.SourceMoveIdx];
+			const FVector DoorLocation = GetDoorWorldTransform(SourceMove.RoomData->Room.ReberuDoors[Move.SourceDoorIdx], SourceMove.SpawnedTransform).GetLocation();
+			Lines.Emplace(SourceMove.SpawnedTransform.GetLocation(), DoorLocation, FLinearColor::Yellow, 0.f, PreviewLineThickness, SDPG_World);
+			Lines.Emplace(DoorLocation, Move.SpawnedTransform.GetLocation(), FLinearColor::Yellow, 0.f, PreviewLineThickness, SDPG_World);
+		}
+	}
+
+	PreviewLineBatcher->DrawLines(Lines);
+}
+
+void ALevelGeneratorActor::OnPreviewObjectChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent){
+	if(!bPreviewLayout || !PreviewReberuData || !Object) return;
+
+	if(Object == PreviewReberuData){
+		RefreshPreview();
+	}
+	else if(const UReberuRoomData* RoomData = Cast<UReberuRoomData>(Object); RoomData && PreviewReberuData->GetRoomIndex(RoomData) != INDEX_NONE){
+		PreviewReberuData->InvalidateCatalog();
+		RefreshPreview();
+	}
+}
+
+void ALevelGeneratorActor::BeginDestroy(){
+	FCoreUObjectDelegates::OnObjectPropertyChanged.Remove(PreviewObjectChangedHandle);
+	PreviewObjectChangedHandle.Reset();
+
+	Super::BeginDestroy();
+}
+#endif
+
+void ALevelGeneratorActor::GatherDoorPairs(UReberuData* ReberuData, const FReberuRoomCatalog& Catalog, FReberuMove& SourceMove, const TArray<int32>& SourceDoorChoices,
+	const int32 TargetRoomIdx, TArray<FAttemptedMove>& OutMoves, TArray<float>& OutWeights){
+	const int32 SourceRoomIdx = SourceMove.CatalogIdx;
+	TArray<int32>& TargetDoorChoices = TargetDoorScratch;
+
+	for(const int32 SourceDoorIdx : SourceDoorChoices){
+		const int32 SourceCatalogDoor = Catalog.GetDoorIndex(SourceRoomIdx, SourceDoorIdx);
+		const bool bSourceOnlySameDoor = EnumHasAnyFlags(Catalog.DoorFlags[SourceCatalogDoor], EReberuCatalogDoorFlags::OnlyConnectSameDoor);
+		const uint16 SourceTagIdx = Catalog.DoorTagIdx[SourceCatalogDoor];
+
+		TargetDoorChoices.Reset();
+		for(int32 DoorIdx = 0; DoorIdx < Catalog.RoomNumDoors[TargetRoomIdx]; DoorIdx++){
+			TargetDoorChoices.Add(DoorIdx);
+		}
+		ChooseTargetDoor(TargetDoorChoices, ReberuData, SourceMove, SourceDoorIdx, TargetRoomIdx);
+		
+		for(const int32 TargetDoorIdx : TargetDoorChoices){
+			const int32 TargetCatalogDoor = Catalog.GetDoorIndex(TargetRoomIdx, TargetDoorIdx);
+			if(bSourceOnlySameDoor || EnumHasAnyFlags(Catalog.DoorFlags[TargetCatalogDoor], EReberuCatalogDoorFlags::OnlyConnectSameDoor)){
+				if(!Catalog.AreTagsCompatible(SourceTagIdx, Catalog.DoorTagIdx[TargetCatalogDoor])) continue;
+			}
+
+			const float PairWeight = Catalog.DoorWeights[SourceCatalogDoor] * Catalog.DoorWeights[TargetCatalogDoor];
+			if(PairWeight <= 0.f) continue;
+
+			const FAttemptedMove PossibleMove(TargetRoomIdx, SourceDoorIdx, TargetDoorIdx);
+			if(!SourceMove.AttemptedMoves.Contains(PossibleMove)){
+				OutMoves.Add(PossibleMove);
+				OutWeights.Add(PairWeight);
+			}
+		}
+	}
+}
+
+void ALevelGeneratorActor::ResetRuleCache(){
+	PureRuleResults.Reset();
+	PureRulesEvaluated.Reset();
+}
+
+void ALevelGeneratorActor::ResetRoomConstraints(UReberuData* ReberuData){
+	ConstrainedReberuData = ReberuData;
+	RoomConstraintCounts.Init(0, ReberuData ? ReberuData->GetCatalog().NumConstraints() : 0);
+	OpenDoorCount = 0;
+	// The catalog might have been rebuilt since the pools were made
+	RoomPools.Reset();
+}
+
+const FReberuRoomPool& ALevelGeneratorActor::GetRoomPool(const FReberuRoomCatalog& Catalog){
+	// Constraints past the bits of the key are only checked once a room is drawn
+	constexpr int32 MaxKeyConstraints = 48;
+	const int32 NumKeyConstraints = RoomConstraintCounts.Num() == Catalog.NumConstraints() ? FMath::Min(RoomConstraintCounts.Num(), MaxKeyConstraints) : 0;
+	uint64 PoolKey = static_cast<uint16>(CurrentZoneIdx + 1);
+	for(int32 ConstraintIdx = 0; ConstraintIdx < NumKeyConstraints; ConstraintIdx++){
+		if(RoomConstraintCounts[ConstraintIdx] >= Catalog.ConstraintMax[ConstraintIdx]){
+			PoolKey |= 1ull << (16 + ConstraintIdx);
+		}
+	}
+	if(const FReberuRoomPool* Pool = RoomPools.Find(PoolKey)) return *Pool;
+
+	FReberuRoomPool& Pool = RoomPools.Add(PoolKey);
+	TArray<float> Weights;
+	for(int32 RoomIdx = 0; RoomIdx < Catalog.NumPlaceableRooms(); RoomIdx++){
+		// Rooms without doors (or that failed to load) can never connect
+		if(Catalog.RoomNumDoors[RoomIdx] == 0 || Catalog.RoomWeights[RoomIdx] <= 0.f) continue;
+		if(CurrentZoneIdx != INDEX_NONE && !Catalog.IsInZone(CurrentZoneIdx, RoomIdx)) continue;
+
+		bool bExceedsMax = false;
+		for(int32 ConstraintIdx = 0; ConstraintIdx < NumKeyConstraints && !bExceedsMax; ConstraintIdx++){
+			bExceedsMax = (PoolKey & (1ull << (16 + ConstraintIdx))) && Catalog.MatchesConstraint(ConstraintIdx, RoomIdx);
+		}
+		if(bExceedsMax) continue;
+
+		Pool.Rooms.Add(RoomIdx);
+		Weights.Add(Catalog.RoomWeights[RoomIdx]);
+	}
+	Pool.AliasTable.Build(Weights);
+	return Pool;
+}
+
+void ALevelGeneratorActor::TrackMove(const FReberuMove& Move, const bool bAdded){
+	if(!ConstrainedReberuData) return;
+
+	const FReberuRoomCatalog& Catalog = ConstrainedReberuData->GetCatalog();
+	if(!Catalog.Rooms.IsValidIndex(Move.CatalogIdx)) return;
+
+	const int32 Delta = bAdded ? 1 : -1;
+	for(int32 ConstraintIdx = 0; ConstraintIdx < RoomConstraintCounts.Num(); ConstraintIdx++){
+		if(Catalog.MatchesConstraint(ConstraintIdx, Move.CatalogIdx)){
+			RoomConstraintCounts[ConstraintIdx] += Delta;
+		}
+	}
+
+	// Other than the starting room, a move uses up a door of its source room and its own entry door
+	const int32 UsedDoors = Move.SourceMoveIdx == INDEX_NONE ? 0 : 2;
+	OpenDoorCount += Delta * (Catalog.RoomNumDoors[Move.CatalogIdx] - UsedDoors);
+}
+
+bool ALevelGeneratorActor::AreRoomConstraintsMet() const{
+	if(!ConstrainedReberuData) return true;
+
+	const FReberuRoomCatalog& Catalog = ConstrainedReberuData->GetCatalog();
+	for(int32 ConstraintIdx = 0; ConstraintIdx < RoomConstraintCounts.Num(); ConstraintIdx++){
+		const int32 Count = RoomConstraintCounts[ConstraintIdx];
+		if(Count < Catalog.ConstraintMin[ConstraintIdx] || Count > Catalog.ConstraintMax[ConstraintIdx]){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ALevelGeneratorActor::CanMeetRoomConstraints(const FReberuRoomCatalog& Catalog, const int32 TargetRoomIdx, const int32 RemainingRooms) const{
+	if(RoomConstraintCounts.Num() != Catalog.NumConstraints() || RoomConstraintCounts.Num() == 0) return true;
+
+	// A room can count towards several constraints, so the rooms still needed are at least the biggest missing amount
+	int32 MissingRooms = 0;
+	for(int32 ConstraintIdx = 0; ConstraintIdx < RoomConstraintCounts.Num(); ConstraintIdx++){
+		const int32 Count = RoomConstraintCounts[ConstraintIdx] + (Catalog.MatchesConstraint(ConstraintIdx, TargetRoomIdx) ? 1 : 0);
+		if(Count > Catalog.ConstraintMax[ConstraintIdx]) return false;
+
+		MissingRooms = FMath::Max(MissingRooms, Catalog.ConstraintMin[ConstraintIdx] - Count);
+	}
+	if(MissingRooms == 0) return true;
+
+	// Not enough rooms left after this one
+	if(MissingRooms > RemainingRooms - 1) return false;
+
+	// Every following room needs an open door. Without rooms that add doors each of them uses one up.
+	const int32 OpenDoorsAfter = OpenDoorCount + Catalog.RoomNumDoors[TargetRoomIdx] - 2;
+	if(OpenDoorsAfter <= 0) return false;
+	return Catalog.CanGainOpenDoors() || MissingRooms <= OpenDoorsAfter;
+}
+
+bool ALevelGeneratorActor::PassesRules(UReberuData* ReberuData, const FReberuRoomCatalog& Catalog, const int32 SourceRoomIdx, const int32 TargetRoomIdx){
+	if(!Catalog.HasRules(SourceRoomIdx, TargetRoomIdx)) return true;
+
+	UReberuRoomData* SourceRoom = Catalog.Rooms[SourceRoomIdx];
+	UReberuRoomData* TargetRoom = Catalog.Rooms[TargetRoomIdx];
+
+	const int32 NumPairs = Catalog.NumRooms() * Catalog.NumRooms();
+	if(PureRulesEvaluated.Num() != NumPairs){
+		PureRuleResults.Init(false, NumPairs);
+		PureRulesEvaluated.Init(false, NumPairs);
+	}
+
+	const int32 PairIdx = SourceRoomIdx * Catalog.NumRooms() + TargetRoomIdx;
+	if(!PureRulesEvaluated[PairIdx]){
+		PureRuleResults[PairIdx] = EvaluateRules(ReberuData, SourceRoom, TargetRoom, true);
+		PureRulesEvaluated[PairIdx] = true;
+	}
+	if(!PureRuleResults[PairIdx]) return false;
+
+	return EvaluateRules(ReberuData, SourceRoom, TargetRoom, false);
+}
+
+bool ALevelGeneratorActor::EvaluateRules(const UReberuData* ReberuData, UReberuRoomData* SourceRoom, UReberuRoomData* TargetRoom, const bool bPureRules){
+	auto PassesAll = [bPureRules](const TArray<UReberuRule*>& Rules, UReberuRoomData* OwningRoom, UReberuRoomData* ConnectingRoom){
+		for (UReberuRule* Rule : Rules){
+			if(Rule && Rule->bIsPure == bPureRules && !Rule->EvaluateRule(OwningRoom, ConnectingRoom)) return false;
+		}
+		return true;
+	};
+
+	// Room rules see the room they were added to as the owning room
+	return PassesAll(ReberuData->Rules, SourceRoom, TargetRoom)
+		&& PassesAll(SourceRoom->Rules, SourceRoom, TargetRoom)
+		&& PassesAll(TargetRoom->Rules, TargetRoom, SourceRoom);
+}
+
 void ALevelGeneratorActor::StartGeneration(){
 	if(!CanStartGeneration()) return;
 
@@ -461,6 +2489,10 @@ void ALevelGeneratorActor::StartGeneration(){
 void ALevelGeneratorActor::ClearGeneration(){
 	if(UWorld* World = GetWorld()){
 		World->GetLatentActionManager().RemoveActionsForObject(this);
+		World->GetTimerManager().ClearTimer(SnapshotRequestTimerHandle);
+		if(UReberuGenerationSubsystem* GenerationSubsystem = World->GetSubsystem<UReberuGenerationSubsystem>()){
+			GenerationSubsystem->CancelGeneration(this);
+		}
 	}
 	else{
 		return;
@@ -469,36 +2501,213 @@ void ALevelGeneratorActor::ClearGeneration(){
 		if(Move.TargetRoomBounds){
 			Move.TargetRoomBounds->Destroy();
 		}
-		if(Move.SpawnedLevel){
-			DespawnRoom(Move.SpawnedLevel);
+		if(Move.SpawnedDoor){
+			Move.SpawnedDoor->Destroy();
+		}
+		for (AActor* BlockedDoor : Move.SpawnedBlockedDoors){
+			if(BlockedDoor) BlockedDoor->Destroy();
 		}
+		for (AActor* LoopDoor : Move.SpawnedLoopDoors){
+			if(LoopDoor) LoopDoor->Destroy();
+		}
+	}
+	for (const FReberuIncrementalRoom& IncrementalRoom : IncrementalRooms){
+		if(IncrementalRoom.Move.SpawnedDoor){
+			IncrementalRoom.Move.SpawnedDoor->Destroy();
+		}
+	}
+	for (const FReberuFrontierDoor& FrontierDoor : FrontierDoors){
+		if(AActor* BlockedDoor = FrontierDoor.BlockedDoor.Get()) BlockedDoor->Destroy();
+	}
+	for (const FReberuFrontierDoor& OpeningDoor : OpeningDoors){
+		if(AActor* BlockedDoor = OpeningDoor.BlockedDoor.Get()) BlockedDoor->Destroy();
+	}
+	// Clients don't have moves for replicated rooms, so release everything that was spawned locally
+	for (const TTuple<FString, ULevelStreamingDynamic*>& SpawnedLevel : LocalSpawnedLevels){
+		ReleaseRoom(SpawnedLevel.Value);
+	}
+	ClearDoorInstances();
+	if(DoorLoadHandle.IsValid()){
+		DoorLoadHandle->ReleaseHandle();
+		DoorLoadHandle.Reset();
 	}
 	bIsGenerating = false;
+	bRoomsFinalized = false;
+	bSnapshotRequestPending = false;
+	GenerationId++;
 	MovesList.Empty();
-	SpawnedRoomLevels.Empty();
+	bIsScheduled = false;
+	EndRoomsInData();
+	ReleaseSharedRooms();
+	PlacementIndex.Reset();
+	bIsIncremental = false;
+	IncrementalReberuData = nullptr;
+	IncrementalRooms.Empty();
+	NumIncrementalLevels = 0;
+	FrontierDoors.Empty();
+	FrontierCells.Empty();
+	OpeningDoors.Empty();
+	if(IncrementalLoadHandle.IsValid()){
+		IncrementalLoadHandle->ReleaseHandle();
+		IncrementalLoadHandle.Reset();
+	}
+	ResetRoomConstraints(nullptr);
+	LocalSpawnedLevels.Empty();
+	PendingRoomLevels.Empty();
+
+	// Clients in full replication mode get their rooms removed by the server
+	if(ShouldRecordRoomLevels()){
+		SpawnedRoomLevels.Items.Empty();
+		SpawnedRoomLevels.MarkArrayDirty();
+		RoomLevelItemIdxs.Empty();
+		bRoomLevelItemIdxsDirty = false;
+	}
+	RoomGraph.Reset();
+	MarkRoomLevelsChanged();
+	NavGraph.Reset();
+	NavGraphVersion = INDEX_NONE;
+
+	if(HasAuthority()){
+		SeedLayout = FReberuSeedLayout();
+		PendingSeedLayout = FReberuSeedLayout();
+		LayoutSnapshotId = 0;
+	}
+}
+
+bool ALevelGeneratorActor::ShouldRecordRoomLevels() const{
+	return HasAuthority() || ReplicationMode != EReberuReplicationMode::Full;
+}
+
+bool ALevelGeneratorActor::ResolveRoomLevel(FRoomLevel& RoomLevel) const{
+	const UReberuData* ReberuData = ActiveReberuData ? ActiveReberuData : SeedLayout.ReberuData;
+	if(!ReberuData) return false;
+
+	RoomLevel.InRoom = ReberuData->GetRoomByIndex(RoomLevel.CatalogIdx);
+	RoomLevel.SpawnTransform = FTransform(RoomLevel.Rotation, RoomLevel.Location);
+	return RoomLevel.InRoom != nullptr;
+}
+
+bool ALevelGeneratorActor::SpawnReplicatedRoom(FRoomLevel& RoomLevel){
+	if(!ResolveRoomLevel(RoomLevel)) return false;
+
+	// Names only need to be unique locally, the replication id is unique for as long as the item exists.
+	RoomLevel.LevelName = MakeRoomLevelName(RoomLevel.InRoom, RoomLevel.ReplicationID);
+	if(SpawnRoom(RoomLevel.InRoom, RoomLevel.SpawnTransform, RoomLevel.LevelName, RoomLevel.ParentIndex)){
+		SpawnInstancedRoomDoors(RoomLevel.RoomIdx);
+	}
+	return true;
 }
 
-void ALevelGeneratorActor::OnRep_SpawnedRoomLevels(){
+void ALevelGeneratorActor::OnRoomLevelAdded(FRoomLevel& RoomLevel){
 	if(HasAuthority()) return;
+	bRoomLevelItemIdxsDirty = true;
+	MarkRoomLevelChanged(RoomLevel.RoomIdx);
 
-	TSet<FString> LevelNames;
+	if(!SpawnReplicatedRoom(RoomLevel)){
+		PendingRoomLevels.AddUnique(RoomLevel.RoomIdx);
+	}
+}
 
-	// Add new ones
-	for (auto& [InRoom, SpawnTransform, LevelName] : SpawnedRoomLevels){
-		LevelNames.Add(LevelName);
-		
-		if(ULevelStreamingDynamic* NewRoom = SpawnRoom(InRoom, SpawnTransform, LevelName)){
-			LocalSpawnedLevels.Add(LevelName, NewRoom);
+void ALevelGeneratorActor::OnRoomLevelChanged(FRoomLevel& RoomLevel){
+	if(HasAuthority()) return;
+	MarkRoomLevelChanged(RoomLevel.RoomIdx);
+
+	if(PendingRoomLevels.Contains(RoomLevel.RoomIdx)){
+		if(SpawnReplicatedRoom(RoomLevel)) PendingRoomLevels.Remove(RoomLevel.RoomIdx);
+		return;
+	}
+	// Only the doors change after a room is added
+	bDoorInstancesDirty = true;
+}
+
+void ALevelGeneratorActor::OnRoomLevelRemoved(const FRoomLevel& RoomLevel){
+	if(HasAuthority()) return;
+	bRoomLevelItemIdxsDirty = true;
+	MarkRoomLevelsChanged();
+
+	PendingRoomLevels.Remove(RoomLevel.RoomIdx);
+
+	ULevelStreamingDynamic* SpawnedLevel = nullptr;
+	if(LocalSpawnedLevels.RemoveAndCopyValue(RoomLevel.LevelName, SpawnedLevel)){
+		ReleaseRoom(SpawnedLevel);
+	}
+	// Instances can't be removed per room without shuffling indices, so rebuild them all once this update is done.
+	bDoorInstancesDirty = true;
+}
+
+void ALevelGeneratorActor::OnRoomLevelsReplicated(){
+	if(HasAuthority() || !bDoorInstancesDirty) return;
+	bDoorInstancesDirty = false;
+
+	ClearDoorInstances();
+	for (const FRoomLevel& RoomLevel : SpawnedRoomLevels.Items){
+		if(LocalSpawnedLevels.Contains(RoomLevel.LevelName)){
+			SpawnInstancedRoomDoors(RoomLevel.RoomIdx);
 		}
 	}
-	
-	// Clear previous levels
-	for (TTuple<FString, ULevelStreamingDynamic*> Level : LocalSpawnedLevels){
-		if(!LevelNames.Contains(Level.Key)){
-			Level.Value->SetIsRequestingUnloadAndRemoval(true);
+}
+
+void ALevelGeneratorActor::OnRep_ActiveReberuData(){
+	if(PendingRoomLevels.Num() == 0) return;
+
+	for (auto It = PendingRoomLevels.CreateIterator(); It; ++It){
+		FRoomLevel* RoomLevel = FindRoomLevel(*It);
+		if(!RoomLevel || SpawnReplicatedRoom(*RoomLevel)){
+			It.RemoveCurrent();
 		}
 	}
 }
 
+void FRoomLevel::SerializeSnapshot(FArchive& Ar){
+	Ar << CatalogIdx;
+	Ar << RoomIdx;
+	Ar << ParentIndex;
+	Ar << EntryDoorIdx;
+
+	// Same precision as the fast array: a tenth of a unit for the location and shorts for the rotation
+	FIntVector QuantizedLocation(FMath::RoundToInt(Location.X * 10.f), FMath::RoundToInt(Location.Y * 10.f), FMath::RoundToInt(Location.Z * 10.f));
+	Ar << QuantizedLocation;
+
+	uint16 Pitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+	uint16 Yaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+	uint16 Roll = FRotator::CompressAxisToShort(Rotation.Roll);
+	Ar << Pitch << Yaw << Roll;
+
+	// SetRoomDoors keeps rooms within MaxDoors, so the counts fit a byte. Saving never resizes the arrays of the room.
+	uint8 NumBlockedDoors = static_cast<uint8>(FMath::Min(BlockedDoorIdxs.Num(), UReberuRoomData::MaxDoors));
+	Ar << NumBlockedDoors;
+	if(Ar.IsLoading()) BlockedDoorIdxs.SetNum(NumBlockedDoors);
+	Ar.Serialize(BlockedDoorIdxs.GetData(), NumBlockedDoors);
+
+	uint8 NumLoopDoors = static_cast<uint8>(FMath::Min3(LoopDoorIdxs.Num(), LoopRoomIdxs.Num(), UReberuRoomData::MaxDoors));
+	Ar << NumLoopDoors;
+	if(Ar.IsLoading()){
+		LoopDoorIdxs.SetNum(NumLoopDoors);
+		LoopRoomIdxs.SetNum(NumLoopDoors);
+	}
+	Ar.Serialize(LoopDoorIdxs.GetData(), NumLoopDoors);
+	for (int32 LoopIdx = 0; LoopIdx < NumLoopDoors; LoopIdx++){
+		Ar << LoopRoomIdxs[LoopIdx];
+	}
+
+	if(Ar.IsLoading()){
+		Location = FVector(QuantizedLocation) / 10.f;
+		Rotation = FRotator(FRotator::DecompressAxisFromShort(Pitch), FRotator::DecompressAxisFromShort(Yaw), FRotator::DecompressAxisFromShort(Roll));
+	}
+}
+
+void FRoomLevel::PreReplicatedRemove(const FRoomLevelArray& InArraySerializer){
+	if(InArraySerializer.LevelGenerator) InArraySerializer.LevelGenerator->OnRoomLevelRemoved(*this);
+}
 
+void FRoomLevel::PostReplicatedAdd(const FRoomLevelArray& InArraySerializer){
+	if(InArraySerializer.LevelGenerator) InArraySerializer.LevelGenerator->OnRoomLevelAdded(*this);
+}
 
+void FRoomLevel::PostReplicatedChange(const FRoomLevelArray& InArraySerializer){
+	if(InArraySerializer.LevelGenerator) InArraySerializer.LevelGenerator->OnRoomLevelChanged(*this);
+}
+
+void FRoomLevelArray::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters){
+	if(LevelGenerator) LevelGenerator->OnRoomLevelsReplicated();
+}
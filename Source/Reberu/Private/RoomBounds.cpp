@@ -3,8 +3,11 @@
 
 #include "RoomBounds.h"
 
+#include "LevelGeneratorActor.h"
+#include "NavigationSystem.h"
 #include "Reberu.h"
 #include "Components/BoxComponent.h"
+#include "NavMesh/RecastNavMesh.h"
 
 
 ARoomBounds::ARoomBounds(){
@@ -22,6 +25,7 @@ void ARoomBounds::CreateNewDoor(){
 	const FReberuDoor NewDoor = FReberuDoor();
 	Room.ReberuDoors.Add(NewDoor);
 	CurrentlyEditingDoorId = NewDoor.DoorId;
+	MarkDoorsChanged();
 }
 
 void ARoomBounds::EditDoorAtIdx(){
@@ -40,12 +44,84 @@ void ARoomBounds::DelDoorAtIdx(){
 	if (!Room.ReberuDoors.IsValidIndex(EditDoorIdx)) return;
 
 	Room.ReberuDoors.RemoveAt(EditDoorIdx);
+	MarkDoorsChanged();
 }
 
 void ARoomBounds::RegenerateDoorIds(){
 	for(FReberuDoor& Door : Room.ReberuDoors){
 		Door.GenerateNewDoorId();
 	}
+	MarkDoorsChanged();
+}
+
+void ARoomBounds::BakeNavigation(){
+	UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const ARecastNavMesh* NavMesh = NavSystem ? Cast<ARecastNavMesh>(NavSystem->GetDefaultNavDataInstance(FNavigationSystem::DontCreate)) : nullptr;
+	if(!NavMesh){
+		REBERU_LOG(Warning, "Can't bake the room navigation without a navmesh, build the navigation of the room level first.")
+		return;
+	}
+
+	TArray<FNavPoly> Polys;
+	NavMesh->GetPolysInBox(RoomBox->Bounds.GetBox(), Polys);
+
+	Modify();
+	FReberuRoomNavData& NavData = Room.NavData;
+	NavData = FReberuRoomNavData();
+
+	// Only the polygons inside the (rotated) room box belong to the room
+	const FTransform BoundsTransform = GetActorTransform();
+	const FBox LocalBox(-RoomBox->GetUnscaledBoxExtent(), RoomBox->GetUnscaledBoxExtent());
+	TMap<NavNodeRef, int32> PolyNodes;
+	for (const FNavPoly& Poly : Polys){
+		const FVector LocalCenter = BoundsTransform.InverseTransformPosition(Poly.Center);
+		if(!LocalBox.IsInsideOrOn(LocalCenter)) continue;
+
+		PolyNodes.Add(Poly.Ref, NavData.NodeLocations.Add(FVector3f(LocalCenter)));
+	}
+
+	// Neighboring polygons are linked through the middle of the edge they share, a straight line between their centers can leave the navmesh
+	TArray<FNavigationPortalEdge> Edges;
+	for (const TTuple<NavNodeRef, int32>& PolyNode : PolyNodes){
+		Edges.Reset();
+		NavMesh->GetPolyEdges(PolyNode.Key, Edges);
+		for (const FNavigationPortalEdge& Edge : Edges){
+			const int32* NeighborNode = PolyNodes.Find(Edge.ToRef);
+			// Links go both ways, so only add them from one side
+			if(!NeighborNode || *NeighborNode < PolyNode.Value) continue;
+
+			const int32 EdgeNode = NavData.NodeLocations.Add(FVector3f(BoundsTransform.InverseTransformPosition(Edge.GetMiddlePoint())));
+			NavData.Links.Add(PolyNode.Value);
+			NavData.Links.Add(EdgeNode);
+			NavData.Links.Add(EdgeNode);
+			NavData.Links.Add(*NeighborNode);
+		}
+	}
+
+	// Each door gets its own node, linked to the closest polygon or edge node
+	const int32 NumRoomNodes = NavData.NodeLocations.Num();
+	for (const FReberuDoor& Door : Room.ReberuDoors){
+		const FVector3f DoorLocation(BoundsTransform.InverseTransformPosition(ALevelGeneratorActor::GetDoorWorldTransform(Door, BoundsTransform).GetLocation()));
+		int32 ClosestNode = INDEX_NONE;
+		float ClosestDistSquared = TNumericLimits<float>::Max();
+		for (int32 NodeIdx = 0; NodeIdx < NumRoomNodes; NodeIdx++){
+			const float DistSquared = FVector3f::DistSquared(NavData.NodeLocations[NodeIdx], DoorLocation);
+			if(DistSquared < ClosestDistSquared){
+				ClosestNode = NodeIdx;
+				ClosestDistSquared = DistSquared;
+			}
+		}
+		if(ClosestNode == INDEX_NONE){
+			NavData.DoorNodes.Add(INDEX_NONE);
+			continue;
+		}
+		const int32 DoorNode = NavData.NodeLocations.Add(DoorLocation);
+		NavData.Links.Add(ClosestNode);
+		NavData.Links.Add(DoorNode);
+		NavData.DoorNodes.Add(DoorNode);
+	}
+
+	REBERU_LOG_ARGS(Log, "Baked %d navigation nodes and %d links for %s.", NavData.NodeLocations.Num(), NavData.Links.Num() / 2, *GetName())
 }
 
 void ARoomBounds::BeginPlay(){
@@ -67,9 +143,16 @@ void ARoomBounds::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedE
 		}
 		ManageDoor();
 	}
+	MarkDoorsChanged();
 
 	Super::PostEditChangeProperty(PropertyChangedEvent);
 }
+
+void ARoomBounds::PostEditUndo(){
+	Super::PostEditUndo();
+
+	MarkDoorsChanged();
+}
 #endif
 
 void ARoomBounds::LockDoorGizmo(){
@@ -124,4 +207,5 @@ void ARoomBounds::ManageDoor(){
 	if(!CurrentDoor) return;
 	
 	CurrentDoor->DoorTransform = DoorSpawn;
+	MarkDoorsChanged();
 }
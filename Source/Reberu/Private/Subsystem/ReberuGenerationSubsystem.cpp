@@ -0,0 +1,127 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+
+#include "Subsystem/ReberuGenerationSubsystem.h"
+
+#include "LevelGeneratorActor.h"
+#include "Reberu.h"
+#include "Data/ReberuData.h"
+#include "Engine/StreamableManager.h"
+#include "Settings/ReberuSettings.h"
+
+bool UReberuGenerationSubsystem::QueueGeneration(ALevelGeneratorActor* LevelGenerator, UReberuData* ReberuData, const int32 Seed, const FTransform StartTransform,
+	const int32 Priority){
+	if(!LevelGenerator || !ReberuData) return false;
+
+	if(IsGenerationQueued(LevelGenerator)){
+		REBERU_LOG_ARGS(Warning, "%s already has a generation queued!", *LevelGenerator->GetName())
+		return false;
+	}
+
+	FReberuGenerationJob Job;
+	Job.LevelGenerator = LevelGenerator;
+	Job.ReberuData = ReberuData;
+	Job.Seed = Seed > 0 ? Seed : FMath::RandRange(1, MAX_int32);
+	Job.StartTransform = StartTransform;
+	Job.Priority = Priority;
+	Job.LoadHandle = ReberuData->LoadGenerationData();
+
+	// After the jobs with the same or a higher priority
+	const int32 JobIdx = Jobs.IndexOfByPredicate([Priority](const FReberuGenerationJob& Other){return Other.Priority < Priority;});
+	Jobs.Insert(MoveTemp(Job), JobIdx == INDEX_NONE ? Jobs.Num() : JobIdx);
+
+	REBERU_LOG_ARGS(Log, "Queued generation of %s with %s (priority %d)", *LevelGenerator->GetName(), *ReberuData->GetName(), Priority)
+	return true;
+}
+
+bool UReberuGenerationSubsystem::CancelGeneration(ALevelGeneratorActor* LevelGenerator){
+	return Jobs.RemoveAll([LevelGenerator](const FReberuGenerationJob& Job){return Job.LevelGenerator == LevelGenerator;}) > 0;
+}
+
+bool UReberuGenerationSubsystem::IsGenerationQueued(const ALevelGeneratorActor* LevelGenerator) const{
+	return Jobs.ContainsByPredicate([LevelGenerator](const FReberuGenerationJob& Job){return Job.LevelGenerator == LevelGenerator;});
+}
+
+bool UReberuGenerationSubsystem::TryStartJob(FReberuGenerationJob& Job){
+	if(Job.bStarted) return true;
+	if(Job.LoadHandle.IsValid() && !Job.LoadHandle->HasLoadCompleted()) return false;
+
+	UReberuData* ReberuData = Job.ReberuData.Get();
+	const bool bCanGenerate = ReberuData->PrepareGeneration(Job.LoadHandle.IsValid());
+	Job.LoadHandle.Reset();
+
+	Job.bStarted = true;
+	if(!bCanGenerate || !Job.LevelGenerator->BeginScheduledGeneration(ReberuData, Job.Seed, Job.StartTransform)){
+		REBERU_LOG_ARGS(Error, "%s couldn't start generating with %s!", *Job.LevelGenerator->GetName(), *ReberuData->GetName())
+		Job.bFinished = true;
+		return false;
+	}
+	return true;
+}
+
+void UReberuGenerationSubsystem::FinishJob(FReberuGenerationJob& Job){
+	Job.bFinished = true;
+	Job.bSuccess = Job.LevelGenerator->FinishScheduledGeneration();
+}
+
+void UReberuGenerationSubsystem::Tick(const float DeltaTime){
+	Super::Tick(DeltaTime);
+
+	const UReberuSettings* Settings = GetDefault<UReberuSettings>();
+	const double EndTime = FPlatformTime::Seconds() + Settings->GenerationFrameBudgetMs / 1000.f;
+
+	Jobs.RemoveAll([](const FReberuGenerationJob& Job){return !Job.LevelGenerator.IsValid() || !Job.ReberuData.IsValid();});
+
+	// Every running job places a room each frame so low priorities still make progress, then the rest of the budget goes to the highest priorities
+	TArray<int32, TInlineAllocator<8>> RunningJobs;
+	for (int32 JobIdx = 0; JobIdx < Jobs.Num() && RunningJobs.Num() < Settings->MaxConcurrentGenerations; JobIdx++){
+		FReberuGenerationJob& Job = Jobs[JobIdx];
+		if(!TryStartJob(Job)) continue;
+
+		if(Job.LevelGenerator->StepScheduledGeneration()){
+			RunningJobs.Add(JobIdx);
+		}
+		else{
+			FinishJob(Job);
+		}
+	}
+
+	for (const int32 JobIdx : RunningJobs){
+		if(FPlatformTime::Seconds() >= EndTime) break;
+
+		FReberuGenerationJob& Job = Jobs[JobIdx];
+		bool bHasSteps = true;
+		while(bHasSteps && FPlatformTime::Seconds() < EndTime){
+			bHasSteps = Job.LevelGenerator->StepScheduledGeneration();
+		}
+		if(!bHasSteps){
+			FinishJob(Job);
+		}
+	}
+
+	// Listeners can queue or cancel generations, so they are only told once we are done with the jobs
+	TArray<TPair<TWeakObjectPtr<ALevelGeneratorActor>, bool>> FinishedJobs;
+	for (int32 JobIdx = Jobs.Num() - 1; JobIdx >= 0; JobIdx--){
+		const FReberuGenerationJob& Job = Jobs[JobIdx];
+		if(Job.bFinished){
+			FinishedJobs.Emplace(Job.LevelGenerator, Job.bSuccess);
+			Jobs.RemoveAt(JobIdx);
+		}
+		// Cleared while generating
+		else if(Job.bStarted && !Job.LevelGenerator->IsScheduledGenerationRunning()){
+			Jobs.RemoveAt(JobIdx);
+		}
+	}
+	for (int32 FinishedIdx = FinishedJobs.Num() - 1; FinishedIdx >= 0; FinishedIdx--){
+		OnGenerationFinished.Broadcast(FinishedJobs[FinishedIdx].Key.Get(), FinishedJobs[FinishedIdx].Value);
+	}
+}
+
+TStatId UReberuGenerationSubsystem::GetStatId() const{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UReberuGenerationSubsystem, STATGROUP_Tickables);
+}
+
+bool UReberuGenerationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const{
+	// Editor worlds only generate previews, which don't share the index
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
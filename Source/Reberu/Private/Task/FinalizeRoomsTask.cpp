@@ -17,10 +17,25 @@ void FFinalizeRoomsTask::UpdateOperation(FLatentResponse& Response){
 	}
 	
 	if(bIsFirstCall){
+		// Only load the door assets for the tags that are actually in the layout
+		if(!bRequestedLoad){
+			bRequestedLoad = true;
+			TSet<FGameplayTag> DoorTags;
+			for (const FReberuMove& Move : MovesList){
+				if(!Move.RoomData) continue;
+				for (const FReberuDoor& Door : Move.RoomData->Room.ReberuDoors){
+					DoorTags.Add(Door.DoorTag);
+				}
+			}
+			LevelGenerator->DoorLoadHandle = ReberuData->LoadDoorData(DoorTags);
+		}
+		if(LevelGenerator->DoorLoadHandle.IsValid() && !LevelGenerator->DoorLoadHandle->HasLoadCompleted()) return;
+
 		bIsFirstCall = false;
 		bSuccess = true;
 
 		CurrentMove = MovesList.GetHead();
+		LevelGenerator->ActiveReberuData = ReberuData;
 		
 		// Trigger on started pin
 		Output = EFinalizeRoomsOutputPins::OnStarted;
@@ -30,26 +45,43 @@ void FFinalizeRoomsTask::UpdateOperation(FLatentResponse& Response){
 	
 	if(CurrentMove){
 		REBERU_LOG(Log, "Creating level associated with room...")
-		FTransform TempTransform = CurrentMove->GetValue().RoomData->Room.BoxActorTransform;
-		TempTransform.SetLocation(-TempTransform.GetLocation());
-		TempTransform.SetRotation(TempTransform.GetRotation().Inverse());
-		const FTransform FinalTransform = TempTransform * CurrentMove->GetValue().TargetRoomBounds->GetActorTransform();
+		const FTransform FinalTransform = CurrentMove->GetValue().RoomData->Room.GetLevelOffsetTransform() * CurrentMove->GetValue().TargetRoomBounds->GetActorTransform();
 		CurrentMove->GetValue().SpawnedLevel = LevelGenerator->SpawnRoom(CurrentMove->GetValue().RoomData, FinalTransform,
-		                                                                 CurrentMove->GetValue().RoomData->RoomName.ToString() + FString::FromInt(CurrentIdx));
+		                                                                 LevelGenerator->MakeRoomLevelName(CurrentMove->GetValue().RoomData, CurrentIdx),
+		                                                                 CurrentMove->GetValue().SourceMoveIdx);
 
 		// Spawn the door
-		CurrentMove->GetValue().SpawnedDoor = LevelGenerator->SpawnDoor(ReberuData, CurrentMove->GetValue().TargetRoomBounds, CurrentMove->GetValue().TargetRoomDoor);
+		const FReberuRoom& BoundsRoom = CurrentMove->GetValue().TargetRoomBounds->Room;
+		const FTransform BoundsTransform = CurrentMove->GetValue().TargetRoomBounds->GetActorTransform();
+		if(BoundsRoom.ReberuDoors.IsValidIndex(CurrentMove->GetValue().TargetDoorIdx)){
+			CurrentMove->GetValue().SpawnedDoor = LevelGenerator->SpawnDoor(ReberuData, BoundsRoom.ReberuDoors[CurrentMove->GetValue().TargetDoorIdx], BoundsTransform, false);
+		}
 
 		// Spawn any blocked doors
-		const TSet<FString> RoomUsedDoors = CurrentMove->GetValue().TargetRoomBounds->Room.UsedDoors;
-		for (auto Door : CurrentMove->GetValue().TargetRoomBounds->Room.ReberuDoors){
-			if(!RoomUsedDoors.Contains(Door.DoorId)){
-				CurrentMove->GetValue().SpawnedBlockedDoors.Add(LevelGenerator->SpawnDoor(ReberuData, CurrentMove->GetValue().TargetRoomBounds, Door.DoorId, true));
+		TArray<int32> BlockedDoorIdxs;
+		for (int32 DoorIdx = 0; DoorIdx < BoundsRoom.ReberuDoors.Num(); DoorIdx++){
+			if(!CurrentMove->GetValue().IsDoorUsed(DoorIdx)){
+				BlockedDoorIdxs.Add(DoorIdx);
+				if(AActor* BlockedDoor = LevelGenerator->SpawnDoor(ReberuData, BoundsRoom.ReberuDoors[DoorIdx], BoundsTransform, true)){
+					CurrentMove->GetValue().SpawnedBlockedDoors.Add(BlockedDoor);
+				}
 			}
 		}
 
-		// Delete the room bounds associated with this new level.
+		// Spawn the doors of the loops this room closes, the earlier room of each loop doesn't spawn one
+		const TArray<int32>& LoopDoorIdxs = CurrentMove->GetValue().LoopDoorIdxs;
+		for (const int32 LoopDoorIdx : LoopDoorIdxs){
+			if(AActor* SpawnedLoopDoor = LevelGenerator->SpawnDoor(ReberuData, BoundsRoom.ReberuDoors[LoopDoorIdx], BoundsTransform, false)){
+				CurrentMove->GetValue().SpawnedLoopDoors.Add(SpawnedLoopDoor);
+			}
+		}
+
+		// Let clients know which doors to create instances for
+		LevelGenerator->SetRoomDoors(CurrentIdx, CurrentMove->GetValue().TargetDoorIdx, BlockedDoorIdxs, LoopDoorIdxs, CurrentMove->GetValue().LoopMoveIdxs);
+
+		// Delete the room bounds associated with this new level. Moves don't keep it alive, so nothing can point to it afterwards.
 		CurrentMove->GetValue().TargetRoomBounds->Destroy();
+		CurrentMove->GetValue().TargetRoomBounds = nullptr;
 
 		if(CurrentMove->GetNextNode()){
 			CurrentIdx++;
@@ -68,9 +100,22 @@ void FFinalizeRoomsTask::UpdateOperation(FLatentResponse& Response){
 	// Do OnCompleted here!
 	if(bIsCompleted){
 		REBERU_LOG_ARGS(Log, "Reberu Level Placement complete! Created %d levels!", MovesList.Num())
+		// The source bounds of every move were destroyed along with the target bounds of its source move
+		for (FReberuMove& Move : MovesList){
+			Move.SourceRoomBounds = nullptr;
+		}
 		Output = EFinalizeRoomsOutputPins::OnCompleted;
-		LevelGenerator->PostProcessing(ReberuData);
+		// Any pooled levels left at this point weren't needed by this layout
+		LevelGenerator->FlushRoomLevelPool();
+		LevelGenerator->OnRoomsFinalized();
+		// Clients only finalize locally in seed replication mode, post processing is left to the server
+		if(LevelGenerator->HasAuthority()){
+			LevelGenerator->PostProcessing(ReberuData);
+		}
 		LevelGenerator->OnGenerationCompleted.Broadcast();
+		if(LevelGenerator->ShouldCompactAfterFinalize()){
+			LevelGenerator->CompactGeneration();
+		}
 		Response.FinishAndTriggerIf(true, LatentActionInfo.ExecutionFunction, LatentActionInfo.Linkage, LatentActionInfo.CallbackTarget);
 	}
 }
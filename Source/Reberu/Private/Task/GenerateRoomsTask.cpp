@@ -5,6 +5,7 @@
 
 #include "Reberu.h"
 #include "RoomBounds.h"
+#include "Settings/ReberuSettings.h"
 
 void FGenerateRoomsAction::UpdateOperation(FLatentResponse& Response){
 
@@ -36,42 +37,62 @@ void FGenerateRoomsAction::UpdateOperation(FLatentResponse& Response){
 	}
 	
 	if(bIsFirstCall){
+		// Wait for the rooms to be loaded before doing anything else
+		if(!bRequestedLoad){
+			bRequestedLoad = true;
+			LoadHandle = ReberuData->LoadGenerationData();
+		}
+		if(LoadHandle.IsValid() && !LoadHandle->HasLoadCompleted()) return;
+
 		bIsFirstCall = false;
 		bSuccess = true;
 
 		REBERU_LOG_ARGS(Log, "Starting level generation with %s", *ReberuData->GetName())
 
-		/** Check for duplicate door ids just in case. */
-		TMap<FString, UReberuRoomData*> DoorToRoomMap; 
-		for(UReberuRoomData* Room : ReberuData->ReberuRooms){
-			for(const FReberuDoor& Door : Room->Room.ReberuDoors){
-
-				if(Door.DoorTransform.GetScale3D() != FVector::One()){
-					REBERU_LOG_ARGS(Error, "Detected door %s on room %s with scale != 1 in their transform. Will cause door visual to look off.", *Room->RoomName.ToString(), *Door.DoorId)
-				}
-				
-				if(DoorToRoomMap.Contains(Door.DoorId)){
-					const UReberuRoomData* OldRoom = *DoorToRoomMap.Find(Door.DoorId);
-					REBERU_LOG_ARGS(Warning, "Duplicate Door Id detected in %s with id: %s (other in %s). Please regenerate ids to have unique door ids or it may cause unexpected issues.",
-						*Room->RoomName.ToString(), *Door.DoorId, *OldRoom->RoomName.ToString())
-				}
-				else{
-					DoorToRoomMap.Add(Door.DoorId, Room);
-				}
-			}
+		const bool bCanGenerate = ReberuData->PrepareGeneration(LoadHandle.IsValid());
+		LoadHandle.Reset();
+		if(!bCanGenerate){
+			bIsCompleted = true;
+			return;
 		}
+		const FReberuRoomCatalog& Catalog = ReberuData->GetCatalog();
+		LevelGenerator->ResetRuleCache();
+		LevelGenerator->ResetRoomConstraints(ReberuData);
 
-		if(Seed > 0){
+		if(Seed > 0 || bUseExactSeed){
 			ReberuRandomStream = FRandomStream(Seed);
 		}
 		else{
 			ReberuRandomStream.GenerateNewSeed();
 		}
 
-		UReberuRoomData* StartingRoomData = ReberuData->StartingRoom ? ReberuData->StartingRoom : GetRandomObjectInArray<UReberuRoomData*>(ReberuData->ReberuRooms, ReberuRandomStream);
+		// Zoned layouts are too big to place a room per tick, so they are generated in data and then spawned within a frame budget
+		if(ReberuData->Zones.Num() > 0){
+			bGeneratedInData = true;
+			if(!LevelGenerator->BeginRoomsInData(ReberuData, ReberuRandomStream.GetInitialSeed(), StartRoomTransform)){
+				REBERU_LOG_ARGS(Error, "Couldn't start generating the zones of %s.", *ReberuData->GetName())
+				bIsCompleted = true;
+				return;
+			}
+			Output = EGenerateRoomsOutputPins::OnStarted;
+			Response.TriggerLink(LatentActionInfo.ExecutionFunction, LatentActionInfo.Linkage, LatentActionInfo.CallbackTarget);
+			return;
+		}
+
+		UReberuRoomData* StartingRoomData = !ReberuData->StartingRoom.IsNull() ? ReberuData->StartingRoom.Get()
+			: Catalog.Rooms[ReberuRandomStream.RandRange(0, Catalog.NumPlaceableRooms() - 1)];
+		if(!StartingRoomData){
+			REBERU_LOG(Error, "The starting room couldn't be loaded!")
+			bIsCompleted = true;
+			return;
+		}
 	
 		ARoomBounds* StartingBounds = LevelGenerator->SpawnRoomBounds(StartingRoomData, StartRoomTransform);
 		MovesList.AddHead(FReberuMove(StartingRoomData, StartingBounds->GetActorTransform(), StartingBounds, false));
+		MovesList.GetHead()->GetValue().MoveIdx = 0;
+		MovesList.GetHead()->GetValue().CatalogIdx = ReberuData->GetRoomIndex(StartingRoomData);
+		LevelGenerator->TrackMove(MovesList.GetHead()->GetValue(), true);
+		LevelGenerator->BeginPlacedRooms(StartingBounds->GetActorTransform(), StartingRoomData->Room.BoxExtent);
 		SourceRoomNode = MovesList.GetHead();
 		
 		// Trigger on started pin
@@ -80,7 +101,28 @@ void FGenerateRoomsAction::UpdateOperation(FLatentResponse& Response){
 		return;
 	}
 
-	if(MovesList.Num() < ReberuData->TargetRoomAmount && LevelGenerator->IsGenerating()){
+	if(bGeneratedInData && !bIsCompleted){
+		if(!LevelGenerator->IsGenerating()){
+			bWantToCancel = true;
+			return;
+		}
+
+		// Same budget as the generations of the generation subsystem, at least a step per tick
+		const double EndTime = FPlatformTime::Seconds() + GetDefault<UReberuSettings>()->GenerationFrameBudgetMs / 1000.f;
+		bool bHasSteps = true;
+		do{
+			bHasSteps = LevelGenerator->StepRoomsInData();
+		} while(bHasSteps && FPlatformTime::Seconds() < EndTime);
+		if(bHasSteps) return;
+
+		if(!LevelGenerator->EndRoomsInData()){
+			REBERU_LOG_ARGS(Error, "Couldn't generate the zones of %s, placed %d rooms.", *ReberuData->GetName(), MovesList.Num())
+			bIsCompleted = true;
+			return;
+		}
+	}
+
+	if(!bGeneratedInData && MovesList.Num() < ReberuData->TargetRoomAmount && LevelGenerator->IsGenerating()){
 		FReberuMove NewMove;
 
 		// Try placing the next room
@@ -94,11 +136,13 @@ void FGenerateRoomsAction::UpdateOperation(FLatentResponse& Response){
 		// If we created a room successfully, update values accordingly
 		if(bRoomCreated){
 			MaxBacktrackTries = ReberuData->MaxBacktrackTries;
-			NewMove.SourceRoomBounds->Room.UsedDoors.Add(NewMove.SourceRoomDoor);
-			NewMove.TargetRoomBounds->Room.UsedDoors.Add(NewMove.TargetRoomDoor);
+			SourceRoomNode->GetValue().SetDoorUsed(NewMove.SourceDoorIdx);
+			NewMove.SetDoorUsed(NewMove.TargetDoorIdx);
 			// for bfs/dfs i think this should work since we are going in order but it won't for custom methods
 			NewMove.TargetRoomBounds->Room.Depth = NewMove.SourceRoomBounds->Room.Depth + 1; 
+			NewMove.MoveIdx = MovesList.Num();
 			MovesList.AddTail(NewMove);
+			LevelGenerator->TrackMove(NewMove, true);
 			
 			REBERU_LOG(Log, "Added new move to the list!")
 			// Choose the next source room (or keep the current one if applicable)
@@ -136,12 +180,20 @@ void FGenerateRoomsAction::UpdateOperation(FLatentResponse& Response){
 	// Do OnCompleted here!
 	if(bIsCompleted){
 		REBERU_LOG_ARGS(Log, "Reberu Generation complete! Created %d rooms!", MovesList.Num())
+		if(!LevelGenerator->AreRoomConstraintsMet()){
+			REBERU_LOG_ARGS(Error, "Generated layout doesn't meet the room constraints of %s!", *ReberuData->GetName())
+			Output = EGenerateRoomsOutputPins::OnFailed;
+			Response.FinishAndTriggerIf(true, LatentActionInfo.ExecutionFunction, LatentActionInfo.Linkage, LatentActionInfo.CallbackTarget);
+			return;
+		}
 		const bool PreProcessingResult = LevelGenerator->PreProcessing(ReberuData);
 		if (!PreProcessingResult){
 			Output = EGenerateRoomsOutputPins::OnFailed;
 			Response.FinishAndTriggerIf(true, LatentActionInfo.ExecutionFunction, LatentActionInfo.Linkage, LatentActionInfo.CallbackTarget);
 			return;
 		}
+		LevelGenerator->CloseLoops(ReberuData);
+		LevelGenerator->OnRoomsGenerated(ReberuData, StartRoomTransform);
 		Output = EGenerateRoomsOutputPins::OnCompleted;
 		Response.FinishAndTriggerIf(true, LatentActionInfo.ExecutionFunction, LatentActionInfo.Linkage, LatentActionInfo.CallbackTarget);
 	}
@@ -0,0 +1,50 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LevelGeneratorActor.h"
+#include "ReberuPlayerComponent.generated.h"
+
+/**
+ * Component to add to the player controller so clients have a connection they own to talk to the level generators.
+ * Used to send layout snapshots to clients in snapshot replication mode, or in seed mode when a client's local generation doesn't match the server.
+ */
+UCLASS(ClassGroup=(Reberu), meta=(BlueprintSpawnableComponent))
+class REBERU_API UReberuPlayerComponent : public UActorComponent{
+	GENERATED_BODY()
+
+public:
+	UReberuPlayerComponent();
+
+	/** The amount of snapshot chunks the server sends to this client each tick. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu", meta=(ClampMin=1))
+	int32 ChunksPerTick = 1;
+
+	/** Ask the server for a snapshot of the level generator's layout, starting with the rooms nearest to this player. */
+	UFUNCTION(Server, Reliable)
+	void ServerRequestLayoutSnapshot(ALevelGeneratorActor* LevelGenerator);
+
+	UFUNCTION(Client, Reliable)
+	void ClientReceiveLayoutChunk(ALevelGeneratorActor* LevelGenerator, UReberuData* ReberuData, const FReberuLayoutChunk& Chunk);
+
+	virtual void BeginPlay() override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Finds the component on one of the local player controllers. */
+	static UReberuPlayerComponent* FindLocalPlayerComponent(const UObject* WorldContext);
+
+protected:
+	struct FPendingLayoutChunk{
+		TWeakObjectPtr<ALevelGeneratorActor> LevelGenerator;
+		FReberuLayoutChunk Chunk;
+	};
+
+	/** Chunks waiting to be sent, in the order they should arrive. */
+	TArray<FPendingLayoutChunk> PendingChunks;
+
+	/** Where the rooms of the snapshot should be sorted from: the player's pawn, or their view point while they don't have one yet. */
+	FVector GetSnapshotOrigin() const;
+};
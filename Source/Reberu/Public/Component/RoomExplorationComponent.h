@@ -0,0 +1,65 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "RoomExplorationComponent.generated.h"
+
+class ALevelGeneratorActor;
+class UReberuData;
+
+/**
+ * Component for the LevelGeneratorActor that generates the layout as players explore it (see ALevelGeneratorActor::StartIncrementalGeneration).
+ * Rooms are only placed behind the doors near a player, so only the explored part of the layout exists. With an EvictionDistance, the rooms
+ * far behind the players are evicted too, which keeps memory bounded by the rooms around the players so the layout can go on without an end.
+ * Only runs on the server, clients get the rooms through replication. Pair it with a RoomStreamingComponent to unload the rooms players left behind.
+ */
+UCLASS(ClassGroup=(Reberu), meta=(BlueprintSpawnableComponent))
+class REBERU_API URoomExplorationComponent : public UActorComponent{
+	GENERATED_BODY()
+
+public:
+	URoomExplorationComponent();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration")
+	UReberuData* ReberuData = nullptr;
+
+	/** Seed of the layout. A random seed is used if it is less than 1. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration")
+	int32 Seed = 0;
+
+	/** Start generating on begin play, with the starting room at the level generator. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration")
+	bool bStartOnBeginPlay = true;
+
+	/** Rooms get placed behind the closed doors that are closer than this to a player. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration", meta=(ClampMin=0))
+	float FrontierDistance = 5000.f;
+
+	/**
+	 * Rooms further than this from every player are evicted (see ALevelGeneratorActor::EvictIncrementalRooms), players coming back get new rooms.
+	 * Should be well above FrontierDistance. 0 keeps every room, so memory grows with every room placed.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration", meta=(ClampMin=0))
+	float EvictionDistance = 0.f;
+
+	/** The most rooms placed each update, so the level loading is spread over several updates. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration", meta=(ClampMin=1))
+	int32 MaxRoomsPerUpdate = 2;
+
+	/** How often (in seconds) we look for doors near the players. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Exploration", meta=(ClampMin=0))
+	float UpdateInterval = .25f;
+
+	/** Clears the current layout and starts a new one at the transform. */
+	UFUNCTION(BlueprintCallable, Category="Reberu|Exploration")
+	void StartExploration(FTransform StartTransform);
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	ALevelGeneratorActor* GetLevelGenerator() const;
+};
@@ -0,0 +1,88 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "RoomStreamingComponent.generated.h"
+
+class ALevelGeneratorActor;
+
+/**
+ * Component for the LevelGeneratorActor that keeps only the rooms within a certain amount of door hops of any player loaded and visible.
+ * Works on both the server (using every player) and clients (using their local players).
+ */
+UCLASS(ClassGroup=(Reberu), meta=(BlueprintSpawnableComponent))
+class REBERU_API URoomStreamingComponent : public UActorComponent{
+	GENERATED_BODY()
+
+public:
+	URoomStreamingComponent();
+
+	/** The amount of door hops from a player's room that should stay loaded. 0 only keeps the rooms the players are in. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Streaming", meta=(ClampMin=0))
+	int32 StreamingHops = 2;
+
+	/** How often (in seconds) we check which room each player is in. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Reberu|Streaming", meta=(ClampMin=0))
+	float UpdateInterval = .25f;
+
+	/** Whether streaming is currently active. Disabling it will stream all rooms back in. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Reberu|Streaming")
+	bool bStreamingEnabled = true;
+
+	UFUNCTION(BlueprintCallable, Category="Reberu|Streaming")
+	void SetStreamingEnabled(bool bEnabled);
+
+	/** Forces the streamed rooms to be updated right away instead of waiting for the next interval. */
+	UFUNCTION(BlueprintCallable, Category="Reberu|Streaming")
+	void ForceUpdate();
+
+	/** Whether the room with the layout index (see FRoomLevel::RoomIdx) is currently wanted by the streaming. */
+	UFUNCTION(BlueprintPure, Category="Reberu|Streaming")
+	bool IsRoomStreamedIn(int32 RoomIdx) const;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+
+	ALevelGeneratorActor* GetLevelGenerator() const;
+
+	/** Updates the room bounds if rooms were spawned or removed since the last update. */
+	void UpdateRoomGraph(const ALevelGeneratorActor* LevelGenerator);
+
+	/** Finds the room that contains the location. Checks the hinted room and its neighbours first since players move door by door. */
+	int32 FindRoomAtLocation(const FVector& Location, int32 HintRoomIdx) const;
+
+	bool IsLocationInRoom(const FVector& Location, int32 RoomIdx) const;
+
+	/** Finds the rooms that are currently occupied by players. Returns true if they changed since the last update. */
+	bool UpdateOccupiedRooms();
+
+	/** Load rooms within StreamingHops of the occupied rooms and unload the rest. Hops follow the connections of the generator's room graph. */
+	void UpdateStreamedRooms(ALevelGeneratorActor* LevelGenerator);
+
+	/** Set the streaming state of a single room. */
+	static void SetRoomStreamedIn(ALevelGeneratorActor* LevelGenerator, int32 RoomIdx, bool bStreamedIn);
+
+	/** World transforms of the room bounds for each room. */
+	TArray<FTransform> RoomBoundsTransforms;
+
+	/** Box extents of each room. */
+	TArray<FVector> RoomExtents;
+
+	/** The last room each player was found in. */
+	TMap<TWeakObjectPtr<AController>, int32> PlayerRooms;
+
+	/** Rooms that currently contain a player. */
+	TSet<int32> OccupiedRooms;
+
+	/** Rooms that are currently streamed out. Everything else is considered streamed in. */
+	TSet<int32> StreamedOutRooms;
+
+	/** Version of the generator's room levels the transforms and extents were built from, see ALevelGeneratorActor::GetRoomLevelsVersion. */
+	int32 KnownRoomLevelsVersion = INDEX_NONE;
+
+	bool bNeedsStreamingUpdate = true;
+};
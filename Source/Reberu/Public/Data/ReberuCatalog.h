@@ -0,0 +1,146 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+class UReberuData;
+class UReberuRoomData;
+enum class EReberuDoorMatching : uint8;
+
+enum class EReberuCatalogRoomFlags : uint8 {
+	None = 0,
+	AllowSameRoomConnect = 1 << 0,
+	HasRules = 1 << 1,
+};
+ENUM_CLASS_FLAGS(EReberuCatalogRoomFlags)
+
+enum class EReberuCatalogDoorFlags : uint8 {
+	None = 0,
+	OnlyConnectSameDoor = 1 << 0,
+};
+ENUM_CLASS_FLAGS(EReberuCatalogDoorFlags)
+
+/** Alias table (Vose's method) to draw an index by weight in constant time. */
+struct REBERU_API FReberuAliasTable{
+	/** Negative weights count as 0, an index with a weight of 0 is never drawn. */
+	void Build(TConstArrayView<float> Weights);
+
+	void Reset();
+
+	/** Returns INDEX_NONE if the table is empty or every weight was 0. */
+	int32 Sample(FRandomStream& RandomStream) const;
+
+	int32 Num() const{return Probabilities.Num();}
+
+	float GetTotalWeight() const{return TotalWeight;}
+
+	SIZE_T GetAllocatedSize() const{return Probabilities.GetAllocatedSize() + Aliases.GetAllocatedSize();}
+
+protected:
+	TArray<float> Probabilities;
+	TArray<int32> Aliases;
+	float TotalWeight = 0.f;
+};
+
+/**
+ * Flat struct of arrays version of a UReberuData and its rooms so generation can go over rooms and doors by index
+ * without touching the room data assets. Rooms use the same indices as UReberuData::GetRoomIndex.
+ * The doors of each room are stored next to each other, starting at RoomFirstDoor.
+ */
+struct REBERU_API FReberuRoomCatalog{
+	void Build(const UReberuData* ReberuData);
+
+	void Reset();
+
+	bool IsBuilt() const{return bIsBuilt;}
+
+	/** Whether some rooms weren't loaded when the catalog was built, it has to be rebuilt once they are. */
+	bool HasUnloadedRooms() const{return bHasUnloadedRooms;}
+
+	int32 NumRooms() const{return Rooms.Num();}
+
+	/** The amount of rooms that can be placed during generation. A starting room that isn't in the ReberuRooms comes after these. */
+	int32 NumPlaceableRooms() const{return NumPlaceable;}
+
+	/** Index in the door arrays of a door of a room (by its index in the room's ReberuDoors). */
+	int32 GetDoorIndex(const int32 RoomIdx, const int32 RoomDoorIdx) const{return RoomFirstDoor[RoomIdx] + RoomDoorIdx;}
+
+	/** Index of the tag in Tags, 0 is the empty tag. INDEX_NONE if no door of the catalog uses it. */
+	int32 GetTagIndex(const FGameplayTag& Tag) const;
+
+	/** Whether any rules have to be checked to connect the target room to the source room. */
+	bool HasRules(const int32 SourceRoomIdx, const int32 TargetRoomIdx) const{
+		return bHasDataRules || EnumHasAnyFlags(RoomFlags[SourceRoomIdx] | RoomFlags[TargetRoomIdx], EReberuCatalogRoomFlags::HasRules);
+	}
+
+	int32 NumConstraints() const{return ConstraintMin.Num();}
+
+	/** Whether the room counts towards the room constraint. */
+	bool MatchesConstraint(const int32 ConstraintIdx, const int32 RoomIdx) const{return ConstraintRooms[ConstraintIdx * Rooms.Num() + RoomIdx];}
+
+	int32 NumZones() const{return NumZoneKinds;}
+
+	/** Whether the room can be placed in zones of the kind (index in UReberuData::Zones). */
+	bool IsInZone(const int32 ZoneIdx, const int32 RoomIdx) const{return ZoneRooms[ZoneIdx * Rooms.Num() + RoomIdx];}
+
+	/** Whether placing a room can ever add open doors, meaning it has more than the entry door and the one it takes from its source. */
+	bool CanGainOpenDoors() const{return bCanGainOpenDoors;}
+
+	/** Whether doors with these tag indices can connect when one of them only connects to the same door. */
+	bool AreTagsCompatible(const int32 TagIdxA, const int32 TagIdxB) const{return TagCompatibility[TagIdxA * Tags.Num() + TagIdxB];}
+
+	/** Rooms */
+	TArray<UReberuRoomData*> Rooms;
+	TArray<FVector> RoomExtents;
+	TArray<int32> RoomFirstDoor;
+	TArray<uint16> RoomNumDoors;
+	TArray<EReberuCatalogRoomFlags> RoomFlags;
+	TArray<float> RoomWeights;
+
+	/** Draws a placeable room by weight. */
+	FReberuAliasTable RoomAliasTable;
+
+	/** Doors */
+	TArray<FTransform> DoorTransforms;
+	TArray<FVector> DoorExtents;
+	TArray<uint16> DoorTagIdx;
+	TArray<EReberuCatalogDoorFlags> DoorFlags;
+	TArray<float> DoorWeights;
+
+	/** Every door tag used in the catalog. */
+	TArray<FGameplayTag> Tags;
+
+	/** Tags.Num() x Tags.Num() matrix of which tags match, using the ReberuData's door matching. */
+	TBitArray<> TagCompatibility;
+
+	/** Room constraints, MAX_int32 if there is no maximum. */
+	TArray<int32> ConstraintMin;
+	TArray<int32> ConstraintMax;
+
+	/** NumConstraints() x NumRooms() matrix of which rooms count towards which constraint. */
+	TBitArray<> ConstraintRooms;
+
+	/** NumZones() x NumRooms() matrix of which rooms can be placed in which zone. */
+	TBitArray<> ZoneRooms;
+
+protected:
+	void BuildTagCompatibility(EReberuDoorMatching DoorMatching);
+
+	void BuildConstraints(const UReberuData* ReberuData);
+
+	void BuildZones(const UReberuData* ReberuData);
+
+	int32 NumPlaceable = 0;
+
+	int32 NumZoneKinds = 0;
+
+	bool bHasDataRules = false;
+
+	bool bCanGainOpenDoors = false;
+
+	bool bHasUnloadedRooms = false;
+
+	bool bIsBuilt = false;
+};
@@ -0,0 +1,61 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UReberuData;
+struct FReberuRoomCatalog;
+
+/** How the doors with a tag can connect. */
+struct FReberuTagAnalysis{
+	/** Doors with the tag on rooms that can be placed (or the starting room). */
+	int32 NumDoors = 0;
+
+	/** Doors with the tag that can't connect to any door, they will always be blocked. */
+	int32 NumUnmatchedDoors = 0;
+
+	/** Average amount of doors (on other rooms that can be placed) a door with the tag can connect to. */
+	float BranchingFactor = 0.f;
+};
+
+/**
+ * Static analysis of how the rooms of a catalog can connect through their doors, without generating anything.
+ * Finds rooms that can never be placed, door tags without a partner and catalogs that can't reach the room amounts or constraints.
+ * Only door tags, bOnlyConnectSameDoor, bAllowSameRoomConnect and weights are used. Rules and overlaps can only remove connections,
+ * so anything reported as impossible is impossible, while a low branching factor means generation will likely need to backtrack a lot.
+ */
+struct REBERU_API FReberuCatalogAnalysis{
+	void Analyze(const UReberuData* ReberuData, const FReberuRoomCatalog& Catalog);
+
+	void Reset();
+
+	bool IsAnalyzed() const{return bIsAnalyzed;}
+
+	/** False if the data can never generate a layout that succeeds, see Errors. */
+	bool CanGenerate() const{return Errors.IsEmpty();}
+
+	/** Summary of the rooms and of each door tag, for logging. */
+	FString ToString(const FReberuRoomCatalog& Catalog) const;
+
+	/** Rooms (catalog indices) that can end up in a layout, including the starting room. */
+	TBitArray<> ReachableRooms;
+
+	/** Indexed like the catalog's Tags. */
+	TArray<FReberuTagAnalysis> TagAnalysis;
+
+	/** Average amount of doors each door of the reachable rooms can connect to. */
+	float BranchingFactor = 0.f;
+
+	/** The most rooms a layout can have when placed rooms can't lead to more rooms, INDEX_NONE otherwise. */
+	int32 MaxRooms = INDEX_NONE;
+
+	/** Problems that make every generation fail. Whether rooms are loaded isn't one of them, that can change without the data changing. */
+	TArray<FText> Errors;
+
+	/** Problems that make rooms or doors useless, or that will likely make generation backtrack a lot. */
+	TArray<FText> Warnings;
+
+protected:
+	bool bIsAnalyzed = false;
+};
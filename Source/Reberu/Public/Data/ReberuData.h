@@ -5,9 +5,14 @@
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
 #include "Engine/DataAsset.h"
+#include "Data/ReberuCatalog.h"
+#include "Data/ReberuCatalogAnalysis.h"
 #include "ReberuData.generated.h"
 
 class UReberuRoomData;
+class UReberuRule;
+struct FStreamableHandle;
+class UStaticMesh;
 
 UENUM(BlueprintType)
 enum class ERoomSelection : uint8 {
@@ -20,6 +25,15 @@ enum class ERoomSelection : uint8 {
 	Custom4,
 };
 
+/** How door tags are compared for doors that only connect to the same door. */
+UENUM(BlueprintType)
+enum class EReberuDoorMatching : uint8 {
+	/** Doors only connect when their tags are the same. */
+	Exact,
+	/** Doors also connect when one tag is a parent of the other, e.g. Door.Large connects to Door.Large.Stone. */
+	Hierarchical,
+};
+
 UENUM(BlueprintType)
 enum class ERoomBacktrack : uint8 {
 	FromTail,
@@ -35,13 +49,78 @@ USTRUCT(Blueprintable, BlueprintType)
 struct FReberuDoorInfo{
 	GENERATED_BODY()
 
+	/** Door classes and meshes are only loaded for the door tags used by the generated layout. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(AssetBundles="Doors"))
+	TSoftClassPtr<AActor> DoorActor;
+
 	/** */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(AssetBundles="Doors"))
+	TSoftClassPtr<AActor> BlockedDoorActor;
+
+	/** Render doors with this tag as instances of DoorMesh on the level generator instead of spawning a DoorActor for each. Use for doors without gameplay logic. */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
-	TSubclassOf<AActor> DoorActor;
+	bool bInstanceDoors = false;
 
-	/** */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(EditCondition="bInstanceDoors", AssetBundles="Doors"))
+	TSoftObjectPtr<UStaticMesh> DoorMesh;
+
+	/** Render blocked doors with this tag as instances of BlockedDoorMesh on the level generator instead of spawning a BlockedDoorActor for each. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	bool bInstanceBlockedDoors = false;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(EditCondition="bInstanceBlockedDoors", AssetBundles="Doors"))
+	TSoftObjectPtr<UStaticMesh> BlockedDoorMesh;
+
+	/** Offset applied to the instanced meshes relative to the door (the door transform is at the bottom center of the door). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(EditCondition="bInstanceDoors || bInstanceBlockedDoors"))
+	FTransform MeshOffset;
+
+	bool ShouldInstance(const bool bIsBlocked) const{
+		return bIsBlocked ? bInstanceBlockedDoors && !BlockedDoorMesh.IsNull() : bInstanceDoors && !DoorMesh.IsNull();
+	}
+};
+
+/** Limits how many rooms matching a tag (or a specific room) can end up in the layout, e.g. exactly 1 exit or at most 3 shops. */
+USTRUCT(BlueprintType)
+struct FReberuRoomConstraint{
+	GENERATED_BODY()
+
+	/** Rooms with this tag in their RoomTags count towards the constraint. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag RoomTag;
+
+	/** This room also counts towards the constraint. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TSoftObjectPtr<UReberuRoomData> Room;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(ClampMin=0))
+	int32 MinCount = 0;
+
+	/** Negative for no maximum. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	int32 MaxCount = -1;
+};
+
+/** A zone of a zoned layout, see UReberuData::Zones. */
+USTRUCT(BlueprintType)
+struct FReberuZone{
+	GENERATED_BODY()
+
+	/** Rooms with this tag in their RoomTags are placed in the zone. Every room is used if it is empty. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	FGameplayTag RoomTag;
+
+	/** The amount of rooms each zone of this kind is filled with. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(ClampMin=1))
+	int32 RoomAmount = 50;
+
+	/** Half size of the box reserved for each zone of this kind. Rooms of the zone are only placed inside it. */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere)
-	TSubclassOf<AActor> BlockedDoorActor;
+	FVector RegionExtent = FVector(10000.f, 10000.f, 2000.f);
+
+	/** How many zones of this kind are laid out. */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta=(ClampMin=0))
+	int32 Count = 1;
 };
 
 /**
@@ -53,18 +132,22 @@ class REBERU_API UReberuData : public UPrimaryDataAsset
 	GENERATED_BODY()
 
 public:
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
-	UReberuRoomData* StartingRoom;
+	/** Rooms of a layout and of the catalog are replicated as int16 indices (see FRoomLevel), the catalog analysis reports data that goes past it. */
+	static constexpr int32 MaxLayoutRooms = MAX_int16;
+
+	/** Rooms are soft references so loading the data doesn't load every room. They get loaded when a generation starts. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(AssetBundles="Generation"))
+	TSoftObjectPtr<UReberuRoomData> StartingRoom;
 	
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
-	TArray<UReberuRoomData*> ReberuRooms;
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(AssetBundles="Generation"))
+	TArray<TSoftObjectPtr<UReberuRoomData>> ReberuRooms;
 
-	/** The target amount of rooms that should exist in the generated level. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	/** The target amount of rooms that should exist in the generated level. At most MaxLayoutRooms. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(ClampMax=32767))
 	int32 TargetRoomAmount = 10;
 
 	/** The minimum amount of rooms required to finish generation. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(ClampMax=32767))
 	int32 MinRoomAmount = 5;
 
 	/** The maximum amount of times we can backtrack (in a row) before failing generation. */
@@ -79,7 +162,105 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 	ERoomBacktrack BacktrackMethod = ERoomBacktrack::FromTail;
 
+	/** Room counts that have to be met for the generation to succeed. The starting room counts too. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	TArray<FReberuRoomConstraint> RoomConstraints;
+
+	/**
+	 * Generate in two stages for very large layouts. The zones are first laid out as boxes next to each other, then each zone is filled
+	 * with rooms of its tag that fit in its box, connected to a room of the zone it is next to. Rooms only search the rooms of their zone
+	 * and only overlap test against the rooms of their zone. The starting room is in the first zone.
+	 * The rooms of every zone still count towards the TargetRoomAmount, MinRoomAmount and room constraints.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	TArray<FReberuZone> Zones;
+
+	/**
+	 * Once the rooms are generated (right after PreProcessing), connect open doors of different rooms that line up as loops instead of
+	 * blocking them. The doors have to face each other and be able to connect the same way as during generation, rules included.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	bool bCloseLoops = false;
+
+	/** How far apart (in units) two open doors can be and still be connected as a loop. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(EditCondition="bCloseLoops", ClampMin=1))
+	float LoopDoorTolerance = 10.f;
+
+	/** Rules checked for every connection. */
+	UPROPERTY(EditDefaultsOnly, Instanced, BlueprintReadOnly)
+	TArray<UReberuRule*> Rules;
+
+	/** How door tags are matched. In hierarchical mode door info is also looked up through the parent tags. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	EReberuDoorMatching DoorMatching = EReberuDoorMatching::Exact;
+
 	/** Map to specify door related info mapped to a tag. Add to Reberu.Door.Empty for non tagged doors */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
 	TMap<FGameplayTag, FReberuDoorInfo> DoorMap;
+
+	/** Index of the room in this data asset, used to replicate rooms without sending the asset. The starting room comes after the ReberuRooms if it isn't one of them. */
+	int32 GetRoomIndex(const UReberuRoomData* Room) const;
+
+	/** Returns the room at the index from GetRoomIndex, or nullptr if the index is invalid. Loads the room if it isn't loaded yet. */
+	UReberuRoomData* GetRoomByIndex(int32 RoomIndex) const;
+
+	/** Door info for a door tag (the empty tag uses Reberu.Door.Empty). In hierarchical matching this falls back to the parent tags. */
+	const FReberuDoorInfo* FindDoorInfo(const FGameplayTag& DoorTag) const;
+
+	/** Starts loading the rooms needed for generation. Returns nullptr if they are already loaded. */
+	TSharedPtr<FStreamableHandle> LoadGenerationData() const;
+
+	/** Starts loading the door classes and meshes of the door tags. Returns nullptr if they are already loaded. */
+	TSharedPtr<FStreamableHandle> LoadDoorData(const TSet<FGameplayTag>& DoorTags) const;
+
+	/** Returns the flattened rooms and doors used during generation, building them if needed. */
+	const FReberuRoomCatalog& GetCatalog() const;
+
+	/** Rebuild the catalog (and its analysis) on next use, for when the rooms were changed. */
+	void InvalidateCatalog() const;
+
+	/** Returns the analysis of how the rooms of the catalog can connect, analyzing them if needed. */
+	const FReberuCatalogAnalysis& GetAnalysis() const;
+
+	/**
+	 * Call once the rooms are loaded, before a generation starts. Rebuilds the catalog if rooms were loaded (or edited) since it was built,
+	 * checks the rooms again if they changed since they were validated and logs the analysis errors.
+	 * Returns false if the rooms can never make a layout, generation should fail right away instead of backtracking until it gives up.
+	 */
+	bool PrepareGeneration(bool bLoadedRooms);
+
+	/** Keeps the rooms of the catalog alive since the catalog isn't a property. */
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	/** Hash of the rooms and their DoorsHash. Only uses the rooms that are loaded. */
+	uint32 ComputeRoomsHash() const;
+
+	/** Whether the rooms passed validation without changing since, so generation doesn't have to check them again. */
+	bool IsValidationUpToDate() const{return ValidatedRoomsHash != 0 && ValidatedRoomsHash == ComputeRoomsHash();}
+
+#if WITH_EDITOR
+	/** Checks the doors of every room for a scale != 1 and for ids that are used more than once in the rooms. Returns whether there were no errors. Loads the rooms. */
+	bool ValidateRooms(TArray<FText>& OutErrors) const;
+
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+
+	/** ValidateRooms and store the result in ValidatedRoomsHash. */
+	bool RefreshValidation(TArray<FText>& OutErrors);
+
+	/** Loads the rooms and logs which rooms can never be placed, which door tags have no partner and how many doors each door tag can connect to. */
+	UFUNCTION(CallInEditor, Category="Reberu")
+	void AnalyzeRooms();
+#endif
+
+protected:
+	/** ComputeRoomsHash at the time the rooms last passed validation without errors, 0 if they didn't. Updated when editing or saving in the editor. */
+	UPROPERTY(VisibleAnywhere, AdvancedDisplay)
+	uint32 ValidatedRoomsHash = 0;
+
+private:
+	mutable FReberuRoomCatalog Catalog;
+
+	mutable FReberuCatalogAnalysis Analysis;
 };
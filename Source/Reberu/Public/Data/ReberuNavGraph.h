@@ -0,0 +1,56 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/ReberuPlacementIndex.h"
+
+class ALevelGeneratorActor;
+struct FReberuRoomGraph;
+
+/**
+ * Walkable graph of a generated layout, made of the baked navigation of every spawned room (see FReberuRoomNavData) moved to the room's transform.
+ * Rooms are stitched together by linking the door nodes of each connection in the room graph.
+ * Rooms without baked navigation are left out.
+ *
+ * This is a standalone path query for gameplay code, not navigation data: the navigation system, AI MoveTo and path following don't know
+ * about it, and the navmesh of the generated area is still built at runtime.
+ */
+struct REBERU_API FReberuNavGraph{
+	void Build(const ALevelGeneratorActor& LevelGenerator, const FReberuRoomGraph& RoomGraph);
+
+	void Reset();
+
+	int32 NumNodes() const{return NodeLocations.Num();}
+
+	/**
+	 * The closest node to the location, in the rooms that contain it, or the rooms within RoomSearchDistance if none does (like in a doorway).
+	 * INDEX_NONE if the location isn't in or near a room with baked navigation.
+	 */
+	int32 FindClosestNode(const FVector& Location) const;
+
+	/** A* from the node closest to the start to the node closest to the end. The path starts at Start and ends at End. */
+	bool FindPath(const FVector& Start, const FVector& End, TArray<FVector>& OutPath) const;
+
+	/** Memory used by the graph. */
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	TArray<FVector> NodeLocations;
+
+	/** Nodes of each room (by layout index), starting at RoomFirstNode. The last entry is the amount of nodes. */
+	TArray<int32> RoomFirstNode;
+
+	/** Boxes of the rooms with nodes, to find the rooms a location is in without going through every room. */
+	FReberuPlacementIndex RoomIndex;
+
+	/** The room (by layout index) of each box of RoomIndex. */
+	TArray<int32> BoxRooms;
+
+	/** How far from a room a location can be for its nodes to be used. */
+	static constexpr float RoomSearchDistance = 200.f;
+
+	/** Linked nodes of each node, starting at NodeFirstLink. The last entry is the amount of links. */
+	TArray<int32> NodeFirstLink;
+	TArray<int32> LinkNodes;
+};
@@ -0,0 +1,74 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Spatial hash of placed room boxes, so placing rooms in pure data only tests the boxes in the cells a new room touches
+ * instead of spawning RoomBounds and running physics overlaps.
+ */
+struct REBERU_API FReberuPlacementIndex{
+	/** Clears the index and its region. The cell size should be around the size of a room. */
+	void Reset(float InCellSize = 2000.f);
+
+	/** Boxes that aren't fully inside the region count as overlapping, to keep the rooms of a zone in its box. */
+	void SetRegion(const FTransform& InRegionTransform, const FVector& InRegionExtent);
+
+	/** Adds a room box, returns its index. Reuses the index of a box removed with Remove if there is one. */
+	int32 Add(const FTransform& BoundsTransform, const FVector& Extent);
+
+	/** Removes the box that was added last, for backtracking. Only for indices that boxes aren't removed from with Remove. */
+	void RemoveLast();
+
+	/**
+	 * Removes any box, for indices shared by several generators that backtrack and clear on their own, or rooms evicted by incremental generation.
+	 * The other boxes keep their index.
+	 */
+	void Remove(int32 BoxIdx);
+
+	/** Whether the box overlaps any box in the index. Boxes that touch within the tolerance (like rooms connected by a door) don't overlap. */
+	bool Overlaps(const FTransform& BoundsTransform, const FVector& Extent, float Tolerance = 1.f) const;
+
+	/** The boxes that contain the location, or are within Tolerance of it. */
+	void FindBoxesAt(const FVector& Location, TArray<int32>& OutBoxIdxs, float Tolerance = 1.f) const;
+
+	/** The amount of boxes in the index, not counting removed ones. */
+	int32 Num() const{return Boxes.Num() - NumRemoved;}
+
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	struct FPlacedBox{
+		FVector Center;
+		FQuat Rotation;
+		FVector Extent;
+		FIntVector MinCell;
+		FIntVector MaxCell;
+		bool bRemoved = false;
+	};
+
+	FPlacedBox MakeBox(const FTransform& BoundsTransform, const FVector& Extent) const;
+
+	FIntVector GetCell(const FVector& Location) const;
+
+	bool IsInsideRegion(const FPlacedBox& Box, float Tolerance) const;
+
+	/** Separating axis test between two oriented boxes. */
+	static bool BoxesOverlap(const FPlacedBox& A, const FPlacedBox& B, float Tolerance);
+
+	TArray<FPlacedBox> Boxes;
+
+	/** Boxes in each cell, in the order they were added. */
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	/** Boxes removed with Remove, they keep their slot so the other indices stay valid. Add reuses their slots. */
+	int32 NumRemoved = 0;
+	TArray<int32> FreeBoxIdxs;
+
+	float CellSize = 2000.f;
+
+	bool bHasRegion = false;
+	FTransform RegionTransform;
+	FVector RegionExtent = FVector::ZeroVector;
+};
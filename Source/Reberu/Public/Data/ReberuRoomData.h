@@ -39,12 +39,42 @@ struct FReberuDoor{
 	/** bool specifying if this door can only connect to doors of the same type. empty tags won't be limited */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bOnlyConnectSameDoor = true;
+
+	/** Relative chance of this door being used once its room is chosen. 0 never uses it. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta=(ClampMin=0))
+	float Weight = 1.f;
 	
 	void GenerateNewDoorId(){
 		DoorId = FGuid::NewGuid().ToString();
 	}
 };
 
+/**
+ * Walkable graph of a room baked from the navmesh of its level (see ARoomBounds::BakeNavigation), relative to the room bounds.
+ * Spawned rooms are stitched together at their doors so gameplay code can query paths through generated layouts (see FReberuNavGraph).
+ * This isn't navmesh data, the navmesh of the generated area is still built by the navigation system.
+ */
+USTRUCT(BlueprintType)
+struct FReberuRoomNavData{
+	GENERATED_BODY()
+
+	/** Centers of the navmesh polygons of the room and the middle of the edges between them, followed by a node at each door. */
+	UPROPERTY(VisibleAnywhere)
+	TArray<FVector3f> NodeLocations;
+
+	/** Pairs of node indices that are connected. */
+	UPROPERTY(VisibleAnywhere)
+	TArray<int32> Links;
+
+	/** The node of each door (by door index), INDEX_NONE if the door isn't on the navmesh. */
+	UPROPERTY(VisibleAnywhere)
+	TArray<int32> DoorNodes;
+
+	bool IsBaked() const{return NodeLocations.Num() > 0;}
+
+	SIZE_T GetAllocatedSize() const{return NodeLocations.GetAllocatedSize() + Links.GetAllocatedSize() + DoorNodes.GetAllocatedSize();}
+};
+
 /**
  * Represents a Room for Reberu level generation. This struct should be created using the editor tools.
  * The final struct will live in a UReberuRoomData data asset but should be generated with a BP_RoomBounds.
@@ -53,8 +83,8 @@ USTRUCT(BlueprintType, Blueprintable)
 struct FReberuRoom{
 	GENERATED_BODY()
 
-	/** The Level to be associated with this room. */
-	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite)
+	/** The Level to be associated with this room. Only streamed in for rooms that end up in the layout. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, meta=(AssetBundles="Level"))
 	TSoftObjectPtr<UWorld> Level = nullptr;
 
 	/** The location in world space of the box in the context of the current room. */
@@ -69,10 +99,6 @@ struct FReberuRoom{
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	TArray<FReberuDoor> ReberuDoors;
 
-	/** Set containing the used doors (key is their id). Used in generation. */
-	UPROPERTY()
-	TSet<FString> UsedDoors;
-
 	/** Tags associated with this room. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FGameplayTagContainer RoomTags;
@@ -81,6 +107,10 @@ struct FReberuRoom{
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bAllowSameRoomConnect = false;
 
+	/** Walkable graph of the room, baked with BakeNavigation on the room bounds. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	FReberuRoomNavData NavData;
+
 	/** Depth of the node from the head */
 	UPROPERTY(BlueprintReadOnly)
 	int32 Depth = 0; 
@@ -100,6 +130,23 @@ struct FReberuRoom{
 		});
 		return CurrentDoorIdx;
 	}
+
+	/** Memory used by the doors and navigation of the room. */
+	SIZE_T GetAllocatedSize() const{
+		SIZE_T Size = ReberuDoors.GetAllocatedSize() + NavData.GetAllocatedSize();
+		for (const FReberuDoor& Door : ReberuDoors){
+			Size += Door.DoorId.GetAllocatedSize();
+		}
+		return Size;
+	}
+
+	/** Offset between the room bounds and the level instance that gets spawned for this room. */
+	FTransform GetLevelOffsetTransform() const{
+		FTransform OffsetTransform = BoxActorTransform;
+		OffsetTransform.SetLocation(-OffsetTransform.GetLocation());
+		OffsetTransform.SetRotation(OffsetTransform.GetRotation().Inverse());
+		return OffsetTransform;
+	}
 	
 };
 
@@ -118,5 +165,34 @@ public:
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="Reberu|Room", meta = (ToolTip = "The doors associated with this room."))
 	FReberuRoom Room;
-	
+
+	/** Relative chance of this room being chosen when it can be placed. 0 never places it (it can still be the starting room). */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category="Reberu|Room", meta=(ClampMin=0))
+	float Weight = 1.f;
+
+	/** Rules checked whenever a room connects to this one. */
+	UPROPERTY(EditDefaultsOnly, Instanced, BlueprintReadOnly, Category="Reberu|Room")
+	TArray<UReberuRule*> Rules;
+
+	/** Hash of the door ids and scales, kept up to date in the editor. UReberuData uses it to know if its validation still matches the rooms. */
+	UPROPERTY(VisibleAnywhere, AdvancedDisplay, Category="Reberu|Room")
+	uint32 DoorsHash = 0;
+
+	uint32 ComputeDoorsHash() const;
+
+	/** Doors are replicated as uint8 indices (see FRoomLevel), rooms with more doors fail validation and can't be generated. */
+	static constexpr int32 MaxDoors = MAX_uint8;
+
+#if WITH_EDITOR
+	/** Validation errors for the doors, shared with UReberuData so both report the same issue the same way. */
+	static FText MakeDoorScaleError(FName InRoomName, const FString& DoorId);
+	static FText MakeDuplicateDoorIdError(FName InRoomName, const FString& DoorId, FName OtherRoomName);
+
+	/** Validates the doors of this room on their own, duplicate ids across rooms are checked by UReberuData. */
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+
+	virtual void PostLoad() override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#endif
 };
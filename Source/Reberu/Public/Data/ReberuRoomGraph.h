@@ -0,0 +1,114 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ALevelGeneratorActor;
+struct FReberuRoom;
+struct FRoomLevel;
+
+/** A door connection from a room of the graph to another room. */
+struct FReberuRoomConnection{
+	/** Layout index of the connected room. */
+	int32 RoomIdx = INDEX_NONE;
+
+	/** The door of the room (index in its doors) and of the connected room, INDEX_NONE if it isn't known. */
+	int32 DoorIdx = INDEX_NONE;
+	int32 OtherDoorIdx = INDEX_NONE;
+
+	/** Whether the connection was made by closing a loop, instead of by placing one of the rooms. */
+	bool bIsLoop = false;
+};
+
+/**
+ * Adjacency graph of the spawned rooms of a level generator, by layout index (see FRoomLevel::RoomIdx), with their door connections and world bounds.
+ * Hop distances are precomputed so gameplay can ask how far apart rooms are without pathfinding through the whole layout.
+ * Layouts up to MaxTableRooms get a table of every distance. Larger ones use the room tree (every room's parent) to get the distance
+ * through the closest common ancestor, plus the distances from the rooms of each loop, which is exact as long as there are at most MaxLandmarks of them.
+ * Rooms that hang from a single parent, like the rooms of an incremental generation, are added in place by UpdateRoom.
+ */
+struct REBERU_API FReberuRoomGraph{
+	/** Builds the graph from the spawned rooms of the level generator. Works on clients too, with the rooms that have been replicated so far. */
+	void Build(const ALevelGeneratorActor& LevelGenerator);
+
+	void Reset();
+
+	/**
+	 * Updates the graph in place for a room that was spawned or whose doors changed, instead of building it again. Only handles rooms
+	 * connected to their parent and nothing else yet, without loops. Returns false if the graph has to be built again instead.
+	 */
+	bool UpdateRoom(const ALevelGeneratorActor& LevelGenerator, int32 RoomIdx);
+
+	/** One more than the highest layout index, rooms that aren't spawned (yet) have no connections. */
+	int32 NumRooms() const{return RoomBounds.Num();}
+
+	bool IsValidRoom(const int32 RoomIdx) const{return bHasRoom.IsValidIndex(RoomIdx) && bHasRoom[RoomIdx];}
+
+	/** World space bounding box of the room bounds. */
+	FBox GetRoomBounds(const int32 RoomIdx) const{return RoomBounds.IsValidIndex(RoomIdx) ? RoomBounds[RoomIdx] : FBox(ForceInit);}
+
+	TConstArrayView<FReberuRoomConnection> GetConnections(int32 RoomIdx) const;
+
+	/** Smallest amount of doors to go through to get from one room to the other. INDEX_NONE if they aren't connected. */
+	int32 GetHopDistance(int32 FromRoomIdx, int32 ToRoomIdx) const;
+
+	/** Whether GetHopDistance is exact, it is an upper bound for large layouts with more than MaxLandmarks loop rooms. */
+	bool AreDistancesExact() const{return bDistancesExact;}
+
+	/** The rooms on a shortest path between the rooms, both included. Returns false if they aren't connected. */
+	bool GetRoomsBetween(int32 FromRoomIdx, int32 ToRoomIdx, TArray<int32>& OutRooms) const;
+
+	/** Memory used by the graph and its distances. */
+	SIZE_T GetAllocatedSize() const;
+
+	/** Above this amount of rooms the distances aren't stored as a table anymore. */
+	static constexpr int32 MaxTableRooms = 512;
+
+	/** Rooms with a loop connection that distances are stored from in large layouts. */
+	static constexpr int32 MaxLandmarks = 32;
+
+protected:
+	/** Breadth first search over every connection, storing the hops from the room in OutDistances. */
+	void ComputeDistancesFrom(int32 RoomIdx, uint16* OutDistances) const;
+
+	/** Hops between the rooms through the room tree, MAX_uint16 if they are in different trees. */
+	uint16 GetTreeDistance(int32 FromRoomIdx, int32 ToRoomIdx) const;
+
+	/** The 2^Level ancestor of the room, INDEX_NONE past the root of its tree. */
+	int32 GetAncestor(const int32 RoomIdx, const int32 Level) const{return Ancestors[RoomIdx * NumAncestorLevels + Level];}
+
+	/** Adds a connection after the other connections of the room. */
+	void InsertConnection(int32 RoomIdx, const FReberuRoomConnection& Connection);
+
+	static FTransform GetBoundsTransform(const FRoomLevel& RoomLevel);
+
+	static FVector GetDoorLocation(const FReberuRoom& Room, const FTransform& BoundsTransform, int32 DoorIdx);
+
+	/** Rooms only know their own door of a connection, the other room's door is the one at the same spot. */
+	static int32 FindDoorAt(const FReberuRoom& Room, const FTransform& BoundsTransform, const FVector& Location);
+
+	TBitArray<> bHasRoom;
+	TArray<FBox> RoomBounds;
+
+	/** Connections of each room, starting at RoomFirstConnection. The last entry is the amount of connections. */
+	TArray<int32> RoomFirstConnection;
+	TArray<FReberuRoomConnection> Connections;
+
+	/** NumRooms() x NumRooms() hops between every room, MAX_uint16 if they aren't connected. Only for layouts up to MaxTableRooms. */
+	TArray<uint16> HopTable;
+
+	/** Room tree for larger layouts, Ancestors holds the 2^Level ancestor of each level for every room (see GetAncestor). */
+	TArray<int32> RoomDepths;
+	TArray<int32> Ancestors;
+	int32 NumAncestorLevels = 0;
+
+	/** Rooms of the loops and the NumRooms() x Landmarks.Num() hops to each of them. */
+	TArray<int32> Landmarks;
+	TArray<uint16> LandmarkDistances;
+
+	bool bDistancesExact = true;
+
+	/** Whether some rooms have a parent or loop that isn't in the graph (yet), adding it has to add their connections too. */
+	bool bHasMissingRooms = false;
+};
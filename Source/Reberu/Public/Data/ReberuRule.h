@@ -10,14 +10,27 @@ class UReberuRoomData;
 /**
  * Abstract Base class for rules to be used in transitions.
  * Should be used to contain logic on whether or not a room can be placed.
- * Override 
+ * Add rules to a ReberuData (checked for every connection) or a ReberuRoomData (checked for connections with that room).
+ * Override ShouldPlaceRoom in Blueprint or C++, C++ rules skip the Blueprint VM entirely.
  */
-UCLASS(Abstract, Blueprintable)
+UCLASS(Abstract, Blueprintable, EditInlineNew, DefaultToInstanced)
 class REBERU_API UReberuRule : public UObject{
 	GENERATED_BODY()
 
 public:
+	/** Whether the result only depends on the two rooms. Pure rules are evaluated once per room pair for each generation. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu")
+	bool bIsPure = false;
 
-	UFUNCTION(BlueprintImplementableEvent)
+	/** OwningRoom is the room the rule was added to (or the source room for ReberuData rules). */
+	UFUNCTION(BlueprintNativeEvent)
 	bool ShouldPlaceRoom(UReberuRoomData* OwningRoom, UReberuRoomData* ConnectingRoom);
+
+	/** Calls ShouldPlaceRoom, going straight to the native implementation when it isn't overridden in Blueprint. */
+	bool EvaluateRule(UReberuRoomData* OwningRoom, UReberuRoomData* ConnectingRoom);
+
+	virtual void PostInitProperties() override;
+
+protected:
+	bool bHasScriptImplementation = false;
 };
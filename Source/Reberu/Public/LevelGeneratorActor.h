@@ -7,36 +7,56 @@
 #include "Data/ReberuRoomData.h"
 #include "GameFramework/Actor.h"
 #include "LatentActions.h"
+#include "Engine/StreamableManager.h"
 #include "Components/BillboardComponent.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "Data/ReberuPlacementIndex.h"
+#include "Data/ReberuNavGraph.h"
+#include "Data/ReberuRoomGraph.h"
 #include "LevelGeneratorActor.generated.h"
 
 class ARoomBounds;
+class UHierarchicalInstancedStaticMeshComponent;
+class ULineBatchComponent;
 struct FReberuDoor;
 class ULevelStreamingDynamic;
 class UReberuRoomData;
 class UReberuData;
 
+enum class EGenerateRoomsOutputPins : uint8;
+enum class EFinalizeRoomsOutputPins : uint8;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnGenerationCompleteSignature);
 
-/** Simplified version of a move that we will use when generating */
+/** How the generated layout gets to clients. */
+UENUM(BlueprintType)
+enum class EReberuReplicationMode : uint8 {
+	/** Replicate every spawned room. */
+	Full,
+	/** Only replicate the seed and let clients generate the same layout locally. Falls back to a snapshot for clients whose layout doesn't match. */
+	Seed,
+	/** Clients ask for a compressed snapshot of the layout that is sent in chunks, with the rooms nearest to the player first. */
+	Snapshot,
+};
+
+/** Simplified version of a move that we will use when generating. Rooms are catalog indices and doors are indices in the room's doors. */
 USTRUCT()
 struct FAttemptedMove{
 	GENERATED_BODY()
 
 	FAttemptedMove(){}
 
-	FAttemptedMove(UReberuRoomData* RoomData, const FString& SourceRoomDoor, const FString& TargetRoomDoor)
-		: RoomData(RoomData),
-		  SourceRoomDoor(SourceRoomDoor),
-		  TargetRoomDoor(TargetRoomDoor){
+	FAttemptedMove(const int32 RoomIdx, const int32 SourceDoorIdx, const int32 TargetDoorIdx)
+		: RoomIdx(RoomIdx),
+		  SourceDoorIdx(SourceDoorIdx),
+		  TargetDoorIdx(TargetDoorIdx){
 	}
 
-	UPROPERTY()
-	UReberuRoomData* RoomData {nullptr};
+	int32 RoomIdx {INDEX_NONE};
 
-	FString SourceRoomDoor {FString()};
+	int32 SourceDoorIdx {INDEX_NONE};
 
-	FString TargetRoomDoor {FString()};
+	int32 TargetDoorIdx {INDEX_NONE};
 	
 	FORCEINLINE bool operator==(const FAttemptedMove& Other) const
 	{
@@ -46,14 +66,14 @@ struct FAttemptedMove{
 	// Only compares the to/from doors + the room data
 	FORCEINLINE	bool Equals(const FAttemptedMove& Other) const
 	{
-		return RoomData == Other.RoomData && (SourceRoomDoor.Equals(Other.SourceRoomDoor) && TargetRoomDoor.Equals(TargetRoomDoor));
+		return RoomIdx == Other.RoomIdx && SourceDoorIdx == Other.SourceDoorIdx && TargetDoorIdx == Other.TargetDoorIdx;
 	}
 };
 
-/** Overriding the hash so we can use it properly with the attemptedmoves set. Just hashes together the source and target doors */
+/** Overriding the hash so we can use it properly with the attemptedmoves set. */
 FORCEINLINE uint32 GetTypeHash(const FAttemptedMove& This)
 {
-	return HashCombine(GetTypeHash(This.SourceRoomDoor), GetTypeHash(This.TargetRoomDoor));
+	return HashCombine(GetTypeHash(This.RoomIdx), HashCombine(GetTypeHash(This.SourceDoorIdx), GetTypeHash(This.TargetDoorIdx)));
 }
 
 /** 
@@ -79,33 +99,66 @@ struct FReberuMove{
 	}
 
 	FReberuMove(UReberuRoomData* InRoomData, const FTransform& InTransform, ARoomBounds* InTargetRoomBounds, bool InCanRevertMove, ARoomBounds* InSourceRoomBounds,
-		FString InSourceRoomDoor, FString InTargetRoomDoor)
+		int32 InSourceDoorIdx, int32 InTargetDoorIdx)
 	{
 		RoomData = InRoomData;
 		SpawnedTransform = InTransform;
 		TargetRoomBounds = InTargetRoomBounds;
 		CanRevertMove = InCanRevertMove;
 		SourceRoomBounds = InSourceRoomBounds;
-		SourceRoomDoor = InSourceRoomDoor;
-		TargetRoomDoor = InTargetRoomDoor;
+		SourceDoorIdx = InSourceDoorIdx;
+		TargetDoorIdx = InTargetDoorIdx;
+	}
+
+	/** Whether a door of this move's room (by index in its doors) is connected to another room. */
+	bool IsDoorUsed(const int32 DoorIdx) const{
+		return UsedDoors.IsValidIndex(DoorIdx) && UsedDoors[DoorIdx];
+	}
+
+	void SetDoorUsed(const int32 DoorIdx, const bool bUsed = true){
+		if(DoorIdx < 0 || IsDoorUsed(DoorIdx) == bUsed) return;
+		if(DoorIdx >= UsedDoors.Num()){
+			UsedDoors.Add(false, DoorIdx + 1 - UsedDoors.Num());
+		}
+		UsedDoors[DoorIdx] = bUsed;
+		NumUsedDoors += bUsed ? 1 : -1;
+	}
+
+	/** Frees every door along with its memory, IsDoorUsed and NumUsedDoors agree again right after. */
+	void ClearUsedDoors(){
+		UsedDoors.Empty();
+		NumUsedDoors = 0;
 	}
 
 	/** Reference to the room data associated with this move. */
 	UReberuRoomData* RoomData {nullptr};
 
+	/** Index of the room data in the ReberuData catalog. */
+	int32 CatalogIdx = INDEX_NONE;
+
+	/** The door of the source room and the door of this move's room that connect, by index in their room's doors. */
+	int32 SourceDoorIdx = INDEX_NONE;
+	int32 TargetDoorIdx = INDEX_NONE;
+
+	/** Connected doors of this move's room by door index, see IsDoorUsed. Sized up to the highest used door. */
+	TBitArray<> UsedDoors;
+	int32 NumUsedDoors = 0;
+
 	/** The world transform that the room should be spawned at. */
 	FTransform SpawnedTransform {FTransform()};
 	
 	ARoomBounds* SourceRoomBounds {nullptr};
 
-	FString SourceRoomDoor {FString()};
-
 	ARoomBounds* TargetRoomBounds {nullptr};
 
-	FString TargetRoomDoor {FString()};
-
 	ULevelStreamingDynamic* SpawnedLevel {nullptr};
 
+	/** Index of this move in the moves list. Moves are only ever removed from the tail so this stays stable. */
+	int32 MoveIdx = INDEX_NONE;
+
+	/** Index of the move that owns the source room of this move. INDEX_NONE for the starting room. */
+	int32 SourceMoveIdx = INDEX_NONE;
+
 	/** Attempted moves used during generation and backtracking. */
 	TSet<FAttemptedMove> AttemptedMoves;
 
@@ -117,32 +170,288 @@ struct FReberuMove{
 
 	/** Blocked door actors associated with this move */
 	TArray<AActor*> SpawnedBlockedDoors;
+
+	/** Doors of this room (by index) connected to an earlier room as a loop (see CloseLoops). This room spawns the doors of its loops. */
+	TArray<int32> LoopDoorIdxs;
+
+	/** Index of the move each of the LoopDoorIdxs connects to. */
+	TArray<int32> LoopMoveIdxs;
+
+	/** Door actors of the loops of this move */
+	TArray<AActor*> SpawnedLoopDoors;
+};
+
+/** Where a data layout is while it is being filled, so it can be filled a few rooms at a time. */
+struct FReberuDataFill{
+	/** Rooms before this move aren't part of the fill and are never backtracked. */
+	int32 FirstMoveIdx = 0;
+	int32 TargetAmount = 0;
+	int32 SourceIdx = 0;
+	int32 BacktrackTries = 0;
+	/** Backtracks left before giving up, since backtracking loses the attempted moves of the removed rooms. */
+	int32 TotalBacktracks = 0;
+	int32 NumBacktracks = 0;
+};
+
+/** A zone region of a zoned data layout, see ALevelGeneratorActor::BeginDataZones. */
+struct FReberuDataZone{
+	/** Index in the ReberuData's Zones. */
+	int32 ZoneIdx = INDEX_NONE;
+	/** The zone this one is next to and connects to. */
+	int32 ParentIdx = INDEX_NONE;
+	FTransform RegionTransform;
+	/** The moves of the zone are [FirstMoveIdx, EndMoveIdx). */
+	int32 FirstMoveIdx = 0;
+	int32 EndMoveIdx = 0;
+};
+
+/** Where a zoned data layout is while its zones are being filled, so it can be filled a few rooms at a time. */
+struct FReberuZoneFill{
+	TArray<FReberuDataZone> Zones;
+	/** The zone being filled, INDEX_NONE before the first one. */
+	int32 DataZoneIdx = INDEX_NONE;
+	FReberuDataFill Fill;
+	int32 NumBacktracks = 0;
+};
+
+/** Rooms ChooseNextMove draws from in a zone while some room constraints are at their maximum, see ALevelGeneratorActor::GetRoomPool. */
+struct FReberuRoomPool{
+	/** Catalog indices of the rooms. */
+	TArray<int32> Rooms;
+
+	/** Draws an index in Rooms by weight. */
+	FReberuAliasTable AliasTable;
+};
+
+/** A door of a room placed by incremental generation, closed until a room is placed and loaded behind it. */
+struct FReberuFrontierDoor{
+	/** The move of the room with the door, and the door's index in the room's doors. */
+	int32 MoveIdx = INDEX_NONE;
+	int32 DoorIdx = INDEX_NONE;
+
+	/** World location of the door, to find the doors near players. */
+	FVector Location = FVector::ZeroVector;
+
+	/** The blocked door actor closing the door, or the blocked door instance (by tag and index) for instanced doors. */
+	TWeakObjectPtr<AActor> BlockedDoor;
+	FGameplayTag InstanceTag;
+	int32 InstanceIdx = INDEX_NONE;
+
+	/** The move placed behind the door, INDEX_NONE while nothing is placed behind it yet. */
+	int32 OpeningMoveIdx = INDEX_NONE;
+};
+
+/** A room placed by incremental generation, with what it takes to evict it again (see ALevelGeneratorActor::EvictIncrementalRooms). */
+struct FReberuIncrementalRoom{
+	FReberuMove Move;
+
+	/** The room's box in the generator's placement index, and in the shared one (INDEX_NONE without a shared index). */
+	int32 BoxIdx = INDEX_NONE;
+	int32 SharedBoxIdx = INDEX_NONE;
+
+	/** The door mesh instance of the entry door once it opened, for instanced doors. */
+	int32 DoorInstanceIdx = INDEX_NONE;
+};
+
+/** Level instances that are kept around to be reused by later generations. */
+USTRUCT()
+struct FReberuPooledLevels{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<ULevelStreamingDynamic*> Levels;
+};
+
+/** Bytes a level generator holds for its layout, see ALevelGeneratorActor::GetMemoryReport. */
+USTRUCT(BlueprintType)
+struct FReberuMemoryReport{
+	GENERATED_BODY()
+
+	/** The generated moves, with their attempted moves and door ids. */
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 MovesBytes = 0;
+
+	/** The rooms copied into the spawned room bounds, with their doors and used doors. Always 0 once the rooms are finalized, finalize destroys the bounds. */
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 RoomBoundsBytes = 0;
+
+	/** The spawned (and replicated) rooms. */
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 RoomLevelsBytes = 0;
+
+	/** Placement index, rule cache, room constraints and the state of scheduled and incremental generations. */
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 SearchBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 RoomGraphBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 NavGraphBytes = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	int64 TotalBytes = 0;
+
+	/** Bytes of the move, room bounds and room level of each room, by layout index. */
+	UPROPERTY(BlueprintReadOnly, Category="Reberu")
+	TArray<int64> RoomBytes;
+
+	FString ToString() const{
+		return FString::Printf(TEXT("%lld bytes (moves %lld, room bounds %lld, room levels %lld, search %lld, room graph %lld, nav graph %lld) for %d rooms"),
+			TotalBytes, MovesBytes, RoomBoundsBytes, RoomLevelsBytes, SearchBytes, RoomGraphBytes, NavGraphBytes, RoomBytes.Num());
+	}
 };
 
-/** Struct that will be replicated when generation is complete. */
+struct FRoomLevelArray;
+
+/**
+ * A spawned room that gets replicated to clients as part of a fast array so they only process the rooms that changed.
+ * Only the catalog index and a quantized transform are sent, the room data, transform and level name are resolved locally.
+ * Indices are packed into int16 for rooms and uint8 for doors, UReberuData::MaxLayoutRooms and UReberuRoomData::MaxDoors keep layouts within them.
+ */
 USTRUCT()
-struct FRoomLevel{
+struct FRoomLevel : public FFastArraySerializerItem{
 	GENERATED_BODY()
 
-	FRoomLevel(): InRoom(nullptr){
+	FRoomLevel(){
 	}
 
-	FRoomLevel(UReberuRoomData* InRoomData, const FTransform& InTransform, FString InLevelName){
+	FRoomLevel(UReberuRoomData* InRoomData, const int32 InCatalogIdx, const FTransform& InTransform, FString InLevelName, const int32 InRoomIdx, const int32 InParentIndex = INDEX_NONE){
 		InRoom = InRoomData;
+		CatalogIdx = InCatalogIdx;
 		SpawnTransform = InTransform;
+		Location = InTransform.GetLocation();
+		Rotation = InTransform.Rotator();
 		LevelName = InLevelName;
+		RoomIdx = InRoomIdx;
+		ParentIndex = InParentIndex;
 	}
 
+	/** Index of the room data in the ReberuData catalog (see UReberuData::GetRoomByIndex). */
 	UPROPERTY()
-	UReberuRoomData* InRoom;
+	int16 CatalogIdx = INDEX_NONE;
 
+	/** Index of this room in the layout. Clients can receive the rooms in any order so this is what other rooms refer to. */
 	UPROPERTY()
-	FTransform SpawnTransform;
+	int16 RoomIdx = INDEX_NONE;
+
+	/** Index of the room this room is connected to through its door. INDEX_NONE for the starting room. */
+	UPROPERTY()
+	int16 ParentIndex = INDEX_NONE;
+
+	/** Location of the level instance, rounded to a tenth of a unit. */
+	UPROPERTY()
+	FVector_NetQuantize10 Location;
+
+	/** Rotation of the level instance, compressed to shorts. Rooms are always spawned with a scale of 1. */
+	UPROPERTY()
+	FRotator Rotation;
+
+	/** Index of the door (in the room's doors) that connects this room to its parent. INDEX_NONE for the starting room. */
+	UPROPERTY()
+	int16 EntryDoorIdx = INDEX_NONE;
 
+	/** Indices of the doors that weren't used during generation. */
 	UPROPERTY()
+	TArray<uint8> BlockedDoorIdxs;
+
+	/** Indices of the doors that connect this room to an earlier room as a loop. */
+	UPROPERTY()
+	TArray<uint8> LoopDoorIdxs;
+
+	/** Index of the room each of the LoopDoorIdxs connects to. */
+	UPROPERTY()
+	TArray<int16> LoopRoomIdxs;
+
+	/** Resolved from the catalog index. */
+	UPROPERTY(NotReplicated)
+	UReberuRoomData* InRoom = nullptr;
+
+	UPROPERTY(NotReplicated)
+	FTransform SpawnTransform;
+
+	/** Name of the local level instance. Not replicated since the names only have to be unique on each machine. */
+	UPROPERTY(NotReplicated)
 	FString LevelName;
+
+	/** Reads or writes the replicated fields in the compact format used by layout snapshots. */
+	void SerializeSnapshot(FArchive& Ar);
+
+	void PreReplicatedRemove(const FRoomLevelArray& InArraySerializer);
+	void PostReplicatedAdd(const FRoomLevelArray& InArraySerializer);
+	void PostReplicatedChange(const FRoomLevelArray& InArraySerializer);
 };
 
+/** Fast array of the spawned rooms. Callbacks are forwarded to the owning level generator. */
+USTRUCT()
+struct FRoomLevelArray : public FFastArraySerializer{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FRoomLevel> Items;
+
+	UPROPERTY(NotReplicated)
+	ALevelGeneratorActor* LevelGenerator = nullptr;
+
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms){
+		return FFastArraySerializer::FastArrayDeltaSerialize<FRoomLevel, FRoomLevelArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FRoomLevelArray> : public TStructOpsTypeTraitsBase2<FRoomLevelArray>{
+	enum{
+		WithNetDeltaSerializer = true,
+	};
+};
+
+/** Everything a client needs to generate the same layout as the server. */
+USTRUCT()
+struct FReberuSeedLayout{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Seed = 0;
+
+	UPROPERTY()
+	UReberuData* ReberuData = nullptr;
+
+	UPROPERTY()
+	FTransform StartTransform = FTransform::Identity;
+
+	/** Checksum of the server's layout so clients can tell if their generation diverged. */
+	UPROPERTY()
+	uint32 LayoutChecksum = 0;
+};
+
+/** Part of a layout snapshot. Each chunk holds a few compressed rooms so clients can spawn them before the rest arrives. */
+USTRUCT()
+struct FReberuLayoutChunk{
+	GENERATED_BODY()
+
+	/** The snapshot this chunk belongs to, chunks of an outdated snapshot are ignored. */
+	UPROPERTY()
+	int32 SnapshotId = 0;
+
+	UPROPERTY()
+	uint16 ChunkIdx = 0;
+
+	UPROPERTY()
+	uint16 NumChunks = 0;
+
+	UPROPERTY()
+	int32 UncompressedSize = 0;
+
+	/** Small chunks that don't get smaller with compression are sent as is. */
+	UPROPERTY()
+	bool bCompressed = false;
+
+	/** Zlib compressed rooms, see FRoomLevel::SerializeSnapshot. */
+	UPROPERTY()
+	TArray<uint8> Data;
+};
 
 /**
  * Level Generator used for Reberu Level Generation! 
@@ -172,23 +481,135 @@ public:
 	/** Do logic to place next room and retry accordingly. */
 	bool PlaceNextRoom(UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove);
 
+	/**
+	 * Generates a layout in pure data, without spawning RoomBounds or levels. Rooms are chosen the same way as PlaceNextRoom (breadth first, backtracking from the tail)
+	 * and only checked for overlaps against each other through the placement index. The moves get a SpawnedTransform but no bounds.
+	 * Returns whether the layout has at least MinRoomAmount rooms and meets the room constraints. OutNumBacktracks is the amount of rooms that were removed by backtracking.
+	 */
+	bool GenerateDataLayout(UReberuData* ReberuData, int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves, int32* OutNumBacktracks = nullptr);
+
+	/**
+	 * Starts generating the layout in data as part of the running generation, placed a room at a time by StepRoomsInData.
+	 * Used by scheduled generations and by the generate rooms task for zoned layouts, which are too big to place a room per tick.
+	 */
+	bool BeginRoomsInData(UReberuData* ReberuData, int32 Seed, const FTransform& StartTransform);
+
+	/**
+	 * Places (or backtracks) a single room of the layout started by BeginRoomsInData. Once the layout is done each step spawns the RoomBounds
+	 * of a room in the moves list instead. Returns false once every RoomBounds is spawned.
+	 */
+	bool StepRoomsInData();
+
+	/** Ends the layout started by BeginRoomsInData. Returns whether it has enough rooms and meets the room constraints. */
+	bool EndRoomsInData();
+
+	/**
+	 * Starts a generation that never ends: rooms are only placed (and finalized) behind the open doors near the players, see ExpandIncrementalGeneration
+	 * and URoomExplorationComponent. The random stream, placement index and open doors are kept until the generation is cleared, rooms far from
+	 * the players can be evicted with EvictIncrementalRooms.
+	 * Only the server generates, clients get the rooms through full replication.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	bool StartIncrementalGeneration(UReberuData* ReberuData, int32 Seed, FTransform StartTransform);
+
+	/**
+	 * Places rooms behind the open doors within FrontierDistance of any of the locations, nearest doors first and at most MaxNewRooms.
+	 * New rooms are loaded behind their closed door, which opens once the room is visible. Returns the amount of rooms placed.
+	 */
+	int32 ExpandIncrementalGeneration(TConstArrayView<FVector> Locations, float FrontierDistance, int32 MaxNewRooms);
+
+	/**
+	 * Evicts the rooms of the incremental generation that are further than EvictionDistance from every location: their level is unloaded and their
+	 * layout index, placement box and doors are freed for new rooms, so memory stays bounded by the rooms near the players. The doors of the remaining
+	 * rooms that led to them close and go back on the frontier, players coming back get new rooms behind them. Returns the amount of rooms evicted.
+	 */
+	int32 EvictIncrementalRooms(TConstArrayView<FVector> Locations, float EvictionDistance);
+
+	bool IsGeneratingIncrementally() const{return bIsIncremental;}
+
+	/**
+	 * Starts generating a layout in data that is placed a room at a time by StepScheduledGeneration. Used by UReberuGenerationSubsystem,
+	 * which decides how many steps each generator gets per frame. Zoned layouts are stepped the same way, a room of a zone at a time.
+	 */
+	bool BeginScheduledGeneration(UReberuData* ReberuData, int32 Seed, const FTransform& StartTransform);
+
+	/** Places (or backtracks) a single room of the scheduled layout, or spawns the RoomBounds of a single room once it is placed. Returns false once every RoomBounds is spawned. */
+	bool StepScheduledGeneration();
+
+	/** Ends the scheduled layout, its RoomBounds are in the moves list ready to be finalized. Returns whether the layout succeeded. */
+	bool FinishScheduledGeneration();
+
+	bool IsScheduledGenerationRunning() const{return bIsScheduled;}
+
+	int32 GetNumIncrementalRooms() const{return IncrementalRooms.Num();}
+
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+#if WITH_EDITOR
+	/** Regenerates and draws the preview layout. */
+	UFUNCTION(CallInEditor, Category="Reberu|Preview")
+	void RefreshPreview();
+
+	/** Turns on the preview with the data and seed, for tools that want to show a layout. */
+	void SetPreview(UReberuData* InReberuData, int32 InSeed);
+
+	virtual void BeginDestroy() override;
+#endif
+
+	/** Keeps the door classes and meshes of the current layout loaded until the generation is cleared. */
+	TSharedPtr<FStreamableHandle> DoorLoadHandle;
+
+	/** Forget the cached results of pure rules. Called when a generation starts since the catalog might have changed. */
+	void ResetRuleCache();
+
+	/** Start counting rooms for the room constraints of the ReberuData. Called when a generation starts. */
+	void ResetRoomConstraints(UReberuData* ReberuData);
+
+	/** Update the room constraint counts and open doors for a move that was added to or removed from the moves list. */
+	void TrackMove(const FReberuMove& Move, bool bAdded);
+
+	/**
+	 * Starts tracking the rooms placed by the generate rooms task in the placement indices, beginning with the starting room, so other generators
+	 * in the world (scheduled ones included) don't place rooms on top of them. With bSnapshotWorldObstacles the task skips the physics overlaps too,
+	 * unless there is no shared placement index (see FindSharedPlacementIndex), then it still overlaps the RoomBounds of the other generators.
+	 */
+	void BeginPlacedRooms(const FTransform& StartTransform, const FVector& StartExtent);
+
+	/** Takes a snapshot of the static world obstacles (see bSnapshotWorldObstacles), replacing the previous one. Call it again if the obstacles change. */
+	UFUNCTION(BlueprintCallable, CallInEditor, Category="Reberu")
+	void SnapshotWorldObstacles();
+
+	/** Whether every room constraint of the ReberuData is met by the current moves. */
+	bool AreRoomConstraintsMet() const;
+
 	/** Choose the next source room if possible (or keep the current one). Only returns false on failure. Uses the inputted selection type. */
 	virtual bool ChooseSourceRoom(TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode*& SourceRoomNode, ERoomSelection SelectionType, bool bFromError=false);
 
 	/** Backtrack by moving back on the moveslist. Method type can be specified and overridden. We assume we have at least 2 rooms so we can actually backtrack. */
 	virtual bool BacktrackSourceRoom(TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode*& SourceRoomNode, ERoomBacktrack BacktrackMethod);
 
-	/** Choose the target room possibilities to connect to the source room. Meant to be easily overridable. */
-	virtual void ChooseTargetRoom(TArray<UReberuRoomData*>& TargetRoomChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove);
+	/**
+	 * Choose the target room possibilities (indices in the ReberuData catalog) to connect to the source room. Meant to be easily overridable.
+	 * Starts with the rooms of the current pool (see GetRoomPool), the room constraints and rules are checked on the room that gets drawn.
+	 * Overrides shouldn't call Super: the base version only marks the hook as not overridden, so rooms are drawn straight from the pool from then on.
+	 */
+	virtual void ChooseTargetRoom(TArray<int32>& TargetRoomChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuMove& NewMove);
 
-	/** Limit the possibilities of the source doors. Starts with all possibilities that are unused already. */
-	virtual void ChooseSourceDoor(TArray<FReberuDoor>& SourceRoomDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove);
+	/** Limit the possibilities of the source doors (indices in the source room's doors). Starts with all possibilities that are unused already. */
+	virtual void ChooseSourceDoor(TArray<int32>& SourceDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove);
 
 	/** Limit the possibilities of the target doors. Is called on each possible source door / target room that is chosen in ChooseSourceDoor / ChooseTargetRoom */
-	virtual void ChooseTargetDoor(TArray<FReberuDoor>& SourceRoomDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove, FReberuDoor& SourceDoor, UReberuRoomData* TargetRoom);
+	virtual void ChooseTargetDoor(TArray<int32>& TargetDoorChoices, UReberuData* ReberuData, FReberuMove& SourceMove, int32 SourceDoorIdx, int32 TargetRoomIdx);
 	
 	/** Overridable function that gets called when the generate rooms task is complete so the user can customize some pre processing */
 	virtual bool PreProcessing(UReberuData* ReberuData);
+
+	/**
+	 * Connects the open doors of different rooms that line up as loops, if the ReberuData closes loops. Called right after PreProcessing.
+	 * The open doors are sorted by the cell of their location so each door only looks at the doors of its neighboring cells.
+	 * Returns the amount of loops that were closed.
+	 */
+	virtual int32 CloseLoops(UReberuData* ReberuData);
 	
 	/** Overridable function that gets called when the finalize task is complete so the user can customize some post processing */
 	virtual void PostProcessing(UReberuData* ReberuData);
@@ -197,19 +618,89 @@ public:
 	void K2_PostProcessing(UReberuData* ReberuData);
 	
 	/** Spawn a room into the world by loading a level instance at the designated loc/rot. */
-	ULevelStreamingDynamic* SpawnRoom(UReberuRoomData* InRoom, const FTransform& SpawnTransform, FString LevelName);
+	ULevelStreamingDynamic* SpawnRoom(UReberuRoomData* InRoom, const FTransform& SpawnTransform, FString LevelName, int32 ParentIndex = INDEX_NONE, int32 RoomIdx = INDEX_NONE);
 
 	/** Despawn a room from the world by unloading its instance */
 	void DespawnRoom(ULevelStreamingDynamic* SpawnedRoom);
 
-	/** Spawns the door based off the target door's tag */
+	/** Despawn a room, or hide it and keep it in the pool to be reused if room level pooling is enabled. */
+	void ReleaseRoom(ULevelStreamingDynamic* SpawnedRoom);
+
+	/** Unload every level instance that is still in the pool. Called once finalize is done with the instances it needed. */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	void FlushRoomLevelPool();
+
+	/** Creates the unique level name for a room in the current generation. */
+	FString MakeRoomLevelName(const UReberuRoomData* InRoom, int32 RoomIdx) const;
+
+	/** Spawns the door based off the target door's tag. Instanced doors are added to the generator's instanced meshes and return nullptr. */
 	AActor* SpawnDoor(UReberuData* ReberuData, ARoomBounds* TargetRoomBounds, FString DoorId, bool bIsOrphaned = false);
 
-	UPROPERTY(ReplicatedUsing=OnRep_SpawnedRoomLevels)
-	TArray<FRoomLevel> SpawnedRoomLevels;
+	/** Spawns the door of a room at the room bounds transform. OutInstanceIdx is set to the index of the instance for instanced doors. */
+	AActor* SpawnDoor(UReberuData* ReberuData, const FReberuDoor& ReberuDoor, const FTransform& RoomBoundsTransform, bool bIsOrphaned, int32* OutInstanceIdx = nullptr);
+
+	/** Records which doors of a spawned room (by layout index) are its entry door, blocked doors and loop doors so clients can recreate them. */
+	void SetRoomDoors(int32 RoomIdx, int32 EntryDoorIdx, const TArray<int32>& BlockedDoorIdxs, const TArray<int32>& LoopDoorIdxs = TArray<int32>(),
+		const TArray<int32>& LoopRoomIdxs = TArray<int32>());
+
+	/** Adds the instanced doors (and only those) of a spawned room (by layout index). Used by clients since the server only replicates door actors. */
+	void SpawnInstancedRoomDoors(int32 RoomIdx);
+
+	/** Removes every door instance from the generator. */
+	void ClearDoorInstances();
+
+	/** Find the door info associated with the door's tag. */
+	static const FReberuDoorInfo* FindDoorInfo(const UReberuData* ReberuData, const FReberuDoor& Door);
+
+	/** Returns the world transform of a door (bottom center of its box) in a room at the given room bounds transform. */
+	static FTransform GetDoorWorldTransform(const FReberuDoor& Door, const FTransform& RoomBoundsTransform);
+
+	/** The data asset used for the current generation. Replicated so clients can look up room data and door info. */
+	UPROPERTY(ReplicatedUsing=OnRep_ActiveReberuData, BlueprintReadOnly, Category="Reberu")
+	UReberuData* ActiveReberuData = nullptr;
+
+	UPROPERTY(Replicated)
+	FRoomLevelArray SpawnedRoomLevels;
+
+	/** Only replicated in Seed replication mode, and only set once the server has finalized the layout. */
+	UPROPERTY(ReplicatedUsing=OnRep_SeedLayout)
+	FReberuSeedLayout SeedLayout;
 
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	/** Stores the info needed for seed replication once the rooms are generated. Called by the generate rooms task. */
+	void OnRoomsGenerated(UReberuData* ReberuData, const FTransform& StartRoomTransform);
+
+	/** Starts replicating the seed layout or snapshot id once the rooms are finalized. Called by the finalize rooms task. */
+	void OnRoomsFinalized();
+
+	/** Checksum over the rooms, transforms and doors of the generated moves. Used to verify that clients generated the same layout. */
+	uint32 ComputeLayoutChecksum() const;
+
+	/**
+	 * Drops the state that is only needed while searching for a layout once the rooms are finalized: attempted moves, door ids,
+	 * the placement index and the rule cache. The room bounds (and the doors copied into them) were already destroyed by finalize.
+	 * The spawned rooms, doors and everything replication needs are kept.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	void CompactGeneration();
+
+	/** Bytes held for the current layout, per part and per room. */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	FReberuMemoryReport GetMemoryReport() const;
+
+	bool ShouldCompactAfterFinalize() const{return bCompactAfterFinalize;}
+
+	/** Compresses the spawned rooms into chunks, sorted by distance to the origin so the rooms around the player arrive first. */
+	void BuildLayoutSnapshot(const FVector& Origin, TArray<FReberuLayoutChunk>& OutChunks) const;
+
+	/** Spawns the rooms of a snapshot chunk on clients. */
+	void ApplyLayoutChunk(UReberuData* ReberuData, const FReberuLayoutChunk& Chunk);
+
+	int32 GetLayoutSnapshotId() const{return LayoutSnapshotId;}
+
 	/** Delegates **/
 	UPROPERTY(BlueprintAssignable)
 	FOnGenerationCompleteSignature OnGenerationCompleted;
@@ -231,6 +722,315 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu")
 	TSubclassOf<ARoomBounds> RoomBoundsClass;
 
+	/**
+	 * Picks the next move from the source room without placing it: the source door, a target room drawn by weight and a door pair.
+	 * The chosen move is added to the source move's attempted moves. Doors set in UsedSourceDoors (by door index) aren't chosen. Returns false if there are no moves left.
+	 */
+	bool ChooseNextMove(UReberuData* ReberuData, FReberuMove& SourceMove, const TBitArray<>& UsedSourceDoors, int32 NumPlacedRooms, FReberuMove& NewMove, FAttemptedMove& OutMove);
+
+	/** Fill in the room and doors of the new move from the chosen move. */
+	static void SetMoveTarget(const FReberuRoomCatalog& Catalog, const FAttemptedMove& ChosenMove, FReberuMove& NewMove);
+
+	/** GenerateDataLayout without checking whether a generation is running. */
+	bool BuildDataLayout(UReberuData* ReberuData, int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves, int32* OutNumBacktracks);
+
+	/** Seeds the generation, resets the placement index and places the starting room of a data layout. */
+	bool BeginDataLayout(UReberuData* ReberuData, int32 Seed, const FTransform& StartTransform, TArray<FReberuMove>& OutMoves);
+
+	/**
+	 * Spawns RoomBounds for up to MaxBounds moves of a data layout, after the ones in SpawnedBounds, and moves them to the moves list.
+	 * Returns true once every move is spawned, DataMoves is emptied then.
+	 */
+	bool SpawnDataLayoutBounds(TArray<FReberuMove>& DataMoves, TArray<ARoomBounds*>& SpawnedBounds, int32 MaxBounds = MAX_int32);
+
+	/** Places rooms breadth first from the move at FirstMoveIdx until there are TargetAmount moves, only backtracking the moves it placed. Returns the amount of backtracks. */
+	int32 FillDataLayout(UReberuData* ReberuData, TArray<FReberuMove>& Moves, int32 FirstMoveIdx, int32 TargetAmount);
+
+	static FReberuDataFill MakeDataFill(const UReberuData* ReberuData, int32 FirstMoveIdx, int32 TargetAmount);
+
+	/** Places or backtracks a single room of a data layout. Returns false once the fill is done. */
+	bool StepDataLayout(UReberuData* ReberuData, TArray<FReberuMove>& Moves, FReberuDataFill& Fill);
+
+	/** Lays out the zones of the ReberuData as regions next to each other, then fills them one by one. Returns the amount of backtracks. */
+	int32 FillDataZones(UReberuData* ReberuData, const FTransform& StartTransform, TArray<FReberuMove>& Moves);
+
+	/** Lays out the zone regions of a zoned data layout, so StepDataZones can fill them. */
+	void BeginDataZones(UReberuData* ReberuData, const FTransform& StartTransform, FReberuZoneFill& ZoneFill);
+
+	/** Places or backtracks a single room of a zoned data layout, or starts filling the next zone. Returns false once every zone is done. */
+	bool StepDataZones(UReberuData* ReberuData, TArray<FReberuMove>& Moves, FReberuZoneFill& ZoneFill);
+
+	/** Places the first room of a zone inside its region, connected to one of the parent zone's rooms closest to the region. */
+	bool ConnectDataZone(UReberuData* ReberuData, TArray<FReberuMove>& Moves, int32 FirstParentMoveIdx, int32 EndParentMoveIdx,
+		const FVector& RegionCenter);
+
+	/** Adds a placed move to a data layout. */
+	void AddDataMove(TArray<FReberuMove>& Moves, FReberuMove& NewMove);
+
+	/** Boxes of the rooms placed by GenerateDataLayout. Only has the rooms of the zone being filled in zoned layouts. */
+	FReberuPlacementIndex PlacementIndex;
+
+	/**
+	 * The index of UReberuGenerationSubsystem with the rooms of every generator in the world, set while generating in a game world.
+	 * Rooms are tested against both indices and added to both, so generators don't overlap each other.
+	 */
+	FReberuPlacementIndex* SharedPlacementIndex = nullptr;
+
+	/** Indices of our rooms in the shared index, in the order they were added. */
+	TArray<int32> SharedBoxIdxs;
+
+	FReberuPlacementIndex* FindSharedPlacementIndex() const;
+
+	/** Whether the box overlaps our rooms or the rooms of other generators. */
+	bool OverlapsPlacedRooms(const FTransform& BoundsTransform, const FVector& Extent) const;
+
+	/** Adds a room to our placement index and the shared one. Returns its index in our placement index. */
+	int32 AddPlacedRoom(const FTransform& BoundsTransform, const FVector& Extent);
+
+	void RemoveLastPlacedRoom();
+
+	/** Removes a room wherever it is in the placement indices, for rooms evicted by incremental generation. */
+	void RemovePlacedRoom(int32 BoxIdx, int32 SharedBoxIdx);
+
+	/** Removes our rooms from the shared index. */
+	void ReleaseSharedRooms();
+
+	/**
+	 * Take a snapshot of the static world geometry around the generator once, when the first generation starts, and keep new rooms out of it.
+	 * Every candidate room is then tested against the snapshot and the placed rooms in memory instead of with physics overlaps, which the
+	 * generate rooms task otherwise runs for every candidate. Only actors that are loaded when the snapshot is taken are part of it.
+	 * Other generators' rooms are found through the shared placement index of UReberuGenerationSubsystem, which only exists in game and PIE worlds.
+	 * Elsewhere the generate rooms task still overlaps their RoomBounds, but layouts generated in data don't see them.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Reberu|Obstacles")
+	bool bSnapshotWorldObstacles = false;
+
+	/** Object type of the components that count as obstacles. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Reberu|Obstacles", meta=(EditCondition="bSnapshotWorldObstacles"))
+	TEnumAsByte<ECollisionChannel> ObstacleObjectType = ECC_WorldStatic;
+
+	/** If set, only actors with this tag are obstacles. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Reberu|Obstacles", meta=(EditCondition="bSnapshotWorldObstacles"))
+	FName ObstacleTag = NAME_None;
+
+	/** Obstacles with a larger extent (like landscapes) are left out, their box would cover way more than their collision. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Reberu|Obstacles", meta=(EditCondition="bSnapshotWorldObstacles", ClampMin=1))
+	float MaxObstacleExtent = 20000.f;
+
+	/** Boxes of the world obstacles, kept between generations. */
+	FReberuPlacementIndex WorldObstacleIndex;
+
+	bool bHasWorldObstacles = false;
+
+	/** Layout being generated a room at a time, see BeginScheduledGeneration. The layout itself is the one of BeginRoomsInData. */
+	bool bIsScheduled = false;
+
+	FTransform ScheduledStartTransform = FTransform::Identity;
+
+	/** Layout being generated in data by the generate rooms task or a scheduled generation, see BeginRoomsInData. */
+	UPROPERTY(Transient)
+	UReberuData* InDataReberuData = nullptr;
+
+	TArray<FReberuMove> InDataMoves;
+
+	FReberuDataFill InDataFill;
+
+	FReberuZoneFill InDataZoneFill;
+
+	/** Whether every room of the layout is placed, the RoomBounds are being spawned. */
+	bool bInDataFilled = false;
+
+	/** RoomBounds spawned for the layout so far, by move index. */
+	TArray<ARoomBounds*> InDataBounds;
+
+	/** The kind of zone (index in UReberuData::Zones) being filled, ChooseNextMove only picks rooms of it. INDEX_NONE when not filling zones. */
+	int32 CurrentZoneIdx = INDEX_NONE;
+
+	/** Picks the starting room once the rooms are loaded and places it. Ends the incremental generation if the data can't generate. */
+	bool BeginIncrementalGeneration();
+
+	/** Places a room behind a door of a placed room. Returns the new move's index, or INDEX_NONE if nothing fits behind the door. */
+	int32 PlaceIncrementalRoom(int32 SourceMoveIdx, int32 SourceDoorIdx);
+
+	/** Adds a placed move to the incremental layout, spawns its level and closes its other doors. Returns the move's index. */
+	int32 AddIncrementalMove(FReberuMove& NewMove);
+
+	/** Closes a door of an incremental room with a blocked door, and adds it to the frontier and its cell. */
+	void AddFrontierDoor(int32 MoveIdx, int32 DoorIdx);
+
+	/** Removes a door from the frontier and its cell, its blocked door stays. */
+	void RemoveFrontierDoor(int32 FrontierIdx);
+
+	FIntVector GetFrontierCell(const FVector& Location) const;
+
+	/** Opens the doors whose new room finished loading. */
+	void OpenLoadedDoors();
+
+	/** Removes the blocked door actor or instance closing a frontier door. */
+	void RemoveFrontierBlockedDoor(const FReberuFrontierDoor& FrontierDoor);
+
+	/** Removes the door actor or instance of the entry door of an incremental room, once the room or the room behind the door is evicted. */
+	void RemoveIncrementalEntryDoor(FReberuIncrementalRoom& IncrementalRoom);
+
+	/** Unloads the level of an evicted room and removes its room level, so clients unload it too. */
+	void RemoveRoomLevel(int32 RoomIdx);
+
+	/** Records the entry and blocked doors of an incremental room so clients see the same doors. */
+	void UpdateIncrementalRoomDoors(int32 MoveIdx);
+
+	/** Whether an incremental generation is running, see StartIncrementalGeneration. */
+	bool bIsIncremental = false;
+
+	UPROPERTY(Transient)
+	UReberuData* IncrementalReberuData = nullptr;
+
+	int32 IncrementalSeed = 0;
+
+	FTransform IncrementalStartTransform = FTransform::Identity;
+
+	/** Keeps the rooms loaded for as long as the incremental generation runs. */
+	TSharedPtr<FStreamableHandle> IncrementalLoadHandle;
+
+	/** The rooms placed and not evicted, the move index is also the room's layout index. Evicted rooms free their index for the next rooms. */
+	TSparseArray<FReberuIncrementalRoom> IncrementalRooms;
+
+	/** Numbers the level instances of incremental rooms, their names have to stay unique while layout indices get reused. */
+	int32 NumIncrementalLevels = 0;
+
+	/** Closed doors that nothing was placed behind yet. Doors that nothing fits behind are removed and stay closed. */
+	TSparseArray<FReberuFrontierDoor> FrontierDoors;
+
+	/** Frontier doors by cell of FrontierCellSize, so only the doors in the cells around the players are looked at. */
+	TMap<FIntVector, TArray<int32>> FrontierCells;
+
+	static constexpr float FrontierCellSize = 2000.f;
+
+	/** Doors with a new room behind them that is still loading. */
+	TArray<FReberuFrontierDoor> OpeningDoors;
+
+#if WITH_EDITORONLY_DATA
+	/** Draw a layout generated in pure data (see GenerateDataLayout) while editing. It is redrawn whenever the preview settings, the ReberuData or its rooms change. */
+	UPROPERTY(EditAnywhere, Category="Reberu|Preview")
+	bool bPreviewLayout = false;
+
+	UPROPERTY(EditAnywhere, Category="Reberu|Preview", meta=(EditCondition="bPreviewLayout"))
+	UReberuData* PreviewReberuData = nullptr;
+
+	UPROPERTY(EditAnywhere, Category="Reberu|Preview", meta=(EditCondition="bPreviewLayout"))
+	int32 PreviewSeed = 0;
+
+	UPROPERTY(EditAnywhere, Category="Reberu|Preview", meta=(EditCondition="bPreviewLayout", ClampMin=0))
+	float PreviewLineThickness = 8.f;
+
+	/** Holds the lines of the preview so they can be drawn in one batch and cleared without touching other debug lines. */
+	UPROPERTY()
+	ULineBatchComponent* PreviewLineBatcher = nullptr;
+#endif
+
+#if WITH_EDITOR
+	FDelegateHandle PreviewObjectChangedHandle;
+
+	/** Redraws the preview when the preview data or one of its rooms is edited. */
+	void OnPreviewObjectChanged(UObject* Object, FPropertyChangedEvent& PropertyChangedEvent);
+
+	void DrawPreviewLayout(const TArray<FReberuMove>& PreviewMoves) const;
+#endif
+
+	/** Adds every door pair (with its weight) that can connect the target room to the source move and wasn't attempted yet. */
+	void GatherDoorPairs(UReberuData* ReberuData, const FReberuRoomCatalog& Catalog, FReberuMove& SourceMove, const TArray<int32>& SourceDoorChoices, int32 TargetRoomIdx,
+		TArray<FAttemptedMove>& OutMoves, TArray<float>& OutWeights);
+
+	/** Whether the rules of the ReberuData and both rooms allow the target room (catalog index) to connect to the source room. */
+	bool PassesRules(UReberuData* ReberuData, const FReberuRoomCatalog& Catalog, int32 SourceRoomIdx, int32 TargetRoomIdx);
+
+	/** Evaluates either the pure or the impure rules for a room pair. */
+	static bool EvaluateRules(const UReberuData* ReberuData, UReberuRoomData* SourceRoom, UReberuRoomData* TargetRoom, bool bPureRules);
+
+	/**
+	 * Whether placing the target room (catalog index) keeps every room constraint possible to meet with the rooms and open doors that are left.
+	 * Rooms that would exceed a maximum or leave too little room for an unmet minimum are pruned before they are tried.
+	 */
+	bool CanMeetRoomConstraints(const FReberuRoomCatalog& Catalog, int32 TargetRoomIdx, int32 RemainingRooms) const;
+
+	/** ReberuData the room constraints are counted for. */
+	UPROPERTY(Transient)
+	UReberuData* ConstrainedReberuData = nullptr;
+
+	/** Amount of placed rooms counting towards each room constraint. */
+	TArray<int32> RoomConstraintCounts;
+
+	/** Doors of the placed rooms that aren't connected to anything yet. */
+	int32 OpenDoorCount = 0;
+
+	/**
+	 * The rooms that can be drawn in the current zone, leaving out the rooms of the constraints that are at their maximum.
+	 * Pools are kept by zone and full constraints so ChooseNextMove doesn't go over the catalog or build an alias table for every room it places.
+	 */
+	const FReberuRoomPool& GetRoomPool(const FReberuRoomCatalog& Catalog);
+
+	/** Pools made by GetRoomPool, the key is the zone and a bit per full constraint. Reset with the room constraints. */
+	TMap<uint64, FReberuRoomPool> RoomPools;
+
+	/** Scratch buffers of ChooseNextMove and GatherDoorPairs, kept to not allocate for every room. */
+	TArray<int32> SourceDoorScratch;
+	TArray<int32> TargetRoomScratch;
+
+	/** Set by the base ChooseTargetRoom, so the pool isn't copied into the target room choices for a hook that doesn't change them. */
+	bool bIsDefaultChooseTargetRoom = false;
+	TArray<int32> TargetDoorScratch;
+	TArray<FAttemptedMove> PossibleMovesScratch;
+	TArray<float> PossibleMoveWeightsScratch;
+	TBitArray<> RejectedRoomScratch;
+	TArray<int32> RejectedRoomIdxs;
+	FReberuAliasTable LocalAliasTable;
+	TArray<int32> LocalAliasRooms;
+	TArray<float> LocalAliasWeights;
+	TArray<int32> RemainingAliasRooms;
+
+	/** Results of the pure rules per (source room, target room) catalog index pair, only valid where PureRulesEvaluated is set. */
+	TBitArray<> PureRuleResults;
+	TBitArray<> PureRulesEvaluated;
+
+	/**
+	 * How the layout is replicated. In Seed mode clients need a ReberuPlayerComponent on their player controller so they can
+	 * ask for the full layout if their generation doesn't match.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu")
+	EReberuReplicationMode ReplicationMode = EReberuReplicationMode::Full;
+
+	/**
+	 * Keep the level instances of cleared generations loaded (but hidden) so a new generation can move and reuse them instead of loading the room again.
+	 * Instances that weren't reused are unloaded once finalize completes.
+	 */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu")
+	bool bPoolRoomLevels = false;
+
+	/** Clients don't know when the server's finalize is done, so they unload their pooled instances after this many seconds without reuse. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu", meta=(EditCondition="bPoolRoomLevels", ClampMin=0))
+	float ClientPoolFlushDelay = 5.f;
+
+	/** Call CompactGeneration once finalize completes, after post processing and OnGenerationCompleted. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu")
+	bool bCompactAfterFinalize = false;
+
+	/** Set once the rooms of the layout are finalized, until the generation is cleared. */
+	bool bRoomsFinalized = false;
+
+	/** The amount of rooms in each chunk of a layout snapshot. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu", meta=(EditCondition="ReplicationMode != EReberuReplicationMode::Full", ClampMin=1))
+	int32 SnapshotRoomsPerChunk = 8;
+
+	/** Seconds between attempts to request a layout snapshot while the local player controller (or its ReberuPlayerComponent) isn't there yet. */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Reberu", meta=(EditCondition="ReplicationMode != EReberuReplicationMode::Full", ClampMin=0.05))
+	float SnapshotRequestRetryDelay = .5f;
+
+	/** Set by the server once the rooms are finalized (0 while there is no layout). Clients in snapshot mode request the layout when it changes. */
+	UPROPERTY(ReplicatedUsing=OnRep_LayoutSnapshotId)
+	int32 LayoutSnapshotId = 0;
+
+	UFUNCTION()
+	void OnRep_LayoutSnapshotId();
+
 	UPROPERTY()
 	bool bIsGenerating = false;
 
@@ -241,21 +1041,187 @@ protected:
 	virtual bool CanStartGeneration() const;
 
 	/** Calculates the transform that the next room should spawn at by using their local transforms and the transforms of the doors */
-	FTransform CalculateTransformFromDoor(ARoomBounds* SourceRoomBounds, FReberuDoor SourceRoomChosenDoor, UReberuRoomData* TargetRoom, FReberuDoor TargetRoomChosenDoor);
+	static FTransform CalculateTransformFromDoor(const FTransform& SourceRoomTransform, const FReberuDoor& SourceRoomChosenDoor, const UReberuRoomData* TargetRoom,
+		const FReberuDoor& TargetRoomChosenDoor);
+
+	/** Spawn any rooms that were waiting for the data asset */
+	UFUNCTION()
+	void OnRep_ActiveReberuData();
+
+	/** Rooms that were replicated before their room data could be resolved. */
+	TArray<int32> PendingRoomLevels;
+
+	/** Resolve the room data and transform of a replicated room from the catalog index. Returns false if the room data can't be resolved yet. */
+	bool ResolveRoomLevel(FRoomLevel& RoomLevel) const;
+
+	/** Resolve and spawn a replicated room. Returns false if the room data can't be resolved yet. */
+	bool SpawnReplicatedRoom(FRoomLevel& RoomLevel);
+
+	/** Whether SpawnRoom should record the rooms in SpawnedRoomLevels. False on clients that receive them through replication. */
+	bool ShouldRecordRoomLevels() const;
+
+	/** The room level of a layout index through RoomLevelItemIdxs, rebuilding it if it doesn't match the items anymore. */
+	FRoomLevel* FindRoomLevel(int32 RoomIdx);
+
+	/**
+	 * Index in SpawnedRoomLevels.Items of each layout index, INDEX_NONE for rooms that aren't there. Kept up to date for the rooms recorded locally,
+	 * replicated rooms are added and removed (swapping the items around) by the fast array, so they only mark it dirty.
+	 */
+	TArray<int32> RoomLevelItemIdxs;
+	bool bRoomLevelItemIdxsDirty = false;
+
+	void SetRoomLevelItemIdx(int32 RoomIdx, int32 ItemIdx);
+	void RebuildRoomLevelItemIdxs();
 
-	/** Update spawned levels on the client too */
+	/** Set when rooms were removed so door instances get rebuilt once the replication update is done. */
+	bool bDoorInstancesDirty = false;
+
+public:
+	/** Fast array callbacks on clients. */
+	void OnRoomLevelAdded(FRoomLevel& RoomLevel);
+	void OnRoomLevelChanged(FRoomLevel& RoomLevel);
+	void OnRoomLevelRemoved(const FRoomLevel& RoomLevel);
+	void OnRoomLevelsReplicated();
+
+	/** Sends the layout snapshot request that is waiting for the local ReberuPlayerComponent, if there is one. Called again on a timer until it succeeds. */
+	void RetryLayoutSnapshotRequest();
+
+protected:
+
+	/** Generate the layout locally on clients using the server's seed */
 	UFUNCTION()
-	void OnRep_SpawnedRoomLevels();
+	void OnRep_SeedLayout();
+
+	/** Seed layout waiting for the rooms to be finalized before it gets replicated. */
+	FReberuSeedLayout PendingSeedLayout;
+
+	/** Ask the server for a layout snapshot through the local player's ReberuPlayerComponent, as soon as the component is there. */
+	void RequestLayoutSnapshot();
+
+	/** Set while a snapshot request waits for the local ReberuPlayerComponent, late joiners can get the snapshot id before their player controller. */
+	bool bSnapshotRequestPending = false;
+
+	FTimerHandle SnapshotRequestTimerHandle;
+
+	/** Latent callbacks for the local (client) generation in seed mode. */
+	UFUNCTION()
+	void OnLocalGenerateRoomsUpdate();
+
+	UFUNCTION()
+	void OnLocalFinalizeRoomsUpdate();
+
+	EGenerateRoomsOutputPins LocalGenerateOutput {};
+	EFinalizeRoomsOutputPins LocalFinalizeOutput {};
+	int32 LocalGeneratedRooms = 0;
+	bool bLocalGenerationSuccess = false;
 	
 	UPROPERTY()
 	TMap<FString, ULevelStreamingDynamic*> LocalSpawnedLevels;
 
+	/** Instanced meshes for doors, keyed by door tag. */
+	UPROPERTY()
+	TMap<FGameplayTag, UHierarchicalInstancedStaticMeshComponent*> DoorInstances;
+
+	/** Instanced meshes for blocked doors, keyed by door tag. */
+	UPROPERTY()
+	TMap<FGameplayTag, UHierarchicalInstancedStaticMeshComponent*> BlockedDoorInstances;
+
+	/** Adds an instance of the door (or blocked door) mesh for the tag, creating the instanced mesh component if needed. Returns the index of the instance. */
+	int32 AddDoorInstance(const FGameplayTag& DoorTag, const FReberuDoorInfo& DoorInfo, const FTransform& DoorWorldTransform, bool bIsBlocked);
+
+	/** Hides an instance added by AddDoorInstance, AddDoorInstance reuses it for the next door. */
+	void HideDoorInstance(const FGameplayTag& DoorTag, int32 InstanceIdx, bool bIsBlocked);
+
+	/** Instances hidden by HideDoorInstance. Removing them would shift the index of every instance after them, so they are scaled down to nothing instead. */
+	TMap<UHierarchicalInstancedStaticMeshComponent*, TArray<int32>> HiddenDoorInstances;
+
+	/** Hidden level instances that can be reused, keyed by their room level asset. */
+	UPROPERTY()
+	TMap<FSoftObjectPath, FReberuPooledLevels> RoomLevelPool;
+
+	/** The room level asset each level instance was created from (instances get their own unique package so we can't get it from them). */
+	UPROPERTY()
+	TMap<ULevelStreamingDynamic*, FSoftObjectPath> RoomLevelSources;
+
+	/** Incremented every time the generation is cleared so level names never collide with pooled or unloading instances. */
+	int32 GenerationId = 0;
+
+	FTimerHandle PoolFlushTimerHandle;
+
+	/** Take a level instance of the room out of the pool and move it to the transform. Prefers instances that are already at the transform. */
+	ULevelStreamingDynamic* AcquirePooledRoom(const UReberuRoomData* InRoom, const FTransform& SpawnTransform);
+
+	/** Move an already created level instance to a new transform. */
+	static void MoveRoomLevel(ULevelStreamingDynamic* RoomLevel, const FTransform& NewTransform);
+
+	/** Built on demand by GetRoomGraph. */
+	mutable FReberuRoomGraph RoomGraph;
+
+	/** Whether the spawned rooms changed since the room graph was built, in a way it can't be updated in place. */
+	mutable bool bRoomGraphDirty = true;
+
+	/** Rooms added or changed since the room graph was built, GetRoomGraph updates the graph in place for them (see FReberuRoomGraph::UpdateRoom). */
+	mutable TArray<int32> ChangedRoomIdxs;
+
+	/** Above this amount of changed rooms, like when a whole layout is finalized, the room graph is built again instead. */
+	static constexpr int32 MaxChangedRooms = 64;
+
+	/** Bumped by MarkRoomLevelsChanged, see GetRoomLevelsVersion. */
+	int32 RoomLevelsVersion = 0;
+
+	/** Call whenever the spawned room levels change, so the room graph and everything built from them gets rebuilt. */
+	void MarkRoomLevelsChanged();
+
+	/** Call when a single room level was added or changed, so the room graph can be updated for it instead of being built again. */
+	void MarkRoomLevelChanged(int32 RoomIdx);
+
+	/** Built on demand by GetNavGraph, from the room graph with the version in NavGraphVersion. */
+	mutable FReberuNavGraph NavGraph;
+	mutable int32 RoomGraphVersion = 0;
+	mutable int32 NavGraphVersion = INDEX_NONE;
+
 public:
 	TDoubleLinkedList<FReberuMove>& GetMovesListRef(){return MovesList;}
 
 	FRandomStream& GetReberuRandomStream(){return ReberuRandomStream;}
 
 	bool IsGenerating() const{return bIsGenerating;}
+
+	/** Returns the spawned room with the layout index (if it exists locally). */
+	const FRoomLevel* GetRoomLevel(const int32 RoomIdx) const;
+
+	int32 GetNumRoomLevels() const{return SpawnedRoomLevels.Items.Num();}
+
+	/** Changes whenever a room level is added, changed or removed, including when a generation is cleared and regenerated with as many rooms. */
+	int32 GetRoomLevelsVersion() const{return RoomLevelsVersion;}
+
+	/** Returns the locally spawned level instance for the room with the layout index (if any). */
+	ULevelStreamingDynamic* GetRoomLevelInstance(const int32 RoomIdx) const;
+
+	/** Returns the world transform of the room bounds for the room with the layout index. */
+	FTransform GetRoomBoundsTransform(const int32 RoomIdx) const;
+
+	/** Adjacency graph of the spawned rooms with their hop distances. Rebuilt if rooms were spawned, changed or removed since it was last used. */
+	const FReberuRoomGraph& GetRoomGraph() const;
+
+	/** Amount of doors to go through between two spawned rooms (by layout index), -1 if they aren't connected. */
+	UFUNCTION(BlueprintPure, Category="Reberu")
+	int32 GetRoomHopDistance(int32 FromRoomIdx, int32 ToRoomIdx) const;
+
+	/** The rooms (by layout index) on a shortest path between two spawned rooms, both included. Returns false if they aren't connected. */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	bool GetRoomsBetween(int32 FromRoomIdx, int32 ToRoomIdx, TArray<int32>& OutRooms) const;
+
+	/** Baked navigation of the spawned rooms stitched at their doors. Rebuilt with the room graph. */
+	const FReberuNavGraph& GetNavGraph() const;
+
+	/**
+	 * Path through the baked room navigation, from Start to End. Returns false if they aren't in or near rooms with baked navigation, or aren't connected.
+	 * It doesn't go through the navigation system and doesn't replace the navmesh, see FReberuNavGraph.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	bool FindNavigationPath(const FVector& Start, const FVector& End, TArray<FVector>& OutPath) const;
+
 	void SetIsGenerating(const bool InBool){bIsGenerating = InBool;}
 };
 
@@ -57,11 +57,30 @@ public:
 	UFUNCTION(CallInEditor, BlueprintCallable, Category="DoorEditor", meta=(DisplayPriority=4))
 	void RegenerateDoorIds();
 
+	/**
+	 * Bakes the navmesh of this level inside the room box into the room's NavData, with a node at each polygon, at the middle of each edge between them and at each door.
+	 * Build the navigation of the room level first, and bake again whenever the room or its doors change.
+	 */
+	UFUNCTION(CallInEditor, BlueprintCallable, Category="Navigation")
+	void BakeNavigation();
+
+#if WITH_EDITORONLY_DATA
+	/** Bumped whenever the doors are changed in the editor, so the door visualizer only rebuilds what it draws when something changed. */
+	uint32 DoorsVersion = 0;
+#endif
+
+	void MarkDoorsChanged(){
+#if WITH_EDITORONLY_DATA
+		DoorsVersion++;
+#endif
+	}
+
 protected:
 	virtual void BeginPlay() override;
 	
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PostEditUndo() override;
 #endif
 	
 	/** Clamp the door gizmo to box bounds. */
@@ -21,4 +21,20 @@ public:
 	/** Default box extend for doors generated by Reberu. */
 	UPROPERTY(EditAnywhere, config, Category="Reberu")
 	FVector DefaultDoorExtent = FVector(3.f, 50.f, 100.f);
+
+	/** Milliseconds per frame the generation subsystem spends on queued generations, shared by all of them. The generate rooms task spends as much on a zoned layout. */
+	UPROPERTY(EditAnywhere, config, Category="Reberu|Generation", meta=(ClampMin=0))
+	float GenerationFrameBudgetMs = 4.f;
+
+	/** The most queued generations that run at the same time, the rest wait for one of them to finish. */
+	UPROPERTY(EditAnywhere, config, Category="Reberu|Generation", meta=(ClampMin=1))
+	int32 MaxConcurrentGenerations = 4;
+
+	/** Doors of RoomBounds further than this from the editor camera aren't drawn. 0 draws them at any distance. */
+	UPROPERTY(EditAnywhere, config, Category="Reberu|Editor", meta=(ClampMin=0))
+	float DoorDrawDistance = 10000.f;
+
+	/** Only doors closer than this to the editor camera (and the door being edited) show their index, id and tag. */
+	UPROPERTY(EditAnywhere, config, Category="Reberu|Editor", meta=(ClampMin=0))
+	float DoorLabelDistance = 1500.f;
 };
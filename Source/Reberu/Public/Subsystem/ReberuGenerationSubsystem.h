@@ -0,0 +1,81 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Data/ReberuPlacementIndex.h"
+#include "ReberuGenerationSubsystem.generated.h"
+
+class ALevelGeneratorActor;
+class UReberuData;
+struct FStreamableHandle;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnReberuGenerationFinishedSignature, ALevelGeneratorActor*, LevelGenerator, bool, bSuccess);
+
+/**
+ * Schedules the generations of every LevelGeneratorActor in a game world and owns the placement index they share.
+ * Queued generations place their rooms in data (see ALevelGeneratorActor::BeginScheduledGeneration) within a frame budget, the highest priority first,
+ * and test their rooms against the shared index instead of running physics overlaps against each other's RoomBounds.
+ * Zoned layouts are stepped a room at a time too, and so is spawning the RoomBounds of a finished layout, which can then be finalized like a layout from the generate rooms task.
+ */
+UCLASS()
+class REBERU_API UReberuGenerationSubsystem : public UTickableWorldSubsystem{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Queues a generation for the level generator. Generations with a higher priority get the frame budget first,
+	 * but every running generation places at least one room each frame. Returns false if the generator is already queued.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	bool QueueGeneration(ALevelGeneratorActor* LevelGenerator, UReberuData* ReberuData, int32 Seed, FTransform StartTransform, int32 Priority = 0);
+
+	/** Removes the generator's generation from the queue, without clearing what it generated so far. Returns false if it wasn't queued. */
+	UFUNCTION(BlueprintCallable, Category="Reberu")
+	bool CancelGeneration(ALevelGeneratorActor* LevelGenerator);
+
+	UFUNCTION(BlueprintPure, Category="Reberu")
+	bool IsGenerationQueued(const ALevelGeneratorActor* LevelGenerator) const;
+
+	/** Called when a queued generation has its RoomBounds spawned (or failed). Finalize the rooms from here. */
+	UPROPERTY(BlueprintAssignable)
+	FOnReberuGenerationFinishedSignature OnGenerationFinished;
+
+	/** Boxes of the rooms every generator in the world placed. */
+	FReberuPlacementIndex& GetSharedPlacementIndex(){return SharedPlacementIndex;}
+
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
+	virtual bool IsTickable() const override{return Jobs.Num() > 0;}
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	struct FReberuGenerationJob{
+		TWeakObjectPtr<ALevelGeneratorActor> LevelGenerator;
+		TWeakObjectPtr<UReberuData> ReberuData;
+		int32 Seed = 0;
+		FTransform StartTransform = FTransform::Identity;
+		int32 Priority = 0;
+
+		/** Rooms of the data being loaded before the generation can start. */
+		TSharedPtr<FStreamableHandle> LoadHandle;
+
+		bool bStarted = false;
+		bool bFinished = false;
+		bool bSuccess = false;
+	};
+
+	/** Starts the job once its rooms are loaded. Returns whether it is running. */
+	bool TryStartJob(FReberuGenerationJob& Job);
+
+	void FinishJob(FReberuGenerationJob& Job);
+
+	/** Sorted by priority, highest first. Jobs with the same priority run in the order they were queued. */
+	TArray<FReberuGenerationJob> Jobs;
+
+	FReberuPlacementIndex SharedPlacementIndex;
+};
@@ -33,6 +33,9 @@ public:
 	int32 CurrentIdx = 0;
 	UReberuData* ReberuData = nullptr;
 
+	/** Door classes and meshes of the layout are loaded before any door gets spawned. */
+	bool bRequestedLoad = false;
+
 	TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode* CurrentMove = nullptr;
 
 	// References
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "LevelGeneratorActor.h"
+#include "Engine/StreamableManager.h"
 #include "GenerateRoomsTask.generated.h"
 
 UENUM()
@@ -32,6 +33,13 @@ public:
 	bool bWantToCancel = false;
 	bool bIsCompleted = false;
 	int32 Seed = -1;
+
+	/** Use the seed as is, even if it is less than 1. Used when replaying a seed that was randomly generated on the server. */
+	bool bUseExactSeed = false;
+
+	/** Handle of the rooms being loaded before generation can start. */
+	TSharedPtr<FStreamableHandle> LoadHandle;
+	bool bRequestedLoad = false;
 	
 	FTransform StartRoomTransform = FTransform::Identity;
 
@@ -39,6 +47,9 @@ public:
 	bool bDebugDelay = false;
 	float DebugTimer = 0.f;
 
+	/** Zoned layouts are generated in data and their bounds spawned a frame budget at a time, see ALevelGeneratorActor::BeginRoomsInData. */
+	bool bGeneratedInData = false;
+
 	TDoubleLinkedList<FReberuMove>::TDoubleLinkedListNode* SourceRoomNode = nullptr;
 	int32 MaxBacktrackTries = 0;
 
@@ -26,7 +26,8 @@ public class Reberu : ModuleRules
 			new string[]
 			{
 				"Core",
-				"DeveloperSettings", "Engine"
+				"DeveloperSettings", "Engine",
+				"NetCore"
 			}
 			);
 			
@@ -38,7 +39,8 @@ public class Reberu : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
-				"GameplayTags"
+				"GameplayTags",
+				"NavigationSystem"
 			}
 			);
 	}
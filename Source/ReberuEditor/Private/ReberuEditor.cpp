@@ -5,7 +5,10 @@
 #include "UnrealEdGlobals.h"
 #include "Component/DoorVisualizerComponent.h"
 #include "Editor/UnrealEdEngine.h"
+#include "Framework/Docking/TabManager.h"
+#include "SeedExplorer/SReberuSeedExplorer.h"
 #include "Visualizer/DoorComponentVisualizer.h"
+#include "Widgets/Docking/SDockTab.h"
 
 DEFINE_LOG_CATEGORY(LogReberuEditor)
 
@@ -20,6 +23,16 @@ void FReberuEditorModule::StartupModule()
 		Visualizer->OnRegister();
 	}
 
+	FGlobalTabmanager::Get()->RegisterNomadTabSpawner(SReberuSeedExplorer::TabName, FOnSpawnTab::CreateLambda([](const FSpawnTabArgs&)
+	{
+		return SNew(SDockTab).TabRole(ETabRole::NomadTab)
+		[
+			SNew(SReberuSeedExplorer)
+		];
+	}))
+	.SetDisplayName(INVTEXT("Reberu Seed Explorer"))
+	.SetMenuType(ETabSpawnerMenuType::Hidden);
+
 	// Register a function to be called when menu system is initialized
 	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, &FReberuEditorModule::RegisterMenuExtensions));
 }
@@ -31,6 +44,11 @@ void FReberuEditorModule::ShutdownModule()
 		GUnrealEd->UnregisterComponentVisualizer(UDoorVisualizerComponent::StaticClass()->GetFName());
 	}
 
+	if (FSlateApplication::IsInitialized())
+	{
+		FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(SReberuSeedExplorer::TabName);
+	}
+
 	// Unregister the startup function
 	UToolMenus::UnRegisterStartupCallback(this);
  
@@ -65,6 +83,20 @@ void FReberuEditorModule::RegisterMenuExtensions(){
 		INVTEXT("Launches Reberu Editor Utility Widget"),
 		FSlateIcon(FAppStyle::GetAppStyleSetName(), "AssetEditor.ToggleShowBounds")
 	));
+
+	// Open the seed explorer from the Tools menu
+	UToolMenu* ToolsMenu = UToolMenus::Get()->ExtendMenu("LevelEditor.MainMenu.Tools");
+	FToolMenuSection& ToolsSection = ToolsMenu->FindOrAddSection("Reberu", INVTEXT("Reberu"));
+	ToolsSection.AddMenuEntry(
+		TEXT("ReberuSeedExplorer"),
+		INVTEXT("Reberu Seed Explorer"),
+		INVTEXT("Runs many seeds of a Reberu Data and charts their success, time, backtracks and room counts"),
+		FSlateIcon(FAppStyle::GetAppStyleSetName(), "LevelEditor.Tabs.StatsViewer"),
+		FUIAction(FExecuteAction::CreateLambda([]()
+		{
+			FGlobalTabmanager::Get()->TryInvokeTab(SReberuSeedExplorer::TabName);
+		}))
+	);
 }
 
 #undef LOCTEXT_NAMESPACE
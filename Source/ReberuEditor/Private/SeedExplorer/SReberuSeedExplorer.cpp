@@ -0,0 +1,429 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#include "SeedExplorer/SReberuSeedExplorer.h"
+
+#include "Editor.h"
+#include "EngineUtils.h"
+#include "LevelGeneratorActor.h"
+#include "PropertyCustomizationHelpers.h"
+#include "ReberuEditor.h"
+#include "ScopedTransaction.h"
+#include "Selection.h"
+#include "Data/ReberuData.h"
+#include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SSpinBox.h"
+#include "Widgets/Layout/SScrollBox.h"
+#include "Widgets/Text/STextBlock.h"
+
+const FName SReberuSeedExplorer::TabName = TEXT("ReberuSeedExplorer");
+
+FReberuSeedRunSummary FReberuSeedRunSummary::Make(const TConstArrayView<FReberuSeedResult> Results){
+	FReberuSeedRunSummary Summary;
+	Summary.NumSeeds = Results.Num();
+	if(Results.IsEmpty()) return Summary;
+
+	for (const FReberuSeedResult& Result : Results){
+		Summary.NumSuccesses += Result.bSuccess ? 1 : 0;
+		Summary.AverageTimeMs += Result.TimeMs;
+		Summary.MaxTimeMs = FMath::Max(Summary.MaxTimeMs, Result.TimeMs);
+		Summary.AverageBacktracks += Result.NumBacktracks;
+		Summary.AverageRooms += Result.NumRooms;
+	}
+	Summary.AverageTimeMs /= Results.Num();
+	Summary.AverageBacktracks /= Results.Num();
+	Summary.AverageRooms /= Results.Num();
+	return Summary;
+}
+
+FString FReberuSeedRunSummary::ToString() const{
+	const float SuccessRate = NumSeeds > 0 ? 100.f * NumSuccesses / NumSeeds : 0.f;
+	return FString::Printf(TEXT("%d seeds, %.1f%% success, %.2fms average (%.2fms max), %.1f backtracks, %.1f rooms"),
+		NumSeeds, SuccessRate, AverageTimeMs, MaxTimeMs, AverageBacktracks, AverageRooms);
+}
+
+void SReberuSeedHeatmap::Construct(const FArguments& InArgs){
+	Results = InArgs._Results;
+	ColorByBacktracks = InArgs._ColorByBacktracks;
+	SelectedIdx = InArgs._SelectedIdx;
+	OnSeedClicked = InArgs._OnSeedClicked;
+
+	SetToolTipText(TAttribute<FText>::CreateSP(this, &SReberuSeedHeatmap::GetHoveredText));
+}
+
+FVector2D SReberuSeedHeatmap::ComputeDesiredSize(float LayoutScaleMultiplier) const{
+	const int32 NumRows = Results ? FMath::DivideAndRoundUp(Results->Num(), NumColumns) : 0;
+	return FVector2D(NumColumns * CellSize, NumRows * CellSize);
+}
+
+int32 SReberuSeedHeatmap::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+	int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const{
+	if(!Results || Results->IsEmpty()) return LayerId;
+
+	const bool bByBacktracks = ColorByBacktracks.Get();
+	auto GetValue = [bByBacktracks](const FReberuSeedResult& Result){
+		return bByBacktracks ? static_cast<float>(Result.NumBacktracks) : Result.TimeMs;
+	};
+
+	float MaxValue = UE_SMALL_NUMBER;
+	for (const FReberuSeedResult& Result : *Results){
+		MaxValue = FMath::Max(MaxValue, GetValue(Result));
+	}
+
+	const FSlateBrush* Brush = FAppStyle::GetBrush("WhiteBrush");
+	const FVector2D CellDrawSize(CellSize - 1.f, CellSize - 1.f);
+	for (int32 ResultIdx = 0; ResultIdx < Results->Num(); ResultIdx++){
+		const FReberuSeedResult& Result = (*Results)[ResultIdx];
+		const FVector2D CellPosition((ResultIdx % NumColumns) * CellSize, (ResultIdx / NumColumns) * CellSize);
+		const FLinearColor CellColor = Result.bSuccess ? FLinearColor::LerpUsingHSV(FLinearColor::Green, FLinearColor::Red, GetValue(Result) / MaxValue)
+			: FLinearColor(.35f, 0.f, .45f);
+
+		FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(CellDrawSize, FSlateLayoutTransform(CellPosition)),
+			Brush, ESlateDrawEffect::None, CellColor);
+	}
+
+	// Outline the seed that is being previewed
+	const int32 Selected = SelectedIdx.Get();
+	if(Results->IsValidIndex(Selected)){
+		const FVector2D Min((Selected % NumColumns) * CellSize - 1.f, (Selected / NumColumns) * CellSize - 1.f);
+		const FVector2D Max = Min + FVector2D(CellSize + 1.f, CellSize + 1.f);
+		const TArray<FVector2D> Outline = {Min, FVector2D(Max.X, Min.Y), Max, FVector2D(Min.X, Max.Y), Min};
+		FSlateDrawElement::MakeLines(OutDrawElements, LayerId + 1, AllottedGeometry.ToPaintGeometry(), Outline, ESlateDrawEffect::None, FLinearColor::White, true, 2.f);
+	}
+	return LayerId + 1;
+}
+
+int32 SReberuSeedHeatmap::GetResultIdxAt(const FGeometry& MyGeometry, const FVector2D& ScreenPosition) const{
+	if(!Results) return INDEX_NONE;
+
+	const FVector2D LocalPosition = MyGeometry.AbsoluteToLocal(ScreenPosition);
+	const int32 Column = FMath::FloorToInt32(LocalPosition.X / CellSize);
+	const int32 Row = FMath::FloorToInt32(LocalPosition.Y / CellSize);
+	if(Column < 0 || Column >= NumColumns || Row < 0) return INDEX_NONE;
+
+	const int32 ResultIdx = Row * NumColumns + Column;
+	return Results->IsValidIndex(ResultIdx) ? ResultIdx : INDEX_NONE;
+}
+
+FReply SReberuSeedHeatmap::OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent){
+	if(MouseEvent.GetEffectingButton() != EKeys::LeftMouseButton) return FReply::Unhandled();
+
+	const int32 ResultIdx = GetResultIdxAt(MyGeometry, MouseEvent.GetScreenSpacePosition());
+	if(ResultIdx == INDEX_NONE) return FReply::Unhandled();
+
+	OnSeedClicked.ExecuteIfBound(ResultIdx);
+	return FReply::Handled();
+}
+
+FReply SReberuSeedHeatmap::OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent){
+	HoveredIdx = GetResultIdxAt(MyGeometry, MouseEvent.GetScreenSpacePosition());
+	return FReply::Unhandled();
+}
+
+void SReberuSeedHeatmap::OnMouseLeave(const FPointerEvent& MouseEvent){
+	SLeafWidget::OnMouseLeave(MouseEvent);
+	HoveredIdx = INDEX_NONE;
+}
+
+FText SReberuSeedHeatmap::GetHoveredText() const{
+	if(!Results || !Results->IsValidIndex(HoveredIdx)) return FText::GetEmpty();
+
+	const FReberuSeedResult& Result = (*Results)[HoveredIdx];
+	return FText::FromString(FString::Printf(TEXT("Seed %d\n%s, %d rooms, %d backtracks, %.2fms"), Result.Seed,
+		Result.bSuccess ? TEXT("Succeeded") : TEXT("Failed"), Result.NumRooms, Result.NumBacktracks, Result.TimeMs));
+}
+
+void SReberuHistogram::Construct(const FArguments& InArgs){
+	Buckets = InArgs._Buckets;
+	Color = InArgs._Color;
+}
+
+int32 SReberuHistogram::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+	int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const{
+	const FSlateBrush* Brush = FAppStyle::GetBrush("WhiteBrush");
+	const FVector2D Size = AllottedGeometry.GetLocalSize();
+
+	FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(), Brush, ESlateDrawEffect::None, FLinearColor(.02f, .02f, .02f));
+	if(!Buckets || Buckets->IsEmpty()) return LayerId + 1;
+
+	const int32 MaxCount = FMath::Max(1, FMath::Max(*Buckets));
+	const float BarWidth = Size.X / Buckets->Num();
+	for (int32 BucketIdx = 0; BucketIdx < Buckets->Num(); BucketIdx++){
+		const float BarHeight = Size.Y * (*Buckets)[BucketIdx] / MaxCount;
+		if(BarHeight <= 0.f) continue;
+
+		FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 1,
+			AllottedGeometry.ToPaintGeometry(FVector2D(FMath::Max(1.f, BarWidth - 1.f), BarHeight), FSlateLayoutTransform(FVector2D(BucketIdx * BarWidth, Size.Y - BarHeight))),
+			Brush, ESlateDrawEffect::None, Color);
+	}
+	return LayerId + 2;
+}
+
+void SReberuSeedExplorer::Construct(const FArguments& InArgs){
+	auto MakeHistogram = [](const TArray<int32>* InBuckets, const FLinearColor& InColor, TFunction<FText()> GetCaption){
+		return SNew(SVerticalBox)
+			+ SVerticalBox::Slot().AutoHeight().Padding(0.f, 0.f, 0.f, 2.f)
+			[
+				SNew(STextBlock).Text_Lambda(MoveTemp(GetCaption))
+			]
+			+ SVerticalBox::Slot().AutoHeight()
+			[
+				SNew(SReberuHistogram).Buckets(InBuckets).Color(InColor)
+			];
+	};
+
+	ChildSlot
+	[
+		SNew(SVerticalBox)
+		+ SVerticalBox::Slot().AutoHeight().Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(STextBlock).Text(INVTEXT("Reberu Data"))
+			]
+			+ SHorizontalBox::Slot().FillWidth(1.f)
+			[
+				SNew(SObjectPropertyEntryBox)
+				.AllowedClass(UReberuData::StaticClass())
+				.ObjectPath(this, &SReberuSeedExplorer::GetReberuDataPath)
+				.OnObjectChanged(this, &SReberuSeedExplorer::OnReberuDataChanged)
+				.AllowClear(true)
+			]
+		]
+		+ SVerticalBox::Slot().AutoHeight().Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(STextBlock).Text(INVTEXT("First Seed"))
+			]
+			+ SHorizontalBox::Slot().FillWidth(1.f).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(SSpinBox<int32>)
+				.Value_Lambda([this](){return FirstSeed;})
+				.OnValueChanged_Lambda([this](const int32 Value){FirstSeed = Value;})
+				.IsEnabled_Lambda([this](){return !IsRunning();})
+			]
+			+ SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(STextBlock).Text(INVTEXT("Seeds"))
+			]
+			+ SHorizontalBox::Slot().FillWidth(1.f).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(SSpinBox<int32>)
+				.MinValue(1)
+				.MaxValue(100000)
+				.Value_Lambda([this](){return NumSeeds;})
+				.OnValueChanged_Lambda([this](const int32 Value){NumSeeds = Value;})
+				.IsEnabled_Lambda([this](){return !IsRunning();})
+			]
+			+ SHorizontalBox::Slot().AutoWidth().Padding(0.f, 0.f, 4.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(INVTEXT("Run"))
+				.OnClicked(this, &SReberuSeedExplorer::OnRunClicked)
+				.IsEnabled_Lambda([this](){return !IsRunning() && ReberuData.IsValid();})
+			]
+			+ SHorizontalBox::Slot().AutoWidth().Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				SNew(SButton)
+				.Text(INVTEXT("Stop"))
+				.OnClicked(this, &SReberuSeedExplorer::OnStopClicked)
+				.IsEnabled_Lambda([this](){return IsRunning();})
+			]
+			+ SHorizontalBox::Slot().AutoWidth().VAlign(VAlign_Center)
+			[
+				SNew(SCheckBox)
+				.IsChecked_Lambda([this](){return bColorByBacktracks ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;})
+				.OnCheckStateChanged_Lambda([this](const ECheckBoxState State){bColorByBacktracks = State == ECheckBoxState::Checked;})
+				[
+					SNew(STextBlock).Text(INVTEXT("Color by backtracks"))
+				]
+			]
+		]
+		+ SVerticalBox::Slot().AutoHeight().Padding(4.f)
+		[
+			SNew(STextBlock).Text_Lambda([this](){return StatusText;})
+		]
+		+ SVerticalBox::Slot().AutoHeight().Padding(4.f)
+		[
+			SNew(STextBlock).Text(this, &SReberuSeedExplorer::GetSummaryText)
+		]
+		+ SVerticalBox::Slot().AutoHeight().Padding(4.f)
+		[
+			SNew(SHorizontalBox)
+			+ SHorizontalBox::Slot().FillWidth(1.f).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				MakeHistogram(&RoomBuckets, FLinearColor(.2f, .5f, 1.f), [this](){return FText::FromString(FString::Printf(TEXT("Rooms (0 - %d)"), MaxRooms));})
+			]
+			+ SHorizontalBox::Slot().FillWidth(1.f).Padding(0.f, 0.f, 8.f, 0.f)
+			[
+				MakeHistogram(&TimeBuckets, FLinearColor(1.f, .6f, .1f), [this](){return FText::FromString(FString::Printf(TEXT("Time (0 - %.2fms)"), MaxTimeMs));})
+			]
+			+ SHorizontalBox::Slot().FillWidth(1.f)
+			[
+				MakeHistogram(&BacktrackBuckets, FLinearColor(1.f, .25f, .25f), [this](){return FText::FromString(FString::Printf(TEXT("Backtracks (0 - %d)"), MaxBacktracks));})
+			]
+		]
+		+ SVerticalBox::Slot().FillHeight(1.f).Padding(4.f)
+		[
+			SNew(SScrollBox)
+			+ SScrollBox::Slot()
+			[
+				SNew(SReberuSeedHeatmap)
+				.Results(&Results)
+				.ColorByBacktracks_Lambda([this](){return bColorByBacktracks;})
+				.SelectedIdx_Lambda([this](){return SelectedIdx;})
+				.OnSeedClicked(this, &SReberuSeedExplorer::OnSeedClicked)
+			]
+		]
+	];
+}
+
+FString SReberuSeedExplorer::GetReberuDataPath() const{
+	return ReberuData.IsValid() ? ReberuData->GetPathName() : FString();
+}
+
+void SReberuSeedExplorer::OnReberuDataChanged(const FAssetData& AssetData){
+	if(IsRunning()){
+		StopRun(INVTEXT("Stopped, the Reberu Data changed."));
+	}
+	ReberuData = Cast<UReberuData>(AssetData.GetAsset());
+}
+
+ALevelGeneratorActor* SReberuSeedExplorer::FindLevelGenerator(){
+	if(!GEditor) return nullptr;
+
+	if(ALevelGeneratorActor* SelectedGenerator = GEditor->GetSelectedActors()->GetTop<ALevelGeneratorActor>()){
+		return SelectedGenerator;
+	}
+
+	UWorld* World = GEditor->GetEditorWorldContext().World();
+	if(!World) return nullptr;
+
+	TActorIterator<ALevelGeneratorActor> It(World);
+	return It ? *It : nullptr;
+}
+
+FReply SReberuSeedExplorer::OnRunClicked(){
+	UReberuData* Data = ReberuData.Get();
+	ALevelGeneratorActor* Generator = FindLevelGenerator();
+	if(!Data) return FReply::Handled();
+	if(!Generator){
+		StatusText = INVTEXT("Place a LevelGeneratorActor in the level (or select one) to run seeds.");
+		return FReply::Handled();
+	}
+
+	// The rooms have to be loaded to generate, same as the preview
+	if(const TSharedPtr<FStreamableHandle> LoadHandle = Data->LoadGenerationData()){
+		LoadHandle->WaitUntilComplete();
+		Data->InvalidateCatalog();
+	}
+
+	if(!Results.IsEmpty()){
+		PreviousSummary = FReberuSeedRunSummary::Make(Results);
+	}
+	Results.Reset(NumSeeds);
+	SelectedIdx = INDEX_NONE;
+	LevelGenerator = Generator;
+	UpdateBuckets();
+
+	StatusText = FText::FromString(FString::Printf(TEXT("Running %d seeds of %s on %s..."), NumSeeds, *Data->GetName(), *Generator->GetActorNameOrLabel()));
+	ActiveTimer = RegisterActiveTimer(0.f, FWidgetActiveTimerDelegate::CreateSP(this, &SReberuSeedExplorer::RunBatch));
+	return FReply::Handled();
+}
+
+FReply SReberuSeedExplorer::OnStopClicked(){
+	StopRun(FText::FromString(FString::Printf(TEXT("Stopped after %d seeds."), Results.Num())));
+	return FReply::Handled();
+}
+
+void SReberuSeedExplorer::StopRun(const FText& InStatusText){
+	if(ActiveTimer.IsValid()){
+		UnRegisterActiveTimer(ActiveTimer.ToSharedRef());
+		ActiveTimer.Reset();
+	}
+	StatusText = InStatusText;
+}
+
+EActiveTimerReturnType SReberuSeedExplorer::RunBatch(double InCurrentTime, float InDeltaTime){
+	ALevelGeneratorActor* Generator = LevelGenerator.Get();
+	UReberuData* Data = ReberuData.Get();
+	if(!Generator || !Data){
+		ActiveTimer.Reset();
+		StatusText = INVTEXT("Stopped, the level generator or Reberu Data is gone.");
+		return EActiveTimerReturnType::Stop;
+	}
+
+	const FTransform StartTransform = Generator->GetActorTransform();
+	const double BatchEndTime = FPlatformTime::Seconds() + FrameBudgetSeconds;
+	TArray<FReberuMove> Moves;
+	while(Results.Num() < NumSeeds && FPlatformTime::Seconds() < BatchEndTime){
+		FReberuSeedResult Result;
+		Result.Seed = FirstSeed + Results.Num();
+
+		const double StartTime = FPlatformTime::Seconds();
+		Result.bSuccess = Generator->GenerateDataLayout(Data, Result.Seed, StartTransform, Moves, &Result.NumBacktracks);
+		Result.TimeMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		Result.NumRooms = Moves.Num();
+
+		// Not even the starting room was placed, so the generator is busy or the data can't generate at all
+		if(Moves.IsEmpty()){
+			ActiveTimer.Reset();
+			StatusText = INVTEXT("Stopped, the generator couldn't generate. It might be generating, or Analyze Rooms on the Reberu Data reports errors.");
+			UpdateBuckets();
+			return EActiveTimerReturnType::Stop;
+		}
+		Results.Add(Result);
+	}
+	UpdateBuckets();
+
+	if(Results.Num() < NumSeeds) return EActiveTimerReturnType::Continue;
+
+	ActiveTimer.Reset();
+	StatusText = FText::FromString(FString::Printf(TEXT("Done, ran %d seeds of %s."), Results.Num(), *Data->GetName()));
+	REBERU_ED_LOG_ARGS(Log, "Seed explorer: %s, %s", *Data->GetName(), *FReberuSeedRunSummary::Make(Results).ToString())
+	return EActiveTimerReturnType::Stop;
+}
+
+void SReberuSeedExplorer::UpdateBuckets(){
+	constexpr int32 NumBuckets = 20;
+
+	MaxTimeMs = 0.f;
+	MaxBacktracks = 0;
+	MaxRooms = ReberuData.IsValid() ? ReberuData->TargetRoomAmount : 0;
+	for (const FReberuSeedResult& Result : Results){
+		MaxTimeMs = FMath::Max(MaxTimeMs, Result.TimeMs);
+		MaxBacktracks = FMath::Max(MaxBacktracks, Result.NumBacktracks);
+		MaxRooms = FMath::Max(MaxRooms, Result.NumRooms);
+	}
+
+	// Rooms get a bucket per count, the others are spread over a fixed amount of buckets
+	RoomBuckets.Init(0, MaxRooms + 1);
+	TimeBuckets.Init(0, NumBuckets);
+	BacktrackBuckets.Init(0, FMath::Min(NumBuckets, MaxBacktracks + 1));
+	for (const FReberuSeedResult& Result : Results){
+		RoomBuckets[Result.NumRooms]++;
+		TimeBuckets[FMath::Min(NumBuckets - 1, FMath::FloorToInt32(NumBuckets * Result.TimeMs / FMath::Max(MaxTimeMs, UE_SMALL_NUMBER)))]++;
+		BacktrackBuckets[FMath::Min(BacktrackBuckets.Num() - 1, Result.NumBacktracks * BacktrackBuckets.Num() / (MaxBacktracks + 1))]++;
+	}
+}
+
+FText SReberuSeedExplorer::GetSummaryText() const{
+	FString Summary = FString::Printf(TEXT("Current: %s"), *FReberuSeedRunSummary::Make(Results).ToString());
+	if(PreviousSummary.IsSet()){
+		Summary += FString::Printf(TEXT("\nPrevious: %s"), *PreviousSummary->ToString());
+	}
+	return FText::FromString(Summary);
+}
+
+void SReberuSeedExplorer::OnSeedClicked(const int32 ResultIdx){
+	ALevelGeneratorActor* Generator = LevelGenerator.IsValid() ? LevelGenerator.Get() : FindLevelGenerator();
+	if(!Generator || !ReberuData.IsValid() || !Results.IsValidIndex(ResultIdx) || IsRunning()) return;
+
+	SelectedIdx = ResultIdx;
+
+	const FScopedTransaction Transaction(INVTEXT("Preview Reberu Seed"));
+	Generator->SetPreview(ReberuData.Get(), Results[ResultIdx].Seed);
+}
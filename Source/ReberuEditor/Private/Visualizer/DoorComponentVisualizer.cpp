@@ -8,14 +8,18 @@
 #include "RoomBounds.h"
 #include "Component/DoorVisualizerComponent.h"
 #include "SceneManagement.h"
+#include "Settings/ReberuSettings.h"
 
 void FDoorComponentVisualizer::DrawVisualization(const UActorComponent* Component, const FSceneView* View, FPrimitiveDrawInterface* PDI){
 	const UDoorVisualizerComponent* DoorComponent = Cast<UDoorVisualizerComponent>(Component);
 	if (!DoorComponent) return;
 	
 	ARoomBounds* RoomBounds = DoorComponent->GetRoomBounds();
+	if (!RoomBounds) return;
+
 	const FTransform RoomBoundsTransform = RoomBounds->GetActorTransform();
 	const FTransform DoorSpawnWorldTransform = RoomBounds->DoorSpawn * RoomBoundsTransform;
+	const FCachedRoom& CachedRoom = GetCachedRoom(RoomBounds, RoomBoundsTransform);
 
 	int32 CurrentDoorIdx = INDEX_NONE;
 	
@@ -25,42 +29,86 @@ void FDoorComponentVisualizer::DrawVisualization(const UActorComponent* Componen
 		DrawDirectionalArrow(PDI, Matrix, FLinearColor::Blue, 30.f, 10.f, SDPG_World, 1.f);
 	}
 	else if (const FReberuDoor* CurrentDoor = RoomBounds->Room.GetDoorById(RoomBounds->CurrentlyEditingDoorId)){
+		// The edited door follows the gizmo, so it is the only one drawn from the live data
 		CurrentDoorIdx = RoomBounds->Room.GetDoorIdxById(RoomBounds->CurrentlyEditingDoorId);
-		DrawDoor(View, PDI, DoorSpawnWorldTransform, CurrentDoor->BoxExtent, CurrentDoorIdx, CurrentDoor->DoorId, FLinearColor::Yellow, FLinearColor::Red, CurrentDoor->DoorTag);
+		DrawDoor(PDI, DoorSpawnWorldTransform.ToMatrixWithScale(), CurrentDoor->BoxExtent, FLinearColor::Yellow);
+		DrawWorldText(DoorSpawnWorldTransform.GetLocation() + FVector(0.f, 0.f, 40.f), View, MakeDoorLabel(CurrentDoorIdx, CurrentDoor->DoorId, CurrentDoor->DoorTag), FLinearColor::Red);
 	}
 
-	// Display all other doors
-	TArray<FReberuDoor> DoorsToDraw = RoomBounds->Room.ReberuDoors;
-	int32 DoorIdx = 0;
-	for (FReberuDoor Door : DoorsToDraw){
-		if(CurrentDoorIdx == INDEX_NONE || DoorIdx != CurrentDoorIdx){
-			DrawDoor(View, PDI, Door.DoorTransform * RoomBoundsTransform, Door.BoxExtent, DoorIdx, Door.DoorId, FLinearColor::Green, FLinearColor::Red, Door.DoorTag);
+	// Display all other doors, skipping the ones that are too far away or off screen and only labeling the close ones
+	const UReberuSettings* Settings = GetDefault<UReberuSettings>();
+	const double DrawDistanceSquared = Settings->DoorDrawDistance > 0.f ? FMath::Square(Settings->DoorDrawDistance) : TNumericLimits<double>::Max();
+	const double LabelDistanceSquared = FMath::Square(Settings->DoorLabelDistance);
+	const FVector ViewLocation = View->ViewMatrices.GetViewOrigin();
+
+	for (int32 DoorIdx = 0; DoorIdx < CachedRoom.Doors.Num(); DoorIdx++){
+		if(DoorIdx == CurrentDoorIdx) continue;
+
+		const FCachedDoor& Door = CachedRoom.Doors[DoorIdx];
+		const double DistanceSquared = FVector::DistSquared(ViewLocation, Door.Location);
+		if(DistanceSquared > DrawDistanceSquared) continue;
+		if(!View->ViewFrustum.IntersectBox(Door.WorldBox.GetCenter(), Door.WorldBox.GetExtent())) continue;
+
+		DrawDoor(PDI, Door.Matrix, Door.Extent, FLinearColor::Green);
+		if(DistanceSquared <= LabelDistanceSquared){
+			DrawWorldText(Door.Location + FVector(0.f, 0.f, 40.f), View, Door.Label, FLinearColor::Red);
 		}
-		DoorIdx++;
 	}
 }
 
-void FDoorComponentVisualizer::DrawDoor(const FSceneView* View, FPrimitiveDrawInterface* PDI, const FTransform& DoorWorldTransform, const FVector& DoorExtent,
-	const int32 DoorIndex, const FString& DoorId, const FLinearColor Color, FLinearColor TextColor, FGameplayTag DoorTag)
-{
-	const FMatrix Matrix = DoorWorldTransform.ToMatrixWithScale();
+const FDoorComponentVisualizer::FCachedRoom& FDoorComponentVisualizer::GetCachedRoom(const ARoomBounds* RoomBounds, const FTransform& RoomBoundsTransform){
+	FCachedRoom* CachedRoom = CachedRooms.Find(RoomBounds);
+	if(!CachedRoom){
+		// Forget rooms that were deleted before adding a new one
+		for (auto It = CachedRooms.CreateIterator(); It; ++It){
+			if(!It.Key().IsValid()) It.RemoveCurrent();
+		}
+		CachedRoom = &CachedRooms.Add(RoomBounds);
+	}
+
+	const TArray<FReberuDoor>& Doors = RoomBounds->Room.ReberuDoors;
+	if(CachedRoom->DoorsVersion == RoomBounds->DoorsVersion && CachedRoom->NumDoors == Doors.Num() && CachedRoom->RoomBoundsTransform.Equals(RoomBoundsTransform)){
+		return *CachedRoom;
+	}
+
+	CachedRoom->DoorsVersion = RoomBounds->DoorsVersion;
+	CachedRoom->NumDoors = Doors.Num();
+	CachedRoom->RoomBoundsTransform = RoomBoundsTransform;
+	CachedRoom->Doors.Reset(Doors.Num());
+	for (int32 DoorIdx = 0; DoorIdx < Doors.Num(); DoorIdx++){
+		const FReberuDoor& Door = Doors[DoorIdx];
+		const FTransform DoorWorldTransform = Door.DoorTransform * RoomBoundsTransform;
+
+		FCachedDoor& CachedDoor = CachedRoom->Doors.AddDefaulted_GetRef();
+		CachedDoor.Matrix = DoorWorldTransform.ToMatrixWithScale();
+		CachedDoor.Extent = Door.BoxExtent;
+		CachedDoor.Location = DoorWorldTransform.GetLocation();
+		CachedDoor.WorldBox = FBox(-Door.BoxExtent, Door.BoxExtent).TransformBy(DoorWorldTransform);
+		CachedDoor.Label = MakeDoorLabel(DoorIdx, Door.DoorId, Door.DoorTag);
+	}
+	return *CachedRoom;
+}
 
-	DrawDirectionalArrow(PDI, Matrix, FLinearColor::Blue, 30.f, 10.f, SDPG_World, 1.f);
+void FDoorComponentVisualizer::DrawDoor(FPrimitiveDrawInterface* PDI, const FMatrix& DoorWorldMatrix, const FVector& DoorExtent, const FLinearColor Color)
+{
+	DrawDirectionalArrow(PDI, DoorWorldMatrix, FLinearColor::Blue, 30.f, 10.f, SDPG_World, 1.f);
 
 	// display an AABB using the origin/extent method
-	DrawWireBox(PDI, Matrix, FBox::BuildAABB(FVector(), DoorExtent), Color, SDPG_World, 3.f);
+	DrawWireBox(PDI, DoorWorldMatrix, FBox::BuildAABB(FVector(), DoorExtent), Color, SDPG_World, 3.f);
+}
 
-	FString WorldString = TEXT("Door Idx: ");
-	WorldString += FString::FromInt(DoorIndex);
-	WorldString += FString::Printf(TEXT("\n %s"), *DoorId);
-	WorldString += FString::Printf(TEXT("\n %s"), *DoorTag.ToString());
-	DrawWorldText(DoorWorldTransform.GetLocation() + FVector(0.f, 0.f, 40.f), View, WorldString, TextColor);
+FString FDoorComponentVisualizer::MakeDoorLabel(const int32 DoorIndex, const FString& DoorId, const FGameplayTag& DoorTag){
+	return FString::Printf(TEXT("Door Idx: %d\n %s\n %s"), DoorIndex, *DoorId, *DoorTag.ToString());
 }
 
 void FDoorComponentVisualizer::DrawWorldText(const FVector& InWorldLocation, const FSceneView* InView, const FString& InString, FLinearColor Color){
 	// https://forums.unrealengine.com/t/how-to-draw-world-space-text-for-a-custom-editor-mode/480200/3
-	FVector TextPosition = InView->Project(InWorldLocation);
-	if(TextPosition.X < 1.0f && TextPosition.X > -1.0f && (TextPosition.Y < 1.0f || TextPosition.Y > -1.0f)){
+	const FPlane ScreenPosition = InView->WorldToScreen(InWorldLocation);
+	// Behind the camera
+	if(ScreenPosition.W <= 0.f) return;
+
+	FVector TextPosition = FVector(ScreenPosition) / ScreenPosition.W;
+	if(TextPosition.X < 1.0f && TextPosition.X > -1.0f && TextPosition.Y < 1.0f && TextPosition.Y > -1.0f){
 		FViewport* Viewport = GEditor->GetActiveViewport();
 		FCanvas* DebugCanvas = Viewport->GetDebugCanvas();
 
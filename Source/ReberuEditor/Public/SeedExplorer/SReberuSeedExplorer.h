@@ -0,0 +1,169 @@
+// Copyright Peter Gilbert, All Rights Reserved
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SCompoundWidget.h"
+#include "Widgets/SLeafWidget.h"
+
+class ALevelGeneratorActor;
+class UReberuData;
+struct FAssetData;
+
+/** Result of generating a single seed in pure data. */
+struct FReberuSeedResult{
+	int32 Seed = 0;
+	int32 NumRooms = 0;
+	int32 NumBacktracks = 0;
+	float TimeMs = 0.f;
+	bool bSuccess = false;
+};
+
+/** Totals of a run, the previous run is kept around to see if a change to the data made generation slower or more fragile. */
+struct FReberuSeedRunSummary{
+	static FReberuSeedRunSummary Make(TConstArrayView<FReberuSeedResult> Results);
+
+	FString ToString() const;
+
+	int32 NumSeeds = 0;
+	int32 NumSuccesses = 0;
+	float AverageTimeMs = 0.f;
+	float MaxTimeMs = 0.f;
+	float AverageBacktracks = 0.f;
+	float AverageRooms = 0.f;
+};
+
+DECLARE_DELEGATE_OneParam(FOnReberuSeedClicked, int32 /*ResultIdx*/);
+
+/** Grid with a cell per seed (a row per hundred seeds), colored from green to red by generation time or backtracks. Failed seeds are purple. */
+class SReberuSeedHeatmap : public SLeafWidget{
+public:
+	SLATE_BEGIN_ARGS(SReberuSeedHeatmap){}
+		SLATE_ARGUMENT(const TArray<FReberuSeedResult>*, Results)
+		SLATE_ATTRIBUTE(bool, ColorByBacktracks)
+		SLATE_ATTRIBUTE(int32, SelectedIdx)
+		SLATE_EVENT(FOnReberuSeedClicked, OnSeedClicked)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+		int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+	virtual FReply OnMouseButtonDown(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+
+	virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
+
+	virtual void OnMouseLeave(const FPointerEvent& MouseEvent) override;
+
+protected:
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+	/** Index of the result under the mouse, INDEX_NONE if there is none. */
+	int32 GetResultIdxAt(const FGeometry& MyGeometry, const FVector2D& ScreenPosition) const;
+
+	FText GetHoveredText() const;
+
+	static constexpr int32 NumColumns = 100;
+	static constexpr float CellSize = 6.f;
+
+	const TArray<FReberuSeedResult>* Results = nullptr;
+	TAttribute<bool> ColorByBacktracks;
+	TAttribute<int32> SelectedIdx;
+	FOnReberuSeedClicked OnSeedClicked;
+	int32 HoveredIdx = INDEX_NONE;
+};
+
+/** Bar chart of how many seeds fall in each bucket. */
+class SReberuHistogram : public SLeafWidget{
+public:
+	SLATE_BEGIN_ARGS(SReberuHistogram)
+		: _Color(FLinearColor::White){}
+		SLATE_ARGUMENT(const TArray<int32>*, Buckets)
+		SLATE_ARGUMENT(FLinearColor, Color)
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+		int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+protected:
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override{return FVector2D(200.f, 80.f);}
+
+	const TArray<int32>* Buckets = nullptr;
+	FLinearColor Color;
+};
+
+/**
+ * Editor tab that generates a range of seeds of a ReberuData in pure data (see ALevelGeneratorActor::GenerateDataLayout) and charts
+ * the success rate, generation time, backtracks and room counts. Clicking a seed previews it on the level generator.
+ * Seeds are generated a few milliseconds each frame so the editor stays responsive, since rules and overrides have to run on the game thread.
+ */
+class SReberuSeedExplorer : public SCompoundWidget{
+public:
+	SLATE_BEGIN_ARGS(SReberuSeedExplorer){}
+	SLATE_END_ARGS()
+
+	void Construct(const FArguments& InArgs);
+
+	static const FName TabName;
+
+protected:
+	FReply OnRunClicked();
+
+	FReply OnStopClicked();
+
+	void StopRun(const FText& InStatusText);
+
+	bool IsRunning() const{return ActiveTimer.IsValid();}
+
+	/** Generates seeds until the frame budget is used up. */
+	EActiveTimerReturnType RunBatch(double InCurrentTime, float InDeltaTime);
+
+	void OnSeedClicked(int32 ResultIdx);
+
+	/** The selected level generator, or the first one in the editor world. */
+	static ALevelGeneratorActor* FindLevelGenerator();
+
+	void UpdateBuckets();
+
+	FString GetReberuDataPath() const;
+
+	void OnReberuDataChanged(const FAssetData& AssetData);
+
+	FText GetSummaryText() const;
+
+	TWeakObjectPtr<UReberuData> ReberuData;
+
+	/** The generator the current run uses, so subclasses with custom choices are explored too. */
+	TWeakObjectPtr<ALevelGeneratorActor> LevelGenerator;
+
+	int32 FirstSeed = 0;
+
+	int32 NumSeeds = 2000;
+
+	/** How long we generate each frame. */
+	static constexpr double FrameBudgetSeconds = .01;
+
+	TArray<FReberuSeedResult> Results;
+
+	/** Rooms per layout, from 0 to the TargetRoomAmount. */
+	TArray<int32> RoomBuckets;
+	TArray<int32> TimeBuckets;
+	TArray<int32> BacktrackBuckets;
+
+	float MaxTimeMs = 0.f;
+	int32 MaxBacktracks = 0;
+	int32 MaxRooms = 0;
+
+	TOptional<FReberuSeedRunSummary> PreviousSummary;
+
+	int32 SelectedIdx = INDEX_NONE;
+
+	bool bColorByBacktracks = false;
+
+	TSharedPtr<FActiveTimerHandle> ActiveTimer;
+
+	FText StatusText;
+};
@@ -5,6 +5,8 @@
 #include "ComponentVisualizer.h"
 #include "GameplayTagContainer.h"
 
+class ARoomBounds;
+
 /**
  * Component visualizer to see the representation of a door in the scene.
  * I just realized how confusing it is to have DoorComponentVisualizer and DoorVisualizerComponent but oh well.
@@ -22,9 +24,32 @@ public:
 	// 	const FSceneView* View, FCanvas* Canvas) override;
 
 	/** Helper function for drawing a Door */
-	static void DrawDoor(const FSceneView* View, FPrimitiveDrawInterface* PDI, const FTransform& DoorWorldTransform, const FVector& DoorExtent, const int32 DoorIndex,
-	                     const FString& DoorId, const FLinearColor Color, FLinearColor TextColor, FGameplayTag DoorTag);
+	static void DrawDoor(FPrimitiveDrawInterface* PDI, const FMatrix& DoorWorldMatrix, const FVector& DoorExtent, const FLinearColor Color);
 
 	/** Helper function for drawing text in world space */
 	static void DrawWorldText(const FVector& InWorldLocation, const FSceneView* InView, const FString& InString, FLinearColor Color);
+
+	static FString MakeDoorLabel(int32 DoorIndex, const FString& DoorId, const FGameplayTag& DoorTag);
+
+protected:
+	/** What gets drawn for a door, in world space. */
+	struct FCachedDoor{
+		FMatrix Matrix;
+		FVector Extent;
+		FVector Location;
+		FBox WorldBox;
+		FString Label;
+	};
+
+	struct FCachedRoom{
+		uint32 DoorsVersion = 0;
+		int32 NumDoors = INDEX_NONE;
+		FTransform RoomBoundsTransform;
+		TArray<FCachedDoor> Doors;
+	};
+
+	/** Returns the cached doors of the room, rebuilding them if the doors or the room transform changed. */
+	const FCachedRoom& GetCachedRoom(const ARoomBounds* RoomBounds, const FTransform& RoomBoundsTransform);
+
+	TMap<TWeakObjectPtr<const ARoomBounds>, FCachedRoom> CachedRooms;
 };
\ No newline at end of file
@@ -29,7 +29,9 @@ public class ReberuEditor : ModuleRules
                 "UMGEditor",
                 "Blutility",
                 "Reberu",
-                "GameplayTags"
+                "GameplayTags",
+                "InputCore",
+                "PropertyEditor"
             }
         );
     }